@@ -17,11 +17,59 @@
  * Cons:
  * - No guarantee request will be handled
  * - Performance concerns with long chains
+ *
+ * Compiled routing: each handler can describe its acceptance test as a
+ * HandlerRule (priority limit, accepted types, amount limits). A
+ * HandlerRouter turns the rules into a table indexed by (priority, type
+ * ID, amount bucket) and finds the accepting handler without walking the
+ * chain. From the first handler whose test can't be described, it falls
+ * back to the normal walk. It recompiles itself after set_next().
+ *
+ * Batch processing: router_process_batch() routes a whole array of
+ * requests, groups them by the handler that accepts them, and hands each
+ * group to that handler's handle_batch() in chunks spread over several
+ * threads. Counters are kept per thread and merged when the batch ends.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for routing microbenchmarks
+ * instead of the demo, and with -DPATTERN_COUNTERS for hot-path counters
+ * (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../bench.h"
+
+HOT_COUNTER(chain_walks, "chain", "chain walks");
+HOT_COUNTER(chain_lookups, "chain", "table lookups");
+HOT_COUNTER(chain_walk_fallbacks, "chain", "lookups sent to the walk");
+HOT_COUNTER(chain_recompiles, "chain", "router recompiles");
+HOT_COUNTER(chain_batches, "chain", "batches");
+HOT_COUNTER(chain_batch_chunks, "chain", "batch chunks handled");
+
+// ---- Request types ----
+
+// Every type name gets a small ID, stored in the request, so routing
+// never compares strings
+#define MAX_REQUEST_TYPES 64
+
+static char request_type_names[MAX_REQUEST_TYPES][50];
+static int request_type_count = 0;
+
+// ID for 'type', adding it the first time; -1 if the table is full.
+// Not thread-safe: intern before starting threads and hand them the IDs.
+int intern_request_type(const char* type) {
+    for (int id = 0; id < request_type_count; id++) {
+        if (strcmp(request_type_names[id], type) == 0) return id;
+    }
+    if (request_type_count == MAX_REQUEST_TYPES) return -1;
+    snprintf(request_type_names[request_type_count], sizeof(request_type_names[0]), "%s", type);
+    return request_type_count++;
+}
 
 // Request structure
 typedef struct {
@@ -30,8 +78,30 @@ typedef struct {
     int priority;      // 1=Low, 2=Medium, 3=High, 4=Critical
     char requester[100];
     double amount;     // For expense requests
+    int type_id;       // intern_request_type(type)
 } Request;
 
+// What a handler accepts, in a form the router can compile:
+// priority <= max_priority and, for the request's type, amount <= limit.
+// Types without their own clause use the "other types" clause.
+#define MAX_RULE_TYPES 8
+
+typedef struct {
+    int max_priority;
+    int type_count;
+    const char* types[MAX_RULE_TYPES];
+    double max_amounts[MAX_RULE_TYPES];  // INFINITY: any amount
+    int type_ids[MAX_RULE_TYPES];        // Filled in by router_compile()
+    int other_types_accepted;
+    double other_max_amount;
+} HandlerRule;
+
+// What one thread did for one handler during a batch
+typedef struct {
+    long handled;
+    double approved_amount;   // Budget requests approved
+} HandlerTally;
+
 // Handler interface
 typedef struct Handler Handler;
 struct Handler {
@@ -40,14 +110,66 @@ struct Handler {
     Handler* next_handler;
     
     void (*handle_request)(Handler* self, Request* request);
+    int (*accepts)(Handler* self, const Request* request);
+    // Fill in 'rule' and return 1, or return 0 if the test can't be
+    // expressed as a rule (NULL means the same)
+    int (*compile_rule)(Handler* self, HandlerRule* rule);
+    // Handle requests this handler accepts, quietly. Runs on worker
+    // threads, so it may only write to 'tally'. NULL: the batch calls
+    // handle_request() for each request instead.
+    void (*handle_batch)(Handler* self, Request** requests, int count, HandlerTally* tally);
+    // Fold a finished tally into the handler's own counters (may be NULL)
+    void (*merge_tally)(Handler* self, const HandlerTally* tally);
+    int batch_slot;           // Group index while a batch runs
+    int approve_type_id;      // Type handler_approve_batch() adds up; interned by the constructor
     void (*set_next)(Handler* self, Handler* next);
     void (*destroy)(Handler* self);
 };
 
+// Bumped by every set_next() so routers know their table is stale
+static unsigned chain_generation = 0;
+
 // Base handler implementation
 void handler_set_next(Handler* self, Handler* next) {
     self->next_handler = next;
-    printf("🔗 Linked %s → %s\n", self->name, next ? next->name : "NULL");
+    chain_generation++;
+    PATTERN_LOG("🔗 Linked %s → %s\n", self->name, next ? next->name : "NULL");
+}
+
+// Rule accepting exactly the listed types, any amount
+static void rule_for_types(HandlerRule* rule, int max_priority, const char* const* types, int count) {
+    rule->max_priority = max_priority;
+    rule->type_count = count;
+    for (int i = 0; i < count; i++) {
+        rule->types[i] = types[i];
+        rule->max_amounts[i] = INFINITY;
+    }
+    rule->other_types_accepted = 0;
+    rule->other_max_amount = INFINITY;
+}
+
+static int type_in_list(const char* type, const char* const* types, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(type, types[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// handle_batch for handlers that only count what they handled
+void handler_count_batch(Handler* self, Request** requests, int count, HandlerTally* tally) {
+    (void)self;
+    (void)requests;
+    tally->handled += count;
+}
+
+// handle_batch for handlers that approve budgets
+void handler_approve_batch(Handler* self, Request** requests, int count, HandlerTally* tally) {
+    for (int i = 0; i < count; i++) {
+        if (requests[i]->type_id == self->approve_type_id) {
+            tally->approved_amount += requests[i]->amount;
+        }
+    }
+    tally->handled += count;
 }
 
 // Concrete Handler 1: Help Desk Agent
@@ -56,6 +178,21 @@ typedef struct {
     int tickets_handled_today;
 } HelpDeskAgent;
 
+static const char* const help_desk_types[] = {"password_reset", "software_install", "basic_support"};
+
+int help_desk_accepts(Handler* self, const Request* request) {
+    return request->priority <= self->max_priority && type_in_list(request->type, help_desk_types, 3);
+}
+
+int help_desk_compile_rule(Handler* self, HandlerRule* rule) {
+    rule_for_types(rule, self->max_priority, help_desk_types, 3);
+    return 1;
+}
+
+void help_desk_merge_tally(Handler* self, const HandlerTally* tally) {
+    ((HelpDeskAgent*)self)->tickets_handled_today += (int)tally->handled;
+}
+
 void help_desk_handle_request(Handler* self, Request* request) {
     HelpDeskAgent* agent = (HelpDeskAgent*)self;
     
@@ -65,11 +202,7 @@ void help_desk_handle_request(Handler* self, Request* request) {
     printf("   Priority: %d\n", request->priority);
     printf("   Requester: %s\n", request->requester);
     
-    if (request->priority <= self->max_priority && 
-        (strcmp(request->type, "password_reset") == 0 || 
-         strcmp(request->type, "software_install") == 0 ||
-         strcmp(request->type, "basic_support") == 0)) {
-        
+    if (help_desk_accepts(self, request)) {
         printf("✅ %s handled the request\n", self->name);
         printf("   Solution: Basic troubleshooting steps provided\n");
         agent->tickets_handled_today++;
@@ -99,9 +232,14 @@ Handler* create_help_desk_agent(const char* name) {
     strcpy(agent->base.name, name);
     agent->base.max_priority = 2; // Can handle Low and Medium priority
     agent->base.next_handler = NULL;
+    agent->base.approve_type_id = -1;
     agent->tickets_handled_today = 0;
     
     agent->base.handle_request = help_desk_handle_request;
+    agent->base.accepts = help_desk_accepts;
+    agent->base.compile_rule = help_desk_compile_rule;
+    agent->base.handle_batch = handler_count_batch;
+    agent->base.merge_tally = help_desk_merge_tally;
     agent->base.set_next = handler_set_next;
     agent->base.destroy = help_desk_destroy;
     
@@ -114,6 +252,17 @@ typedef struct {
     int servers_managed;
 } SystemAdministrator;
 
+static const char* const sysadmin_types[] = {"server_issue", "network_problem", "database_access", "software_install"};
+
+int sysadmin_accepts(Handler* self, const Request* request) {
+    return request->priority <= self->max_priority && type_in_list(request->type, sysadmin_types, 4);
+}
+
+int sysadmin_compile_rule(Handler* self, HandlerRule* rule) {
+    rule_for_types(rule, self->max_priority, sysadmin_types, 4);
+    return 1;
+}
+
 void sysadmin_handle_request(Handler* self, Request* request) {
     SystemAdministrator* sysadmin = (SystemAdministrator*)self;
     
@@ -122,12 +271,7 @@ void sysadmin_handle_request(Handler* self, Request* request) {
     printf("   Description: %s\n", request->description);
     printf("   Priority: %d\n", request->priority);
     
-    if (request->priority <= self->max_priority && 
-        (strcmp(request->type, "server_issue") == 0 || 
-         strcmp(request->type, "network_problem") == 0 ||
-         strcmp(request->type, "database_access") == 0 ||
-         strcmp(request->type, "software_install") == 0)) {
-        
+    if (sysadmin_accepts(self, request)) {
         printf("✅ %s handled the request\n", self->name);
         printf("   Solution: System-level troubleshooting completed\n");
         printf("   Servers managed: %d\n", sysadmin->servers_managed);
@@ -156,9 +300,14 @@ Handler* create_system_administrator(const char* name) {
     strcpy(sysadmin->base.name, name);
     sysadmin->base.max_priority = 3; // Can handle Low, Medium, and High priority
     sysadmin->base.next_handler = NULL;
+    sysadmin->base.approve_type_id = -1;
     sysadmin->servers_managed = 25;
     
     sysadmin->base.handle_request = sysadmin_handle_request;
+    sysadmin->base.accepts = sysadmin_accepts;
+    sysadmin->base.compile_rule = sysadmin_compile_rule;
+    sysadmin->base.handle_batch = handler_count_batch;
+    sysadmin->base.merge_tally = NULL;
     sysadmin->base.set_next = handler_set_next;
     sysadmin->base.destroy = sysadmin_destroy;
     
@@ -169,8 +318,31 @@ Handler* create_system_administrator(const char* name) {
 typedef struct {
     Handler base;
     double budget_authority;
+    double approved_today;
 } ITManager;
 
+// Anything within priority, except budgets over the authority
+int it_manager_accepts(Handler* self, const Request* request) {
+    ITManager* manager = (ITManager*)self;
+    if (request->priority > self->max_priority) return 0;
+    return strcmp(request->type, "budget_approval") != 0 || request->amount <= manager->budget_authority;
+}
+
+int it_manager_compile_rule(Handler* self, HandlerRule* rule) {
+    ITManager* manager = (ITManager*)self;
+    rule->max_priority = self->max_priority;
+    rule->type_count = 1;
+    rule->types[0] = "budget_approval";
+    rule->max_amounts[0] = manager->budget_authority;
+    rule->other_types_accepted = 1;
+    rule->other_max_amount = INFINITY;
+    return 1;
+}
+
+void it_manager_merge_tally(Handler* self, const HandlerTally* tally) {
+    ((ITManager*)self)->approved_today += tally->approved_amount;
+}
+
 void it_manager_handle_request(Handler* self, Request* request) {
     ITManager* manager = (ITManager*)self;
     
@@ -185,6 +357,7 @@ void it_manager_handle_request(Handler* self, Request* request) {
     if (request->priority <= self->max_priority) {
         if (strcmp(request->type, "budget_approval") == 0) {
             if (request->amount <= manager->budget_authority) {
+                manager->approved_today += request->amount;
                 printf("✅ %s approved the budget request\n", self->name);
                 printf("   Approved amount: $%.2f (within authority: $%.2f)\n", 
                        request->amount, manager->budget_authority);
@@ -223,9 +396,15 @@ Handler* create_it_manager(const char* name, double budget_authority) {
     strcpy(manager->base.name, name);
     manager->base.max_priority = 4; // Can handle all priorities
     manager->base.next_handler = NULL;
+    manager->base.approve_type_id = intern_request_type("budget_approval");
     manager->budget_authority = budget_authority;
-    
+    manager->approved_today = 0.0;
+
     manager->base.handle_request = it_manager_handle_request;
+    manager->base.accepts = it_manager_accepts;
+    manager->base.compile_rule = it_manager_compile_rule;
+    manager->base.handle_batch = handler_approve_batch;
+    manager->base.merge_tally = it_manager_merge_tally;
     manager->base.set_next = handler_set_next;
     manager->base.destroy = it_manager_destroy;
     
@@ -236,8 +415,27 @@ Handler* create_it_manager(const char* name, double budget_authority) {
 typedef struct {
     Handler base;
     double budget_authority;
+    double approved_today;
 } CTO;
 
+int cto_accepts(Handler* self, const Request* request) {
+    (void)self;
+    (void)request;
+    return 1;
+}
+
+int cto_compile_rule(Handler* self, HandlerRule* rule) {
+    rule->max_priority = self->max_priority;
+    rule->type_count = 0;
+    rule->other_types_accepted = 1;
+    rule->other_max_amount = INFINITY;
+    return 1;
+}
+
+void cto_merge_tally(Handler* self, const HandlerTally* tally) {
+    ((CTO*)self)->approved_today += tally->approved_amount;
+}
+
 void cto_handle_request(Handler* self, Request* request) {
     CTO* cto = (CTO*)self;
     
@@ -252,6 +450,7 @@ void cto_handle_request(Handler* self, Request* request) {
     // CTO can handle anything
     printf("✅ %s handled the critical request\n", self->name);
     if (strcmp(request->type, "budget_approval") == 0) {
+        cto->approved_today += request->amount;
         printf("   Executive approval granted for $%.2f\n", request->amount);
     } else {
         printf("   Executive decision made - all resources allocated\n");
@@ -271,15 +470,81 @@ Handler* create_cto(const char* name) {
     strcpy(cto->base.name, name);
     cto->base.max_priority = 4; // Can handle all priorities
     cto->base.next_handler = NULL;
+    cto->base.approve_type_id = intern_request_type("budget_approval");
     cto->budget_authority = 1000000.0; // $1M authority
-    
+    cto->approved_today = 0.0;
+
     cto->base.handle_request = cto_handle_request;
+    cto->base.accepts = cto_accepts;
+    cto->base.compile_rule = cto_compile_rule;
+    cto->base.handle_batch = handler_approve_batch;
+    cto->base.merge_tally = cto_merge_tally;
     cto->base.set_next = handler_set_next;
     cto->base.destroy = cto_destroy;
     
     return (Handler*)cto;
 }
 
+// Concrete Handler 5: On-Call Engineer
+// Picks up anything that mentions an outage. That test reads free text,
+// so it has no HandlerRule and the router walks the chain from here.
+typedef struct {
+    Handler base;
+    int pages_answered;
+} OnCallEngineer;
+
+int on_call_accepts(Handler* self, const Request* request) {
+    (void)self;
+    return strstr(request->description, "outage") != NULL;
+}
+
+void on_call_handle_request(Handler* self, Request* request) {
+    OnCallEngineer* engineer = (OnCallEngineer*)self;
+    
+    printf("\n📟 %s received request:\n", self->name);
+    printf("   Description: %s\n", request->description);
+    
+    if (on_call_accepts(self, request)) {
+        engineer->pages_answered++;
+        printf("✅ %s is on it (page #%d)\n", self->name, engineer->pages_answered);
+    } else if (self->next_handler) {
+        printf("🔄 Not an outage, passing to %s\n", self->next_handler->name);
+        self->next_handler->handle_request(self->next_handler, request);
+    } else {
+        printf("❌ No more handlers in chain - request cannot be processed\n");
+    }
+}
+
+void on_call_merge_tally(Handler* self, const HandlerTally* tally) {
+    ((OnCallEngineer*)self)->pages_answered += (int)tally->handled;
+}
+
+void on_call_destroy(Handler* self) {
+    if (self) {
+        free(self);
+    }
+}
+
+Handler* create_on_call_engineer(const char* name) {
+    OnCallEngineer* engineer = (OnCallEngineer*)malloc(sizeof(OnCallEngineer));
+    
+    strcpy(engineer->base.name, name);
+    engineer->base.max_priority = 4;
+    engineer->base.next_handler = NULL;
+    engineer->base.approve_type_id = -1;
+    engineer->pages_answered = 0;
+    
+    engineer->base.handle_request = on_call_handle_request;
+    engineer->base.accepts = on_call_accepts;
+    engineer->base.compile_rule = NULL;
+    engineer->base.handle_batch = handler_count_batch;
+    engineer->base.merge_tally = on_call_merge_tally;
+    engineer->base.set_next = handler_set_next;
+    engineer->base.destroy = on_call_destroy;
+    
+    return (Handler*)engineer;
+}
+
 // Helper functions
 Request create_request(const char* type, const char* description, int priority, 
                       const char* requester, double amount) {
@@ -289,9 +554,351 @@ Request create_request(const char* type, const char* description, int priority,
     request.priority = priority;
     strcpy(request.requester, requester);
     request.amount = amount;
+    request.type_id = intern_request_type(type);
     return request;
 }
 
+// The handler that accepts 'request', walking with accepts() (no output)
+Handler* chain_find_handler(Handler* first, const Request* request) {
+    COUNTER_ADD(chain_walks, 1);
+    for (Handler* current = first; current; current = current->next_handler) {
+        if (current->accepts(current, request)) return current;
+    }
+    return NULL;
+}
+
+// ---- Compiled router ----
+
+#define ROUTER_PRIORITIES 4    // Requests outside 1..4 take the linear walk
+#define MAX_ROUTED_HANDLERS 16
+#define MAX_THRESHOLDS (MAX_ROUTED_HANDLERS * (MAX_RULE_TYPES + 1))
+
+typedef struct {
+    Handler* first;
+    unsigned generation;        // chain_generation when compiled
+    int compiled_handlers;      // Handlers from 'first' covered by rules
+    Handler* walk_from;         // First handler without a rule, or NULL
+    // Type IDs below type_columns have their own column; the rest share
+    // the last one ("no clause mentions this type")
+    int type_columns;
+    // Amount bucket b holds amounts in (thresholds[b-1], thresholds[b]];
+    // the last bucket holds everything above every threshold
+    double thresholds[MAX_THRESHOLDS];
+    int threshold_count;
+    Handler** table;            // [priority - 1][type column][amount bucket]
+    long routed;                // Requests answered from the table
+    long walked;                // Requests that needed the linear walk
+} HandlerRouter;
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static int rule_accepts(const HandlerRule* rule, int priority, int type_id, double amount) {
+    if (priority > rule->max_priority) return 0;
+    for (int i = 0; i < rule->type_count; i++) {
+        if (rule->type_ids[i] == type_id) return amount <= rule->max_amounts[i];
+    }
+    return rule->other_types_accepted && amount <= rule->other_max_amount;
+}
+
+// Build the table for the chain starting at router->first
+void router_compile(HandlerRouter* router) {
+    HandlerRule rules[MAX_ROUTED_HANDLERS];
+    Handler* handlers[MAX_ROUTED_HANDLERS];
+    int count = 0;
+    Handler* current = router->first;
+    COUNTER_ADD(chain_recompiles, 1);
+    while (current && count < MAX_ROUTED_HANDLERS &&
+           current->compile_rule && current->compile_rule(current, &rules[count])) {
+        handlers[count++] = current;
+        current = current->next_handler;
+    }
+    router->compiled_handlers = count;
+    router->walk_from = current;
+    
+    // Intern every type the rules mention, and collect the amount limits
+    router->threshold_count = 0;
+    for (int h = 0; h < count; h++) {
+        for (int i = 0; i < rules[h].type_count; i++) {
+            rules[h].type_ids[i] = intern_request_type(rules[h].types[i]);
+            if (isfinite(rules[h].max_amounts[i])) {
+                router->thresholds[router->threshold_count++] = rules[h].max_amounts[i];
+            }
+        }
+        if (isfinite(rules[h].other_max_amount)) {
+            router->thresholds[router->threshold_count++] = rules[h].other_max_amount;
+        }
+    }
+    qsort(router->thresholds, router->threshold_count, sizeof(double), compare_doubles);
+    int unique = 0;
+    for (int i = 0; i < router->threshold_count; i++) {
+        if (unique == 0 || router->thresholds[i] != router->thresholds[unique - 1]) {
+            router->thresholds[unique++] = router->thresholds[i];
+        }
+    }
+    router->threshold_count = unique;
+    router->type_columns = request_type_count;
+    
+    // Every cell: run the rules in chain order on a representative request
+    int columns = router->type_columns + 1;
+    int buckets = router->threshold_count + 1;
+    free(router->table);
+    router->table = (Handler**)malloc(ROUTER_PRIORITIES * columns * buckets * sizeof(Handler*));
+    for (int p = 0; p < ROUTER_PRIORITIES; p++) {
+        for (int c = 0; c < columns; c++) {
+            for (int b = 0; b < buckets; b++) {
+                double amount = b < router->threshold_count ? router->thresholds[b] : INFINITY;
+                Handler* target = router->walk_from;
+                for (int h = 0; h < count; h++) {
+                    // The shared column stands for a type no clause names
+                    int type_id = c < router->type_columns ? c : -1;
+                    if (rule_accepts(&rules[h], p + 1, type_id, amount)) {
+                        target = handlers[h];
+                        break;
+                    }
+                }
+                router->table[(p * columns + c) * buckets + b] = target;
+            }
+        }
+    }
+    router->generation = chain_generation;
+}
+
+HandlerRouter* create_router(Handler* first) {
+    HandlerRouter* router = (HandlerRouter*)calloc(1, sizeof(HandlerRouter));
+    router->first = first;
+    router_compile(router);
+    return router;
+}
+
+// Table lookup with no side effects, safe from several threads once the
+// table is current. Sets *walked when the answer isn't the acceptor itself.
+static Handler* router_lookup(HandlerRouter* router, const Request* request, int* walked) {
+    COUNTER_ADD(chain_lookups, 1);
+    if (request->priority < 1 || request->priority > ROUTER_PRIORITIES || isnan(request->amount)) {
+        *walked = 1;
+        COUNTER_ADD(chain_walk_fallbacks, 1);
+        return chain_find_handler(router->first, request);
+    }
+
+    int column = request->type_id >= 0 && request->type_id < router->type_columns
+               ? request->type_id : router->type_columns;
+    // Thresholds are few, so a short binary search finds the bucket
+    int low = 0, high = router->threshold_count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (request->amount <= router->thresholds[mid]) high = mid; else low = mid + 1;
+    }
+    int buckets = router->threshold_count + 1;
+    Handler* target = router->table[((request->priority - 1) * (router->type_columns + 1) + column) * buckets + low];
+    *walked = target && target == router->walk_from;
+    COUNTER_ADD(chain_walk_fallbacks, *walked);
+    return target;
+}
+
+// Handler to give 'request' to: the one that accepts it, or the handler
+// to start walking from when the chain isn't fully compiled. NULL if
+// nobody will take it.
+Handler* router_route(HandlerRouter* router, const Request* request) {
+    if (router->generation != chain_generation) {
+        router_compile(router);
+    }
+    int walked;
+    Handler* target = router_lookup(router, request, &walked);
+    if (walked) router->walked++; else router->routed++;
+    return target;
+}
+
+// Route and handle: the accepting handler handles it straight away
+void router_dispatch(HandlerRouter* router, Request* request) {
+    Handler* target = router_route(router, request);
+    if (target) {
+        target->handle_request(target, request);
+    } else {
+        printf("\n❌ No handler accepts this request\n");
+    }
+}
+
+void destroy_router(HandlerRouter* router) {
+    if (router) {
+        free(router->table);
+        free(router);
+    }
+}
+
+// ---- Batch processing ----
+
+#define BATCH_CHUNK 4096        // Requests per work item
+#define MAX_BATCH_THREADS 64
+
+typedef struct {
+    int slot;
+    int start;
+    int count;
+} BatchItem;
+
+typedef struct {
+    HandlerRouter* router;
+    Request* requests;
+    int count;
+    Handler** handlers;         // Chain order; handlers[i]->batch_slot == i
+    int handler_count;          // Slot handler_count collects unhandled requests
+    int* slots;                 // slots[i]: group of requests[i]
+    Request** grouped;          // Requests ordered by group
+    int* group_start;           // handler_count + 2 offsets into 'grouped'
+    BatchItem* items;
+    int item_count;
+    atomic_int next_item;
+    HandlerTally* tallies;      // [thread * handler_count + slot]
+    long* walked;               // Per thread
+    int thread_count;
+} BatchRun;
+
+typedef struct {
+    BatchRun* run;
+    int thread;
+} BatchWorker;
+
+// Phase 1: each thread finds the group of every request in its share.
+// Requests routed to the walk are walked from there to their acceptor.
+static void* batch_route_worker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchRun* run = worker->run;
+    int start = (int)((long)run->count * worker->thread / run->thread_count);
+    int end = (int)((long)run->count * (worker->thread + 1) / run->thread_count);
+    long walked = 0;
+    for (int i = start; i < end; i++) {
+        int was_walked;
+        Handler* target = router_lookup(run->router, &run->requests[i], &was_walked);
+        if (was_walked && target) target = chain_find_handler(target, &run->requests[i]);
+        walked += was_walked;
+        run->slots[i] = target ? target->batch_slot : run->handler_count;
+    }
+    run->walked[worker->thread] = walked;
+    return NULL;
+}
+
+// Phase 2: claim chunks of groups until none are left
+static void* batch_handle_worker(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchRun* run = worker->run;
+    HandlerTally* tallies = run->tallies + worker->thread * run->handler_count;
+    int item;
+    while ((item = atomic_fetch_add(&run->next_item, 1)) < run->item_count) {
+        BatchItem* work = &run->items[item];
+        Handler* handler = run->handlers[work->slot];
+        COUNTER_ADD(chain_batch_chunks, 1);
+        handler->handle_batch(handler, run->grouped + work->start, work->count, &tallies[work->slot]);
+    }
+    return NULL;
+}
+
+// Run 'phase' on every thread, the calling thread included
+static void batch_run_phase(BatchRun* run, void* (*phase)(void*)) {
+    pthread_t threads[MAX_BATCH_THREADS];
+    BatchWorker workers[MAX_BATCH_THREADS];
+    for (int t = 0; t < run->thread_count; t++) {
+        workers[t].run = run;
+        workers[t].thread = t;
+    }
+    for (int t = 1; t < run->thread_count; t++) {
+        pthread_create(&threads[t], NULL, phase, &workers[t]);
+    }
+    phase(&workers[0]);
+    for (int t = 1; t < run->thread_count; t++) {
+        pthread_join(threads[t], NULL);
+    }
+}
+
+// Route and handle 'count' requests using up to 'threads' threads. Each
+// handler sees its requests grouped together. The chain must not change
+// while the batch runs.
+void router_process_batch(HandlerRouter* router, Request* requests, int count, int threads) {
+    if (router->generation != chain_generation) {
+        router_compile(router);
+    }
+    COUNTER_ADD(chain_batches, 1);
+    BatchRun run = {0};
+    run.router = router;
+    run.requests = requests;
+    run.count = count;
+    run.thread_count = threads < 1 ? 1 : threads > MAX_BATCH_THREADS ? MAX_BATCH_THREADS : threads;
+    
+    for (Handler* h = router->first; h; h = h->next_handler) run.handler_count++;
+    run.handlers = (Handler**)malloc((run.handler_count + 1) * sizeof(Handler*));
+    int slot = 0;
+    for (Handler* h = router->first; h; h = h->next_handler) {
+        h->batch_slot = slot;
+        run.handlers[slot++] = h;
+    }
+    
+    run.slots = (int*)malloc((count ? count : 1) * sizeof(int));
+    run.walked = (long*)calloc(run.thread_count, sizeof(long));
+    batch_run_phase(&run, batch_route_worker);
+    
+    // Group by handler (counting sort keeps each group in request order)
+    int groups = run.handler_count + 1;
+    run.group_start = (int*)calloc(groups + 1, sizeof(int));
+    for (int i = 0; i < count; i++) run.group_start[run.slots[i] + 1]++;
+    for (int g = 0; g < groups; g++) run.group_start[g + 1] += run.group_start[g];
+    int* fill = (int*)malloc(groups * sizeof(int));
+    memcpy(fill, run.group_start, groups * sizeof(int));
+    run.grouped = (Request**)malloc((count ? count : 1) * sizeof(Request*));
+    for (int i = 0; i < count; i++) run.grouped[fill[run.slots[i]]++] = &requests[i];
+    free(fill);
+    
+    // Work items: chunks of every group whose handler can take a batch
+    run.items = (BatchItem*)malloc((count / BATCH_CHUNK + groups) * sizeof(BatchItem));
+    for (int g = 0; g < run.handler_count; g++) {
+        if (!run.handlers[g]->handle_batch) continue;
+        int end = run.group_start[g + 1];
+        for (int start = run.group_start[g]; start < end; start += BATCH_CHUNK) {
+            BatchItem item = {g, start, end - start < BATCH_CHUNK ? end - start : BATCH_CHUNK};
+            run.items[run.item_count++] = item;
+        }
+    }
+    run.tallies = (HandlerTally*)calloc(run.thread_count * run.handler_count, sizeof(HandlerTally));
+    atomic_init(&run.next_item, 0);
+    batch_run_phase(&run, batch_handle_worker);
+    
+    // Handlers without handle_batch get their requests one at a time here
+    for (int g = 0; g < run.handler_count; g++) {
+        if (run.handlers[g]->handle_batch) continue;
+        for (int i = run.group_start[g]; i < run.group_start[g + 1]; i++) {
+            run.handlers[g]->handle_request(run.handlers[g], run.grouped[i]);
+        }
+    }
+    
+    PATTERN_LOG("\n📦 Batch of %d requests on %d threads:\n", count, run.thread_count);
+    for (int g = 0; g < run.handler_count; g++) {
+        double approved = 0.0;
+        for (int t = 0; t < run.thread_count; t++) {
+            HandlerTally* tally = &run.tallies[t * run.handler_count + g];
+            if (run.handlers[g]->merge_tally) run.handlers[g]->merge_tally(run.handlers[g], tally);
+            approved += tally->approved_amount;
+        }
+        PATTERN_LOG("   %s: %d requests", run.handlers[g]->name, run.group_start[g + 1] - run.group_start[g]);
+        if (approved > 0) PATTERN_LOG(", $%.2f approved", approved);
+        PATTERN_LOG("\n");
+    }
+    PATTERN_LOG("   Unhandled: %d requests\n", run.group_start[groups] - run.group_start[groups - 1]);
+    
+    long walked = 0;
+    for (int t = 0; t < run.thread_count; t++) walked += run.walked[t];
+    router->walked += walked;
+    router->routed += count - walked;
+    
+    free(run.handlers);
+    free(run.slots);
+    free(run.walked);
+    free(run.group_start);
+    free(run.grouped);
+    free(run.items);
+    free(run.tallies);
+}
+
 void print_chain_structure(Handler* first) {
     printf("\n🔗 Chain Structure:\n");
     Handler* current = first;
@@ -304,6 +911,85 @@ void print_chain_structure(Handler* first) {
     printf("\n");
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_TICKETS 1000000
+
+typedef struct {
+    Handler* first;
+    HandlerRouter* router;
+    Request* tickets;
+    int threads;
+} RouteBench;
+
+static void bench_chain_walk(void* arg) {
+    RouteBench* bench = (RouteBench*)arg;
+    for (int i = 0; i < BENCH_TICKETS; i++) {
+        bench_consume((uintptr_t)chain_find_handler(bench->first, &bench->tickets[i]));
+    }
+}
+
+static void bench_router_route(void* arg) {
+    RouteBench* bench = (RouteBench*)arg;
+    for (int i = 0; i < BENCH_TICKETS; i++) {
+        bench_consume((uintptr_t)router_route(bench->router, &bench->tickets[i]));
+    }
+}
+
+static void bench_process_batch(void* arg) {
+    RouteBench* bench = (RouteBench*)arg;
+    router_process_batch(bench->router, bench->tickets, BENCH_TICKETS, bench->threads);
+}
+
+int main() {
+    bench_header("Chain routing");
+    
+    Handler* help_desk = create_help_desk_agent("Help Desk Agent");
+    Handler* sysadmin = create_system_administrator("System Administrator");
+    Handler* it_manager = create_it_manager("IT Manager", 10000.0);
+    Handler* cto = create_cto("Chief Technology Officer");
+    help_desk->set_next(help_desk, sysadmin);
+    sysadmin->set_next(sysadmin, it_manager);
+    it_manager->set_next(it_manager, cto);
+    
+    // The demo's ticket mix: eight types, priorities 1-4, budget amounts
+    const char* types[] = {"password_reset", "software_install", "server_issue", "budget_approval",
+                           "security_breach", "policy_change", "basic_support", "network_problem"};
+    RouteBench bench;
+    bench.first = help_desk;
+    bench.router = create_router(help_desk);
+    bench.tickets = (Request*)malloc(BENCH_TICKETS * sizeof(Request));
+    unsigned seed = 2024;
+    for (int i = 0; i < BENCH_TICKETS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const char* type = types[(seed >> 16) % 8];
+        strcpy(bench.tickets[i].type, type);
+        bench.tickets[i].type_id = intern_request_type(type);
+        bench.tickets[i].priority = 1 + (seed >> 8) % 4;
+        bench.tickets[i].amount = strcmp(type, "budget_approval") == 0 ? (seed >> 4) % 20000 : 0;
+        strcpy(bench.tickets[i].description, "Routine ticket");
+    }
+    counters_reset();
+    
+    bench_run("chain_find_handler walk (per ticket)", bench_chain_walk, &bench, BENCH_TICKETS);
+    bench_run("router_route table lookup (per ticket)", bench_router_route, &bench, BENCH_TICKETS);
+    bench.threads = 1;
+    bench_run("router_process_batch, 1 thread (per ticket)", bench_process_batch, &bench, BENCH_TICKETS);
+    bench.threads = 4;
+    bench_run("router_process_batch, 4 threads (per ticket)", bench_process_batch, &bench, BENCH_TICKETS);
+    
+    counters_report();
+    
+    free(bench.tickets);
+    destroy_router(bench.router);
+    help_desk->destroy(help_desk);
+    sysadmin->destroy(sysadmin);
+    it_manager->destroy(it_manager);
+    cto->destroy(cto);
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== CHAIN OF RESPONSIBILITY PATTERN EXAMPLE ===\n\n");
@@ -369,11 +1055,95 @@ int main() {
     Request req7 = create_request("server_issue", "Another server problem", 3, "ops.team@company.com", 0);
     help_desk->handle_request(help_desk, &req7);
     
+    printf("\n--- Compiled routing ---\n");
+    help_desk->set_next(help_desk, sysadmin);
+    HandlerRouter* router = create_router(help_desk);
+    printf("Router: %d handlers compiled, %d types, %d amount buckets\n",
+           router->compiled_handlers, router->type_columns, router->threshold_count + 1);
+    
+    // Straight to the System Administrator, no escalation
+    printf("=== REQUEST 8 (Routed) ===");
+    Request req8 = create_request("network_problem", "VPN drops every hour", 2, "remote.worker@company.com", 0);
+    router_dispatch(router, &req8);
+    
+    // A million tickets: compare the table against walking the chain
+    const char* types[] = {"password_reset", "software_install", "server_issue", "budget_approval",
+                           "security_breach", "policy_change", "basic_support", "network_problem"};
+    int ticket_count = 1000000;
+    Request* tickets = (Request*)malloc(ticket_count * sizeof(Request));
+    unsigned seed = 2024;
+    for (int i = 0; i < ticket_count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        tickets[i].type_id = intern_request_type(types[(seed >> 16) % 8]);
+        strcpy(tickets[i].type, types[(seed >> 16) % 8]);
+        tickets[i].priority = 1 + (seed >> 8) % 4;
+        tickets[i].amount = (seed >> 4) % 20000;
+        tickets[i].description[0] = '\0';
+    }
+    struct timespec start, end;
+    long mismatches = 0;
+    Handler** walked = (Handler**)malloc(ticket_count * sizeof(Handler*));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < ticket_count; i++) {
+        walked[i] = chain_find_handler(help_desk, &tickets[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double walk_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < ticket_count; i++) {
+        mismatches += router_route(router, &tickets[i]) != walked[i];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double route_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("%d tickets: chain walk %.1f ms, routing table %.1f ms, %ld mismatches\n",
+           ticket_count, walk_ms, route_ms, mismatches);
+    free(walked);
+    free(tickets);
+    
+    // A handler without a rule: the table stops there and the walk takes over
+    Handler* on_call = create_on_call_engineer("On-Call Engineer");
+    sysadmin->set_next(sysadmin, on_call);
+    on_call->set_next(on_call, it_manager);
+    router_route(router, &req8);  // Notices the chain changed and recompiles
+    printf("Router: %d handlers compiled, walking from %s\n",
+           router->compiled_handlers, router->walk_from ? router->walk_from->name : "nobody");
+    
+    printf("=== REQUEST 9 (Routed to the walk) ===");
+    Request req9 = create_request("security_breach", "Login outage in EU region", 4, "noc@company.com", 0);
+    router_dispatch(router, &req9);
+    
+    printf("\n--- Batch processing ---\n");
+    int batch_size = 1000000;
+    Request* batch = (Request*)malloc(batch_size * sizeof(Request));
+    for (int i = 0; i < batch_size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const char* type = types[(seed >> 16) % 8];
+        strcpy(batch[i].type, type);
+        batch[i].type_id = intern_request_type(type);
+        batch[i].priority = 1 + (seed >> 8) % 4;
+        batch[i].amount = strcmp(type, "budget_approval") == 0 ? (seed >> 4) % 20000 : 0;
+        strcpy(batch[i].description, i % 100 == 0 ? "Partial outage" : "Routine ticket");
+    }
+    HelpDeskAgent* agent = (HelpDeskAgent*)help_desk;
+    int tickets_before = agent->tickets_handled_today;
+    double approved_before = ((ITManager*)it_manager)->approved_today;  // Single requests so far
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    router_process_batch(router, batch, batch_size, 4);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("⏱️  Batch took %.1f ms\n", (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    printf("Help desk tickets today: %d → %d, IT Manager approved today: $%.2f → $%.2f\n",
+           tickets_before, agent->tickets_handled_today, approved_before,
+           ((ITManager*)it_manager)->approved_today);
+    free(batch);
+    
     // Cleanup
+    destroy_router(router);
     help_desk->destroy(help_desk);
     sysadmin->destroy(sysadmin);
     it_manager->destroy(it_manager);
     cto->destroy(cto);
+    on_call->destroy(on_call);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
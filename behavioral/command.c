@@ -20,11 +20,32 @@
  * Cons:
  * - Increased number of classes
  * - Indirection between sender and receiver
+ *
+ * Storage: the editor keeps its text in a pluggable TextStorage backend.
+ * A gap buffer makes edits near the previous edit cheap; a piece table
+ * never moves existing text and suits large files. Both track the length,
+ * so no operation has to strlen() the document.
+ *
+ * Batching: a BatchCommand runs several commands as one undoable unit, and
+ * the CommandManager can coalesce adjacent inserts/deletes (typing,
+ * backspacing) into the previous history entry within a size/time window.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for execute/undo microbenchmarks
+ * instead of the demo, and with -DPATTERN_COUNTERS for hot-path counters
+ * (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "../bench.h"
+
+HOT_COUNTER(command_executed, "command", "executed");
+HOT_COUNTER(command_coalesced, "command", "coalesced into previous");
+HOT_COUNTER(command_undone, "command", "undone");
+HOT_COUNTER(command_redone, "command", "redone");
+HOT_COUNTER(command_chunks, "command", "arena chunks allocated");
 
 // Forward declarations
 typedef struct Command Command;
@@ -38,11 +59,269 @@ struct Command {
     void (*destroy)(Command* self);
 };
 
+// Storage backend interface used by the editor
+typedef struct TextStorage TextStorage;
+struct TextStorage {
+    char name[32];
+    void (*insert)(TextStorage* self, int position, const char* text, int length);
+    void (*erase)(TextStorage* self, int start, int length);
+    void (*extract)(TextStorage* self, int start, int length, char* out);
+    int (*length)(TextStorage* self);
+    void (*destroy)(TextStorage* self);
+};
+
+// Gap buffer: text before the gap, free space, text after the gap.
+// Inserting or deleting at the gap is O(1); moving the gap costs the distance.
+typedef struct {
+    TextStorage base;
+    char* buffer;
+    int capacity;
+    int gap_start;
+    int gap_end;
+} GapBuffer;
+
+static void gap_buffer_move_gap(GapBuffer* gb, int position) {
+    if (position < gb->gap_start) {
+        int count = gb->gap_start - position;
+        memmove(gb->buffer + gb->gap_end - count, gb->buffer + position, count);
+        gb->gap_start -= count;
+        gb->gap_end -= count;
+    } else if (position > gb->gap_start) {
+        int count = position - gb->gap_start;
+        memmove(gb->buffer + gb->gap_start, gb->buffer + gb->gap_end, count);
+        gb->gap_start += count;
+        gb->gap_end += count;
+    }
+}
+
+static void gap_buffer_reserve(GapBuffer* gb, int needed) {
+    int gap = gb->gap_end - gb->gap_start;
+    if (gap >= needed) return;
+
+    int used = gb->capacity - gap;
+    int new_capacity = gb->capacity * 2;
+    while (new_capacity - used < needed) new_capacity *= 2;
+
+    char* buffer = (char*)malloc(new_capacity);
+    int tail = gb->capacity - gb->gap_end;
+    memcpy(buffer, gb->buffer, gb->gap_start);
+    memcpy(buffer + new_capacity - tail, gb->buffer + gb->gap_end, tail);
+    free(gb->buffer);
+    gb->buffer = buffer;
+    gb->gap_end = new_capacity - tail;
+    gb->capacity = new_capacity;
+}
+
+void gap_buffer_insert(TextStorage* self, int position, const char* text, int length) {
+    GapBuffer* gb = (GapBuffer*)self;
+    gap_buffer_reserve(gb, length);
+    gap_buffer_move_gap(gb, position);
+    memcpy(gb->buffer + gb->gap_start, text, length);
+    gb->gap_start += length;
+}
+
+void gap_buffer_erase(TextStorage* self, int start, int length) {
+    GapBuffer* gb = (GapBuffer*)self;
+    gap_buffer_move_gap(gb, start);
+    gb->gap_end += length;
+}
+
+void gap_buffer_extract(TextStorage* self, int start, int length, char* out) {
+    GapBuffer* gb = (GapBuffer*)self;
+    int before = 0;
+    if (start < gb->gap_start) {
+        before = gb->gap_start - start;
+        if (before > length) before = length;
+        memcpy(out, gb->buffer + start, before);
+    }
+    int after_start = start + before;  // Logical position of the rest
+    memcpy(out + before, gb->buffer + gb->gap_end + (after_start - gb->gap_start), length - before);
+}
+
+int gap_buffer_length(TextStorage* self) {
+    GapBuffer* gb = (GapBuffer*)self;
+    return gb->capacity - (gb->gap_end - gb->gap_start);
+}
+
+void gap_buffer_destroy(TextStorage* self) {
+    GapBuffer* gb = (GapBuffer*)self;
+    if (gb) {
+        free(gb->buffer);
+        free(gb);
+    }
+}
+
+TextStorage* create_gap_buffer_storage(int initial_capacity) {
+    GapBuffer* gb = (GapBuffer*)malloc(sizeof(GapBuffer));
+    
+    strcpy(gb->base.name, "Gap Buffer");
+    gb->capacity = initial_capacity > 16 ? initial_capacity : 16;
+    gb->buffer = (char*)malloc(gb->capacity);
+    gb->gap_start = 0;
+    gb->gap_end = gb->capacity;
+    
+    gb->base.insert = gap_buffer_insert;
+    gb->base.erase = gap_buffer_erase;
+    gb->base.extract = gap_buffer_extract;
+    gb->base.length = gap_buffer_length;
+    gb->base.destroy = gap_buffer_destroy;
+    
+    return (TextStorage*)gb;
+}
+
+// Piece table: the document is a list of spans into two buffers - the
+// original text (never modified) and an append-only "add" buffer.
+typedef struct {
+    int from_add;   // 0 = original buffer, 1 = add buffer
+    int start;
+    int length;
+} Piece;
+
+typedef struct {
+    TextStorage base;
+    char* original;
+    int original_length;
+    char* add;
+    int add_length;
+    int add_capacity;
+    Piece* pieces;
+    int piece_count;
+    int piece_capacity;
+    int total_length;
+} PieceTable;
+
+static void piece_table_insert_piece(PieceTable* pt, int index, Piece piece) {
+    if (pt->piece_count == pt->piece_capacity) {
+        pt->piece_capacity *= 2;
+        pt->pieces = (Piece*)realloc(pt->pieces, pt->piece_capacity * sizeof(Piece));
+    }
+    memmove(&pt->pieces[index + 1], &pt->pieces[index], (pt->piece_count - index) * sizeof(Piece));
+    pt->pieces[index] = piece;
+    pt->piece_count++;
+}
+
+// Make sure a piece boundary exists at 'position'; returns the index of the
+// first piece starting at or after it.
+static int piece_table_split(PieceTable* pt, int position) {
+    int offset = 0;
+    for (int i = 0; i < pt->piece_count; i++) {
+        Piece* piece = &pt->pieces[i];
+        if (position == offset) return i;
+        if (position < offset + piece->length) {
+            int head = position - offset;
+            Piece tail = {piece->from_add, piece->start + head, piece->length - head};
+            piece->length = head;
+            piece_table_insert_piece(pt, i + 1, tail);
+            return i + 1;
+        }
+        offset += piece->length;
+    }
+    return pt->piece_count;
+}
+
+void piece_table_insert(TextStorage* self, int position, const char* text, int length) {
+    PieceTable* pt = (PieceTable*)self;
+    if (length <= 0) return;
+    
+    if (pt->add_length + length > pt->add_capacity) {
+        while (pt->add_length + length > pt->add_capacity) pt->add_capacity *= 2;
+        pt->add = (char*)realloc(pt->add, pt->add_capacity);
+    }
+    int add_start = pt->add_length;
+    memcpy(pt->add + add_start, text, length);
+    pt->add_length += length;
+    
+    int index = piece_table_split(pt, position);
+    Piece* prev = index > 0 ? &pt->pieces[index - 1] : NULL;
+    if (prev && prev->from_add && prev->start + prev->length == add_start) {
+        prev->length += length;  // Typing continues the previous span
+    } else {
+        Piece piece = {1, add_start, length};
+        piece_table_insert_piece(pt, index, piece);
+    }
+    pt->total_length += length;
+}
+
+void piece_table_erase(TextStorage* self, int start, int length) {
+    PieceTable* pt = (PieceTable*)self;
+    if (length <= 0) return;
+    
+    int first = piece_table_split(pt, start);
+    int last = piece_table_split(pt, start + length);
+    memmove(&pt->pieces[first], &pt->pieces[last], (pt->piece_count - last) * sizeof(Piece));
+    pt->piece_count -= last - first;
+    pt->total_length -= length;
+}
+
+void piece_table_extract(TextStorage* self, int start, int length, char* out) {
+    PieceTable* pt = (PieceTable*)self;
+    int offset = 0;
+    for (int i = 0; i < pt->piece_count && length > 0; i++) {
+        Piece* piece = &pt->pieces[i];
+        if (start < offset + piece->length) {
+            int skip = start > offset ? start - offset : 0;
+            int count = piece->length - skip;
+            if (count > length) count = length;
+            const char* source = piece->from_add ? pt->add : pt->original;
+            memcpy(out, source + piece->start + skip, count);
+            out += count;
+            length -= count;
+            start += count;
+        }
+        offset += piece->length;
+    }
+}
+
+int piece_table_length(TextStorage* self) {
+    return ((PieceTable*)self)->total_length;
+}
+
+void piece_table_destroy(TextStorage* self) {
+    PieceTable* pt = (PieceTable*)self;
+    if (pt) {
+        free(pt->original);
+        free(pt->add);
+        free(pt->pieces);
+        free(pt);
+    }
+}
+
+TextStorage* create_piece_table_storage(const char* initial_text, int length) {
+    PieceTable* pt = (PieceTable*)malloc(sizeof(PieceTable));
+    
+    strcpy(pt->base.name, "Piece Table");
+    pt->original = (char*)malloc(length > 0 ? length : 1);
+    memcpy(pt->original, initial_text, length);
+    pt->original_length = length;
+    pt->add_capacity = 256;
+    pt->add = (char*)malloc(pt->add_capacity);
+    pt->add_length = 0;
+    pt->piece_capacity = 16;
+    pt->pieces = (Piece*)malloc(pt->piece_capacity * sizeof(Piece));
+    pt->piece_count = 0;
+    pt->total_length = 0;
+    if (length > 0) {
+        Piece piece = {0, 0, length};
+        pt->pieces[pt->piece_count++] = piece;
+        pt->total_length = length;
+    }
+    
+    pt->base.insert = piece_table_insert;
+    pt->base.erase = piece_table_erase;
+    pt->base.extract = piece_table_extract;
+    pt->base.length = piece_table_length;
+    pt->base.destroy = piece_table_destroy;
+    
+    return (TextStorage*)pt;
+}
+
 // Receiver: Text Editor
 struct TextEditor {
-    char content[1000];
+    TextStorage* storage;
+    int length;              // Tracked here so nothing has to strlen() the text
     int cursor_position;
-    char clipboard[500];
+    char* clipboard;
+    int clipboard_length;
     
     void (*insert_text)(TextEditor* self, const char* text, int position);
     void (*delete_text)(TextEditor* self, int start, int length);
@@ -53,55 +332,65 @@ struct TextEditor {
 
 void text_editor_insert_text(TextEditor* self, const char* text, int position) {
     int text_len = strlen(text);
-    int content_len = strlen(self->content);
     
-    // Move existing text to make room
-    for (int i = content_len; i >= position; i--) {
-        self->content[i + text_len] = self->content[i];
-    }
-    
-    // Insert new text
-    for (int i = 0; i < text_len; i++) {
-        self->content[position + i] = text[i];
-    }
+    self->storage->insert(self->storage, position, text, text_len);
+    self->length += text_len;
     
     self->cursor_position = position + text_len;
-    printf("✏️ Inserted '%s' at position %d\n", text, position);
+    PATTERN_LOG("✏️ Inserted '%s' at position %d\n", text, position);
 }
 
 void text_editor_delete_text(TextEditor* self, int start, int length) {
-    int content_len = strlen(self->content);
-    
-    // Shift text left to fill the gap
-    for (int i = start; i <= content_len - length; i++) {
-        self->content[i] = self->content[i + length];
-    }
+    self->storage->erase(self->storage, start, length);
+    self->length -= length;
     
     self->cursor_position = start;
-    printf("🗑️ Deleted %d characters from position %d\n", length, start);
+    PATTERN_LOG("🗑️ Deleted %d characters from position %d\n", length, start);
+}
+
+// Copy a range of the document into a new NUL-terminated string
+char* text_editor_extract(TextEditor* self, int start, int length) {
+    char* text = (char*)malloc(length + 1);
+    self->storage->extract(self->storage, start, length, text);
+    text[length] = '\0';
+    return text;
+}
+
+// Does the document read exactly 'expected'?
+int text_editor_equals(TextEditor* self, const char* expected) {
+    if ((int)strlen(expected) != self->length) return 0;
+    char* text = text_editor_extract(self, 0, self->length);
+    int equal = strcmp(text, expected) == 0;
+    free(text);
+    return equal;
 }
 
 void text_editor_copy_text(TextEditor* self, int start, int length) {
-    strncpy(self->clipboard, &self->content[start], length);
-    self->clipboard[length] = '\\0';
-    printf("📋 Copied '%s' to clipboard\n", self->clipboard);
+    free(self->clipboard);
+    self->clipboard = text_editor_extract(self, start, length);
+    self->clipboard_length = length;
+    PATTERN_LOG("📋 Copied '%s' to clipboard\n", self->clipboard);
 }
 
 void text_editor_paste_text(TextEditor* self, int position) {
     text_editor_insert_text(self, self->clipboard, position);
-    printf("📋 Pasted from clipboard\n");
+    PATTERN_LOG("📋 Pasted from clipboard\n");
 }
 
 void text_editor_display(TextEditor* self) {
-    printf("📄 Document: \"%s\" (cursor at %d)\n", self->content, self->cursor_position);
+    char* content = text_editor_extract(self, 0, self->length);
+    printf("📄 Document: \"%s\" (cursor at %d)\n", content, self->cursor_position);
+    free(content);
 }
 
-TextEditor* create_text_editor() {
+TextEditor* create_text_editor_with_storage(TextStorage* storage) {
     TextEditor* editor = (TextEditor*)malloc(sizeof(TextEditor));
     
-    strcpy(editor->content, "");
+    editor->storage = storage;
+    editor->length = storage->length(storage);
     editor->cursor_position = 0;
-    strcpy(editor->clipboard, "");
+    editor->clipboard = (char*)calloc(1, 1);
+    editor->clipboard_length = 0;
     
     editor->insert_text = text_editor_insert_text;
     editor->delete_text = text_editor_delete_text;
@@ -112,14 +401,252 @@ TextEditor* create_text_editor() {
     return editor;
 }
 
+TextEditor* create_text_editor() {
+    return create_text_editor_with_storage(create_gap_buffer_storage(64));
+}
+
+// Command history storage
+//
+// Commands are bump-allocated from chunked arenas owned by the
+// CommandManager, so creating a command never calls malloc(). The history is
+// ordered the same way as the arena, which means:
+// - truncating the redo tail just rewinds the arena to the first dead command
+// - dropping the oldest history (memory cap) frees the oldest chunk whole
+// destroy() still runs on every discarded command, for anything it owns
+// outside the arena (a paste's captured text).
+//
+// A command can be created and held before it is executed, even across an
+// undo. Such pending commands are counted, and the arena is only rewound
+// when nothing pending or still in the history sits past the rewind point.
+// Otherwise the discarded bytes wait for their chunk, and chunks left with
+// nothing alive in them are released.
+#define DEFAULT_ARENA_CHUNK_SIZE (64 * 1024)
+
+typedef struct ArenaChunk {
+    struct ArenaChunk* next;   // Next (newer) chunk
+    size_t used;
+    size_t capacity;
+    int entry_count;           // History entries whose arena range starts here
+    int pending_count;         // Commands here that are created but not yet executed
+    int resident_count;        // Allocations here still in use (pending, history, batch children)
+    _Alignas(16) char data[];  // Keeps every allocation 16-byte aligned
+} ArenaChunk;
+
+// Hidden header in front of every command. chunk == NULL means the command
+// was heap-allocated (no manager) and destroy() must free it.
+typedef struct {
+    ArenaChunk* chunk;
+    size_t offset;             // Where this allocation starts in 'chunk'
+    size_t size;               // Bytes used, header included
+    ArenaChunk* first_chunk;   // Start of the range the command owns: itself,
+    size_t first_offset;       // or a batch's earliest child
+    int pending;               // Not yet executed or put in a batch
+} ArenaHeader;
+
+typedef struct {
+    Command** entry_buffer;
+    Command** entries;         // Window into entry_buffer; [0] is the oldest kept
+    int entry_capacity;        // Size of entry_buffer
+    int current_index;         // Last executed command, -1 if none
+    int history_size;
+    int dropped_count;         // Commands discarded because of memory_cap
+    ArenaChunk* oldest;
+    ArenaChunk* newest;
+    ArenaChunk* spare;         // One recycled chunk to avoid malloc churn
+    int pending_count;         // Arena commands created but not yet executed
+    size_t chunk_size;
+    size_t memory_cap;         // 0 = unlimited
+    size_t memory_used;        // Bytes held in live chunks
+    int coalesce_max_bytes;    // 0 = coalescing disabled
+    long coalesce_window_ms;   // 0 = no time limit, size window only
+    struct timespec last_execute_time;
+    int coalesced_count;       // Commands merged into an existing entry
+} CommandManager;
+
+static ArenaHeader* command_header(Command* command) {
+    return ((ArenaHeader*)command) - 1;
+}
+
+static void heap_command_destroy(Command* self) {
+    if (self && command_header(self)->chunk == NULL) {
+        free(command_header(self));
+    }
+}
+
+static void arena_release_chunk(CommandManager* manager, ArenaChunk* chunk) {
+    manager->memory_used -= chunk->capacity;
+    if (manager->spare == NULL && chunk->capacity == manager->chunk_size) {
+        manager->spare = chunk;
+    } else {
+        free(chunk);
+    }
+}
+
+// Release every chunk but the newest that has nothing alive left in it
+static void arena_release_idle_chunks(CommandManager* manager) {
+    ArenaChunk* previous = NULL;
+    ArenaChunk* chunk = manager->oldest;
+    while (chunk != manager->newest) {
+        ArenaChunk* next = chunk->next;
+        if (chunk->resident_count == 0) {
+            if (previous) previous->next = next;
+            else manager->oldest = next;
+            arena_release_chunk(manager, chunk);
+        } else {
+            previous = chunk;
+        }
+        chunk = next;
+    }
+}
+
+// Is (chunk, offset) at or after (from, from_offset) in the arena?
+static int arena_at_or_after(ArenaChunk* chunk, size_t offset, ArenaChunk* from, size_t from_offset) {
+    if (chunk == from) return offset >= from_offset;
+    for (ArenaChunk* c = from->next; c != NULL; c = c->next) {
+        if (c == chunk) return 1;
+    }
+    return 0;
+}
+
+static void arena_forget(CommandManager* manager, Command* command);
+
+// The command has been executed or taken over by a batch
+static void command_settle(CommandManager* manager, Command* command) {
+    ArenaHeader* header = command_header(command);
+    if (header->pending) {
+        header->pending = 0;
+        header->chunk->pending_count--;
+        manager->pending_count--;
+    }
+}
+
+// Discard every command after current_index. The arena is rewound to the
+// earliest range a discarded command owned, but only if nothing still in
+// use lives past that point: no pending command, and neither 'keep' (the
+// command being executed) nor any entry left in the history.
+static void truncate_redo_tail(CommandManager* manager, Command* keep) {
+    int first_dead = manager->current_index + 1;
+    if (first_dead >= manager->history_size) return;
+
+    ArenaChunk* rewind_chunk = NULL;
+    size_t rewind_offset = 0;
+    for (int i = first_dead; i < manager->history_size; i++) {
+        Command* dead = manager->entries[i];
+        ArenaHeader* header = command_header(dead);
+        if (header->first_chunk != NULL) {
+            header->first_chunk->entry_count--;
+            if (rewind_chunk == NULL || !arena_at_or_after(header->first_chunk, header->first_offset,
+                                                           rewind_chunk, rewind_offset)) {
+                rewind_chunk = header->first_chunk;
+                rewind_offset = header->first_offset;
+            }
+        }
+        arena_forget(manager, dead);
+        dead->destroy(dead);  // Frees what the command owns; arena memory stays put
+    }
+    manager->history_size = first_dead;
+
+    if (rewind_chunk == NULL) return;
+    int can_rewind = manager->pending_count == 0;
+    for (int i = -1; i < first_dead && can_rewind; i++) {
+        Command* live = i < 0 ? keep : manager->entries[i];
+        ArenaHeader* header = command_header(live);
+        if (header->chunk != NULL && arena_at_or_after(header->chunk, header->offset, rewind_chunk, rewind_offset)) {
+            can_rewind = 0;
+        }
+    }
+    if (!can_rewind) {
+        arena_release_idle_chunks(manager);
+        return;
+    }
+
+    ArenaChunk* rest = rewind_chunk->next;
+    while (rest != NULL) {
+        ArenaChunk* next = rest->next;
+        arena_release_chunk(manager, rest);
+        rest = next;
+    }
+    rewind_chunk->next = NULL;
+    rewind_chunk->used = rewind_offset;
+    manager->newest = rewind_chunk;
+}
+
+// Allocate 'size' bytes for a new command. The redo tail is left alone:
+// until another command executes, everything in it can still be redone.
+static Command* command_alloc(CommandManager* manager, size_t size) {
+    size_t total = sizeof(ArenaHeader) + size;
+    total = (total + 15) & ~(size_t)15;
+    
+    if (manager == NULL) {
+        ArenaHeader* header = (ArenaHeader*)malloc(total);
+        header->chunk = NULL;
+        header->offset = 0;
+        header->size = total;
+        header->first_chunk = NULL;
+        header->first_offset = 0;
+        header->pending = 0;
+        return (Command*)(header + 1);
+    }
+    
+    ArenaChunk* chunk = manager->newest;
+    if (chunk == NULL || chunk->used + total > chunk->capacity) {
+        size_t capacity = manager->chunk_size;
+        if (capacity < total) capacity = total;
+        if (manager->spare != NULL && manager->spare->capacity >= capacity) {
+            chunk = manager->spare;
+            manager->spare = NULL;
+            capacity = chunk->capacity;
+        } else {
+            chunk = (ArenaChunk*)malloc(sizeof(ArenaChunk) + capacity);
+            chunk->capacity = capacity;
+            COUNTER_ADD(command_chunks, 1);
+        }
+        chunk->next = NULL;
+        chunk->used = 0;
+        chunk->entry_count = 0;
+        chunk->pending_count = 0;
+        chunk->resident_count = 0;
+        if (manager->newest) manager->newest->next = chunk;
+        else manager->oldest = chunk;
+        manager->newest = chunk;
+        manager->memory_used += capacity;
+    }
+    
+    ArenaHeader* header = (ArenaHeader*)(chunk->data + chunk->used);
+    header->chunk = chunk;
+    header->offset = chunk->used;
+    header->size = total;
+    header->first_chunk = chunk;
+    header->first_offset = chunk->used;
+    header->pending = 1;
+    chunk->used += total;
+    chunk->pending_count++;
+    chunk->resident_count++;
+    manager->pending_count++;
+    return (Command*)(header + 1);
+}
+
+// Give a command its vtable and let the manager take care of its lifetime
+static void command_init(Command* command, const char* name,
+                         void (*execute)(Command*), void (*undo)(Command*)) {
+    strcpy(command->name, name);
+    command->execute = execute;
+    command->undo = undo;
+    command->destroy = heap_command_destroy;
+}
+
 // Concrete Commands
+//
+// Each command is one allocation: variable-length text is stored inline
+// after the struct, so the arena range of a command is contiguous.
 
 // Insert Command
 typedef struct {
     Command base;
     TextEditor* editor;
-    char text[200];
     int position;
+    int length;
+    char text[];
 } InsertCommand;
 
 void insert_command_execute(Command* self) {
@@ -129,27 +656,19 @@ void insert_command_execute(Command* self) {
 
 void insert_command_undo(Command* self) {
     InsertCommand* cmd = (InsertCommand*)self;
-    cmd->editor->delete_text(cmd->editor, cmd->position, strlen(cmd->text));
-    printf("↩️ Undone: Insert '%s'\n", cmd->text);
-}
-
-void insert_command_destroy(Command* self) {
-    if (self) {
-        free(self);
-    }
+    cmd->editor->delete_text(cmd->editor, cmd->position, cmd->length);
+    PATTERN_LOG("↩️ Undone: Insert '%s'\n", cmd->text);
 }
 
-Command* create_insert_command(TextEditor* editor, const char* text, int position) {
-    InsertCommand* cmd = (InsertCommand*)malloc(sizeof(InsertCommand));
+Command* create_insert_command(CommandManager* manager, TextEditor* editor, const char* text, int position) {
+    int length = strlen(text);
+    InsertCommand* cmd = (InsertCommand*)command_alloc(manager, sizeof(InsertCommand) + length + 1);
     
-    strcpy(cmd->base.name, "Insert");
+    command_init(&cmd->base, "Insert", insert_command_execute, insert_command_undo);
     cmd->editor = editor;
-    strcpy(cmd->text, text);
     cmd->position = position;
-    
-    cmd->base.execute = insert_command_execute;
-    cmd->base.undo = insert_command_undo;
-    cmd->base.destroy = insert_command_destroy;
+    cmd->length = length;
+    memcpy(cmd->text, text, length + 1);
     
     return (Command*)cmd;
 }
@@ -160,15 +679,15 @@ typedef struct {
     TextEditor* editor;
     int start_position;
     int length;
-    char deleted_text[200];
+    char deleted_text[];   // Filled on execute, sized at creation
 } DeleteCommand;
 
 void delete_command_execute(Command* self) {
     DeleteCommand* cmd = (DeleteCommand*)self;
     
     // Save deleted text for undo
-    strncpy(cmd->deleted_text, &cmd->editor->content[cmd->start_position], cmd->length);
-    cmd->deleted_text[cmd->length] = '\\0';
+    cmd->editor->storage->extract(cmd->editor->storage, cmd->start_position, cmd->length, cmd->deleted_text);
+    cmd->deleted_text[cmd->length] = '\0';
     
     cmd->editor->delete_text(cmd->editor, cmd->start_position, cmd->length);
 }
@@ -176,27 +695,17 @@ void delete_command_execute(Command* self) {
 void delete_command_undo(Command* self) {
     DeleteCommand* cmd = (DeleteCommand*)self;
     cmd->editor->insert_text(cmd->editor, cmd->deleted_text, cmd->start_position);
-    printf("↩️ Undone: Delete '%s'\n", cmd->deleted_text);
-}
-
-void delete_command_destroy(Command* self) {
-    if (self) {
-        free(self);
-    }
+    PATTERN_LOG("↩️ Undone: Delete '%s'\n", cmd->deleted_text);
 }
 
-Command* create_delete_command(TextEditor* editor, int start, int length) {
-    DeleteCommand* cmd = (DeleteCommand*)malloc(sizeof(DeleteCommand));
+Command* create_delete_command(CommandManager* manager, TextEditor* editor, int start, int length) {
+    DeleteCommand* cmd = (DeleteCommand*)command_alloc(manager, sizeof(DeleteCommand) + length + 1);
     
-    strcpy(cmd->base.name, "Delete");
+    command_init(&cmd->base, "Delete", delete_command_execute, delete_command_undo);
     cmd->editor = editor;
     cmd->start_position = start;
     cmd->length = length;
-    strcpy(cmd->deleted_text, "");
-    
-    cmd->base.execute = delete_command_execute;
-    cmd->base.undo = delete_command_undo;
-    cmd->base.destroy = delete_command_destroy;
+    cmd->deleted_text[0] = '\0';
     
     return (Command*)cmd;
 }
@@ -216,114 +725,334 @@ void copy_command_execute(Command* self) {
 
 void copy_command_undo(Command* self) {
     // Copy operation doesn't need undo
-    printf("↩️ Copy operation cannot be undone\n");
+    PATTERN_LOG("↩️ Copy operation cannot be undone\n");
 }
 
-void copy_command_destroy(Command* self) {
-    if (self) {
-        free(self);
-    }
-}
-
-Command* create_copy_command(TextEditor* editor, int start, int length) {
-    CopyCommand* cmd = (CopyCommand*)malloc(sizeof(CopyCommand));
+Command* create_copy_command(CommandManager* manager, TextEditor* editor, int start, int length) {
+    CopyCommand* cmd = (CopyCommand*)command_alloc(manager, sizeof(CopyCommand));
     
-    strcpy(cmd->base.name, "Copy");
+    command_init(&cmd->base, "Copy", copy_command_execute, copy_command_undo);
     cmd->editor = editor;
     cmd->start_position = start;
     cmd->length = length;
     
-    cmd->base.execute = copy_command_execute;
-    cmd->base.undo = copy_command_undo;
-    cmd->base.destroy = copy_command_destroy;
-    
     return (Command*)cmd;
 }
 
 // Paste Command
+// The clipboard is read when the paste first executes, so a paste can be
+// created before the copy it pastes (e.g. both inside one batch). Redo
+// pastes the same text again, whatever the clipboard holds by then.
 typedef struct {
     Command base;
     TextEditor* editor;
     int position;
-    char pasted_text[200];
     int pasted_length;
+    char* pasted_text;     // Captured on the first execute; NULL until then
 } PasteCommand;
 
 void paste_command_execute(Command* self) {
     PasteCommand* cmd = (PasteCommand*)self;
-    
-    // Save what will be pasted for undo
-    strcpy(cmd->pasted_text, cmd->editor->clipboard);
-    cmd->pasted_length = strlen(cmd->pasted_text);
-    
-    cmd->editor->paste_text(cmd->editor, cmd->position);
+    if (cmd->pasted_text == NULL) {
+        cmd->pasted_length = cmd->editor->clipboard_length;
+        cmd->pasted_text = (char*)malloc(cmd->pasted_length + 1);
+        memcpy(cmd->pasted_text, cmd->editor->clipboard, cmd->pasted_length + 1);
+    }
+    cmd->editor->insert_text(cmd->editor, cmd->pasted_text, cmd->position);
+    PATTERN_LOG("📋 Pasted from clipboard\n");
 }
 
 void paste_command_undo(Command* self) {
     PasteCommand* cmd = (PasteCommand*)self;
     cmd->editor->delete_text(cmd->editor, cmd->position, cmd->pasted_length);
-    printf("↩️ Undone: Paste '%s'\n", cmd->pasted_text);
+    PATTERN_LOG("↩️ Undone: Paste '%s'\n", cmd->pasted_text);
 }
 
 void paste_command_destroy(Command* self) {
-    if (self) {
-        free(self);
-    }
+    free(((PasteCommand*)self)->pasted_text);
+    heap_command_destroy(self);
 }
 
-Command* create_paste_command(TextEditor* editor, int position) {
-    PasteCommand* cmd = (PasteCommand*)malloc(sizeof(PasteCommand));
+Command* create_paste_command(CommandManager* manager, TextEditor* editor, int position) {
+    PasteCommand* cmd = (PasteCommand*)command_alloc(manager, sizeof(PasteCommand));
     
-    strcpy(cmd->base.name, "Paste");
+    command_init(&cmd->base, "Paste", paste_command_execute, paste_command_undo);
+    cmd->base.destroy = paste_command_destroy;
     cmd->editor = editor;
     cmd->position = position;
-    strcpy(cmd->pasted_text, "");
     cmd->pasted_length = 0;
+    cmd->pasted_text = NULL;
     
-    cmd->base.execute = paste_command_execute;
-    cmd->base.undo = paste_command_undo;
-    cmd->base.destroy = paste_command_destroy;
+    return (Command*)cmd;
+}
+
+// Batch Command: runs a group of commands as one undoable unit
+typedef struct {
+    Command base;
+    int count;
+    Command* commands[];
+} BatchCommand;
+
+void batch_command_execute(Command* self) {
+    BatchCommand* cmd = (BatchCommand*)self;
+    for (int i = 0; i < cmd->count; i++) {
+        cmd->commands[i]->execute(cmd->commands[i]);
+    }
+}
+
+void batch_command_undo(Command* self) {
+    BatchCommand* cmd = (BatchCommand*)self;
+    for (int i = cmd->count - 1; i >= 0; i--) {
+        cmd->commands[i]->undo(cmd->commands[i]);
+    }
+}
+
+void batch_command_destroy(Command* self) {
+    BatchCommand* cmd = (BatchCommand*)self;
+    for (int i = 0; i < cmd->count; i++) {
+        cmd->commands[i]->destroy(cmd->commands[i]);
+    }
+    heap_command_destroy(self);
+}
+
+// A command (and a batch's children) no longer needs its arena bytes
+static void arena_forget(CommandManager* manager, Command* command) {
+    ArenaHeader* header = command_header(command);
+    if (header->chunk == NULL) return;
+    if (command->destroy == batch_command_destroy) {
+        BatchCommand* batch = (BatchCommand*)command;
+        for (int i = 0; i < batch->count; i++) {
+            arena_forget(manager, batch->commands[i]);
+        }
+    }
+    command_settle(manager, command);
+    header->chunk->resident_count--;
+}
+
+// The children should come from the same manager. The batch then owns the
+// arena range starting at its earliest child, so rewinding past the batch
+// reclaims the children too.
+Command* create_batch_command(CommandManager* manager, const char* name, Command** commands, int count) {
+    BatchCommand* cmd = (BatchCommand*)command_alloc(manager, sizeof(BatchCommand) + count * sizeof(Command*));
+    
+    command_init(&cmd->base, name, batch_command_execute, batch_command_undo);
+    cmd->base.destroy = batch_command_destroy;
+    cmd->count = count;
+    memcpy(cmd->commands, commands, count * sizeof(Command*));
+    
+    ArenaHeader* header = command_header(&cmd->base);
+    if (header->chunk != NULL) {
+        for (int i = 0; i < count; i++) {
+            if (command_header(commands[i])->chunk != NULL) command_settle(manager, commands[i]);
+        }
+        for (int i = 0; i < count; i++) {
+            ArenaHeader* child = command_header(commands[i]);
+            if (child->first_chunk != NULL && !arena_at_or_after(child->first_chunk, child->first_offset,
+                                                                 header->first_chunk, header->first_offset)) {
+                header->first_chunk = child->first_chunk;
+                header->first_offset = child->first_offset;
+            }
+        }
+    }
     
     return (Command*)cmd;
 }
 
 // Invoker: Command Manager (supports undo/redo)
-#define MAX_COMMANDS 50
-
-typedef struct {
-    Command* command_history[MAX_COMMANDS];
-    int current_index;
-    int history_size;
-} CommandManager;
 
-CommandManager* create_command_manager() {
-    CommandManager* manager = (CommandManager*)malloc(sizeof(CommandManager));
+CommandManager* create_command_manager_with_limits(size_t chunk_size, size_t memory_cap) {
+    CommandManager* manager = (CommandManager*)calloc(1, sizeof(CommandManager));
+    manager->entry_capacity = 64;
+    manager->entry_buffer = (Command**)malloc(manager->entry_capacity * sizeof(Command*));
+    manager->entries = manager->entry_buffer;
     manager->current_index = -1;
     manager->history_size = 0;
+    manager->chunk_size = chunk_size;
+    manager->memory_cap = memory_cap;
     return manager;
 }
 
+CommandManager* create_command_manager() {
+    return create_command_manager_with_limits(DEFAULT_ARENA_CHUNK_SIZE, 0);
+}
+
+// Merge adjacent inserts/deletes into one history entry while the merged
+// text stays within max_bytes and (if window_ms > 0) commands arrive within
+// window_ms of each other. max_bytes == 0 turns coalescing off.
+void command_manager_set_coalescing(CommandManager* manager, int max_bytes, long window_ms) {
+    manager->coalesce_max_bytes = max_bytes;
+    manager->coalesce_window_ms = window_ms;
+}
+
+static void reverse_bytes(char* begin, char* end) {
+    while (begin < --end) {
+        char c = *begin;
+        *begin++ = *end;
+        *end = c;
+    }
+}
+
+// Append 'text' after the first 'length' bytes of 'target' (prepend when
+// 'before' is set). 'text' may live later in the same arena chunk.
+static void merge_text(char* target, int length, const char* text, int text_length, int before) {
+    memmove(target + length, text, text_length);
+    if (before) {
+        // [old][new] -> [new][old] by three reversals, no scratch buffer
+        reverse_bytes(target, target + length);
+        reverse_bytes(target + length, target + length + text_length);
+        reverse_bytes(target, target + length + text_length);
+    }
+    target[length + text_length] = '\0';
+}
+
+// Try to fold 'command' (already executed) into the current history entry.
+// Only possible when 'command' was the very next allocation in the same
+// chunk, and the last one so far - then the previous entry simply grows
+// over it.
+static int try_coalesce(CommandManager* manager, Command* command, struct timespec now) {
+    if (manager->coalesce_max_bytes <= 0 || manager->current_index < 0 ||
+        manager->current_index + 1 != manager->history_size) {
+        return 0;
+    }
+    if (manager->coalesce_window_ms > 0) {
+        long elapsed_ms = (now.tv_sec - manager->last_execute_time.tv_sec) * 1000 +
+                          (now.tv_nsec - manager->last_execute_time.tv_nsec) / 1000000;
+        if (elapsed_ms > manager->coalesce_window_ms) return 0;
+    }
+    
+    Command* previous = manager->entries[manager->current_index];
+    ArenaHeader* prev_header = command_header(previous);
+    ArenaHeader* header = command_header(command);
+    if (prev_header->chunk == NULL || header->chunk != prev_header->chunk ||
+        header->offset != prev_header->offset + prev_header->size ||
+        header->offset + header->size != header->chunk->used ||
+        previous->execute != command->execute) {
+        return 0;
+    }
+    
+    char* merged_end;
+    if (command->execute == insert_command_execute) {
+        InsertCommand* prev = (InsertCommand*)previous;
+        InsertCommand* cmd = (InsertCommand*)command;
+        if (prev->editor != cmd->editor || prev->position + prev->length != cmd->position ||
+            prev->length + cmd->length > manager->coalesce_max_bytes) {
+            return 0;
+        }
+        merge_text(prev->text, prev->length, cmd->text, cmd->length, 0);
+        prev->length += cmd->length;
+        merged_end = prev->text + prev->length + 1;
+    } else if (command->execute == delete_command_execute) {
+        DeleteCommand* prev = (DeleteCommand*)previous;
+        DeleteCommand* cmd = (DeleteCommand*)command;
+        if (prev->editor != cmd->editor || prev->length + cmd->length > manager->coalesce_max_bytes) {
+            return 0;
+        }
+        if (cmd->start_position == prev->start_position) {
+            // Forward delete: the new text followed the old one
+            merge_text(prev->deleted_text, prev->length, cmd->deleted_text, cmd->length, 0);
+        } else if (cmd->start_position + cmd->length == prev->start_position) {
+            // Backspace: the new text preceded the old one
+            merge_text(prev->deleted_text, prev->length, cmd->deleted_text, cmd->length, 1);
+            prev->start_position = cmd->start_position;
+        } else {
+            return 0;
+        }
+        prev->length += cmd->length;
+        merged_end = prev->deleted_text + prev->length + 1;
+    } else {
+        return 0;
+    }
+    
+    // The absorbed command's bytes now belong to the previous entry
+    size_t end = (size_t)(merged_end - prev_header->chunk->data);
+    end = (end + 15) & ~(size_t)15;
+    prev_header->size = end - prev_header->offset;
+    prev_header->chunk->used = end;
+    header->chunk->resident_count--;  // Its bytes are part of 'previous' now
+    manager->coalesced_count++;
+    return 1;
+}
+
+// Drop the oldest chunk (and every command in it) while over the memory cap.
+// Only chunks holding nothing but undoable history are dropped. The dropped
+// history runs up to the last entry whose range starts in the chunk, so
+// heap commands and commands executed after newer ones go with it.
+static void enforce_memory_cap(CommandManager* manager) {
+    while (manager->memory_cap > 0 && manager->memory_used > manager->memory_cap &&
+           manager->oldest != manager->newest) {
+        ArenaChunk* chunk = manager->oldest;
+        if (chunk->pending_count > 0) break;
+        int count = 0;
+        for (int seen = 0; seen < chunk->entry_count; count++) {
+            if (command_header(manager->entries[count])->first_chunk == chunk) seen++;
+        }
+        if (count > manager->current_index) break;
+        
+        manager->oldest = chunk->next;
+        for (int i = 0; i < count; i++) {
+            Command* dropped = manager->entries[i];
+            ArenaChunk* owner = command_header(dropped)->first_chunk;
+            if (owner != NULL) owner->entry_count--;
+            arena_forget(manager, dropped);
+            dropped->destroy(dropped);
+        }
+        arena_release_chunk(manager, chunk);
+        
+        // O(1): slide the window; execute_command() compacts when it must grow
+        manager->entries += count;
+        manager->history_size -= count;
+        manager->current_index -= count;
+        manager->dropped_count += count;
+    }
+}
+
 void execute_command(CommandManager* manager, Command* command) {
-    printf("\n🎬 Executing: %s\n", command->name);
+    PATTERN_LOG("\n🎬 Executing: %s\n", command->name);
     command->execute(command);
+    COUNTER_ADD(command_executed, 1);
+    if (command_header(command)->chunk != NULL) command_settle(manager, command);
     
     // Clear any commands after current position (for redo)
-    for (int i = manager->current_index + 1; i < manager->history_size; i++) {
-        manager->command_history[i]->destroy(manager->command_history[i]);
+    truncate_redo_tail(manager, command);
+    
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int merged = try_coalesce(manager, command, now);
+    manager->last_execute_time = now;
+    if (merged) {
+        COUNTER_ADD(command_coalesced, 1);
+        return;
     }
     
     // Add command to history
+    int offset = manager->entries - manager->entry_buffer;
+    if (offset + manager->history_size == manager->entry_capacity) {
+        if (offset > 0) {
+            memmove(manager->entry_buffer, manager->entries, manager->history_size * sizeof(Command*));
+        } else {
+            manager->entry_capacity *= 2;
+            manager->entry_buffer = (Command**)realloc(manager->entry_buffer,
+                                                       manager->entry_capacity * sizeof(Command*));
+        }
+        manager->entries = manager->entry_buffer;
+    }
     manager->current_index++;
-    manager->command_history[manager->current_index] = command;
+    manager->entries[manager->current_index] = command;
     manager->history_size = manager->current_index + 1;
+    if (command_header(command)->first_chunk != NULL) {
+        command_header(command)->first_chunk->entry_count++;
+    }
+    
+    enforce_memory_cap(manager);
 }
 
 void undo_command(CommandManager* manager) {
     if (manager->current_index >= 0) {
-        Command* command = manager->command_history[manager->current_index];
-        printf("\n↩️ Undoing: %s\n", command->name);
+        Command* command = manager->entries[manager->current_index];
+        PATTERN_LOG("\n↩️ Undoing: %s\n", command->name);
         command->undo(command);
         manager->current_index--;
+        COUNTER_ADD(command_undone, 1);
     } else {
         printf("\n❌ Nothing to undo\n");
     }
@@ -332,9 +1061,10 @@ void undo_command(CommandManager* manager) {
 void redo_command(CommandManager* manager) {
     if (manager->current_index + 1 < manager->history_size) {
         manager->current_index++;
-        Command* command = manager->command_history[manager->current_index];
-        printf("\n↪️ Redoing: %s\n", command->name);
+        Command* command = manager->entries[manager->current_index];
+        PATTERN_LOG("\n↪️ Redoing: %s\n", command->name);
         command->execute(command);
+        COUNTER_ADD(command_redone, 1);
     } else {
         printf("\n❌ Nothing to redo\n");
     }
@@ -343,26 +1073,102 @@ void redo_command(CommandManager* manager) {
 void print_command_history(CommandManager* manager) {
     printf("\n📋 Command History:\n");
     for (int i = 0; i < manager->history_size; i++) {
-        char marker = (i == manager->current_index) ? '→' : ' ';
-        printf("  %c %d. %s\n", marker, i + 1, manager->command_history[i]->name);
+        const char* marker = (i == manager->current_index) ? "→" : " ";
+        printf("  %s %d. %s\n", marker, manager->dropped_count + i + 1, manager->entries[i]->name);
     }
+    printf("  (%d dropped, %d coalesced, %zu bytes in arenas)\n",
+           manager->dropped_count, manager->coalesced_count, manager->memory_used);
 }
 
 void destroy_command_manager(CommandManager* manager) {
     if (manager) {
         for (int i = 0; i < manager->history_size; i++) {
-            manager->command_history[i]->destroy(manager->command_history[i]);
+            manager->entries[i]->destroy(manager->entries[i]);
         }
+        ArenaChunk* chunk = manager->oldest;
+        while (chunk != NULL) {
+            ArenaChunk* next = chunk->next;
+            free(chunk);
+            chunk = next;
+        }
+        free(manager->spare);
+        free(manager->entry_buffer);
         free(manager);
     }
 }
 
 void destroy_text_editor(TextEditor* editor) {
     if (editor) {
+        editor->storage->destroy(editor->storage);
+        free(editor->clipboard);
         free(editor);
     }
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_COMMANDS 1000
+
+typedef struct {
+    CommandManager* manager;
+    TextEditor* editor;
+} CommandBench;
+
+// Type one character per command at the end, then undo everything
+// (fewer history entries than commands when coalescing)
+static void bench_execute_undo(void* arg) {
+    CommandBench* bench = (CommandBench*)arg;
+    for (int i = 0; i < BENCH_COMMANDS; i++) {
+        Command* command = create_insert_command(bench->manager, bench->editor, "x", bench->editor->length);
+        execute_command(bench->manager, command);
+    }
+    while (bench->manager->current_index >= 0) {
+        undo_command(bench->manager);
+    }
+}
+
+// Step back through the whole history and forward again
+static void bench_undo_redo(void* arg) {
+    CommandBench* bench = (CommandBench*)arg;
+    for (int i = 0; i < BENCH_COMMANDS; i++) {
+        undo_command(bench->manager);
+    }
+    for (int i = 0; i < BENCH_COMMANDS; i++) {
+        redo_command(bench->manager);
+    }
+}
+
+int main() {
+    bench_header("Command execute/undo");
+    
+    CommandBench gap = {create_command_manager(), create_text_editor()};
+    bench_run("create + execute + undo, gap buffer (per command)", bench_execute_undo, &gap, BENCH_COMMANDS);
+    
+    CommandBench pieces = {create_command_manager(),
+                           create_text_editor_with_storage(create_piece_table_storage("", 0))};
+    bench_run("create + execute + undo, piece table (per command)", bench_execute_undo, &pieces, BENCH_COMMANDS);
+    
+    CommandBench typing = {create_command_manager(), create_text_editor()};
+    command_manager_set_coalescing(typing.manager, 64, 0);
+    bench_run("execute + undo, coalescing typing (per command)", bench_execute_undo, &typing, BENCH_COMMANDS);
+    
+    CommandBench history = {create_command_manager(), create_text_editor()};
+    for (int i = 0; i < BENCH_COMMANDS; i++) {
+        execute_command(history.manager, create_insert_command(history.manager, history.editor, "x", i));
+    }
+    bench_run("undo + redo, 1000-entry history (per step)", bench_undo_redo, &history, 2 * BENCH_COMMANDS);
+    
+    counters_report();
+    
+    CommandBench* benches[] = {&gap, &pieces, &typing, &history};
+    for (int i = 0; i < 4; i++) {
+        destroy_command_manager(benches[i]->manager);
+        destroy_text_editor(benches[i]->editor);
+    }
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== COMMAND PATTERN EXAMPLE ===\n\n");
@@ -379,24 +1185,24 @@ int main() {
     editor->display(editor);
     
     // Execute a series of commands
-    execute_command(manager, create_insert_command(editor, "Hello", 0));
+    execute_command(manager, create_insert_command(manager, editor, "Hello", 0));
     editor->display(editor);
     
-    execute_command(manager, create_insert_command(editor, " World", 5));
+    execute_command(manager, create_insert_command(manager, editor, " World", 5));
     editor->display(editor);
     
-    execute_command(manager, create_insert_command(editor, "!", 11));
+    execute_command(manager, create_insert_command(manager, editor, "!", 11));
     editor->display(editor);
     
-    execute_command(manager, create_copy_command(editor, 0, 5)); // Copy "Hello"
+    execute_command(manager, create_copy_command(manager, editor, 0, 5)); // Copy "Hello"
     
-    execute_command(manager, create_insert_command(editor, " ", 12));
+    execute_command(manager, create_insert_command(manager, editor, " ", 12));
     editor->display(editor);
     
-    execute_command(manager, create_paste_command(editor, 13));
+    execute_command(manager, create_paste_command(manager, editor, 13));
     editor->display(editor);
     
-    execute_command(manager, create_delete_command(editor, 6, 5)); // Delete "World"
+    execute_command(manager, create_delete_command(manager, editor, 6, 5)); // Delete "World"
     editor->display(editor);
     
     print_command_history(manager);
@@ -437,6 +1243,115 @@ int main() {
     }
     editor->display(editor);
     
+    // Same commands, different storage engine behind the editor
+    printf("\n--- Piece table storage (loaded file) ---\n");
+    const char* file_text = "Design patterns in C";
+    TextEditor* big_editor = create_text_editor_with_storage(
+        create_piece_table_storage(file_text, strlen(file_text)));
+    CommandManager* big_manager = create_command_manager();
+    printf("Storage: %s\n", big_editor->storage->name);
+    big_editor->display(big_editor);
+    execute_command(big_manager, create_insert_command(big_manager, big_editor, " are fun", 15));
+    execute_command(big_manager, create_delete_command(big_manager, big_editor, 0, 7));
+    big_editor->display(big_editor);
+    undo_command(big_manager);
+    big_editor->display(big_editor);
+    destroy_command_manager(big_manager);
+    destroy_text_editor(big_editor);
+    
+    // Bounded memory: small chunks and a cap, the oldest history is dropped
+    printf("\n--- Arena history with a memory cap ---\n");
+    TextEditor* capped_editor = create_text_editor();
+    CommandManager* capped = create_command_manager_with_limits(512, 1024);
+    const char* words[] = {"one ", "two ", "three ", "four ", "five ", "six ",
+                           "seven ", "eight ", "nine ", "ten "};
+    int position = 0;
+    for (int i = 0; i < 10; i++) {
+        execute_command(capped, create_insert_command(capped, capped_editor, words[i], position));
+        position += strlen(words[i]);
+    }
+    capped_editor->display(capped_editor);
+    print_command_history(capped);
+    destroy_command_manager(capped);
+    destroy_text_editor(capped_editor);
+    
+    // Coalescing: typing and backspacing one key at a time
+    printf("\n--- Coalescing keystrokes ---\n");
+    TextEditor* typing_editor = create_text_editor();
+    CommandManager* typing = create_command_manager();
+    command_manager_set_coalescing(typing, 64, 0);
+    const char* typed = "Helo";
+    for (int i = 0; typed[i] != '\0'; i++) {
+        char key[2] = {typed[i], '\0'};
+        execute_command(typing, create_insert_command(typing, typing_editor, key, i));
+    }
+    execute_command(typing, create_delete_command(typing, typing_editor, 3, 1));  // Backspace 'o'
+    execute_command(typing, create_delete_command(typing, typing_editor, 2, 1));  // Backspace 'l'
+    typing_editor->display(typing_editor);
+    print_command_history(typing);
+    undo_command(typing);
+    typing_editor->display(typing_editor);
+    
+    // Batch: "replace" is one undoable unit made of a delete and an insert
+    printf("\n--- Batch command (replace word) ---\n");
+    Command* steps[2];
+    steps[0] = create_delete_command(typing, typing_editor, 0, 4);
+    steps[1] = create_insert_command(typing, typing_editor, "Howdy", 0);
+    execute_command(typing, create_batch_command(typing, "Replace", steps, 2));
+    typing_editor->display(typing_editor);
+    undo_command(typing);
+    typing_editor->display(typing_editor);
+    print_command_history(typing);
+    destroy_command_manager(typing);
+    destroy_text_editor(typing_editor);
+    
+    // Pastes read the clipboard when they run, not when they are created
+    printf("\n--- Batch command (copy then paste) ---\n");
+    TextEditor* copy_editor = create_text_editor();
+    CommandManager* copying = create_command_manager();
+    execute_command(copying, create_insert_command(copying, copy_editor, "Hello", 0));
+    Command* duplicate[2];
+    duplicate[0] = create_copy_command(copying, copy_editor, 0, 5);
+    duplicate[1] = create_paste_command(copying, copy_editor, 5);
+    execute_command(copying, create_batch_command(copying, "Duplicate", duplicate, 2));
+    copy_editor->display(copy_editor);
+    int batch_ok = text_editor_equals(copy_editor, "HelloHello");
+    undo_command(copying);
+    batch_ok = batch_ok && text_editor_equals(copy_editor, "Hello");
+    printf("%s Copy + paste in one batch, then undo\n", batch_ok ? "✅" : "❌");
+    
+    Command* early_paste = create_paste_command(copying, copy_editor, 5);
+    execute_command(copying, create_copy_command(copying, copy_editor, 0, 2));
+    execute_command(copying, early_paste);
+    copy_editor->display(copy_editor);
+    int early_ok = text_editor_equals(copy_editor, "HelloHe");
+    copy_editor->copy_text(copy_editor, 0, 5);
+    undo_command(copying);
+    redo_command(copying);  // Pastes "He" again, not the newer clipboard
+    early_ok = early_ok && text_editor_equals(copy_editor, "HelloHe");
+    printf("%s Paste created before its copy, then undo + redo\n", early_ok ? "✅" : "❌");
+    destroy_command_manager(copying);
+    destroy_text_editor(copy_editor);
+    
+    // A command created before an undo keeps its memory: the undone command's
+    // bytes are not reused while it is still pending
+    printf("\n--- Command created before an undo ---\n");
+    TextEditor* held_editor = create_text_editor();
+    CommandManager* holding = create_command_manager();
+    execute_command(holding, create_insert_command(holding, held_editor, "a", 0));
+    Command* held = create_insert_command(holding, held_editor, "XYZ", 0);
+    undo_command(holding);
+    execute_command(holding, create_insert_command(holding, held_editor, "a much longer line of text ", 0));
+    execute_command(holding, held);
+    held_editor->display(held_editor);
+    int held_ok = text_editor_equals(held_editor, "XYZa much longer line of text ");
+    undo_command(holding);
+    undo_command(holding);
+    held_ok = held_ok && text_editor_equals(held_editor, "");
+    printf("%s Execute, create, undo, create: both new commands intact\n", held_ok ? "✅" : "❌");
+    destroy_command_manager(holding);
+    destroy_text_editor(held_editor);
+    
     printf("\n--- Command Pattern Benefits Demonstrated ---\n");
     printf("✅ Commands are decoupled from their receivers\n");
     printf("✅ Easy to add new command types\n");
@@ -449,4 +1364,5 @@ int main() {
     destroy_text_editor(editor);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
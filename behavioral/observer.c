@@ -18,97 +18,725 @@
  * Cons:
  * - Unexpected updates
  * - Memory leaks if observers aren't properly removed
+ *
+ * Async dispatch: subject_enable_async() hands a subject to a Dispatcher
+ * (work-stealing thread pool). notify() then only enqueues the event; a
+ * worker fans it out into each observer's mailbox, and each mailbox is
+ * drained by at most one worker at a time, so every subscriber still sees
+ * events in publication order while different subscribers run in parallel.
+ *
+ * Registry: observers live in fixed blocks of atomic slots. attach() returns
+ * a slot handle and detach_handle() clears it in O(1); cleared slots are
+ * reused. Blocks never move (only the small block table is copied when it
+ * grows), so notify() walks the slots without taking any lock.
+ *
+ * Payloads and topics: a notification is an immutable, reference-counted
+ * Payload created once by the publisher and shared by every subscriber
+ * (event_data points into it). Each subscription carries a topic mask and
+ * an optional predicate, checked before update() is ever called.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for fan-out microbenchmarks
+ * instead of the demo, and with -DPATTERN_COUNTERS for hot-path counters
+ * (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "../bench.h"
+
+HOT_COUNTER(observer_fan_outs, "observer", "sync fan-outs");
+HOT_COUNTER(observer_deliveries, "observer", "deliveries");
+HOT_COUNTER(observer_skipped, "observer", "slots skipped");
+HOT_COUNTER(observer_async_events, "observer", "async events queued");
 
 // Forward declarations
 typedef struct Observer Observer;
 typedef struct Subject Subject;
+typedef struct Dispatcher Dispatcher;
+
+// Topics a payload can be tagged with (bit mask)
+#define TOPIC_BREAKING  (1u << 0)
+#define TOPIC_GADGETS   (1u << 1)
+#define TOPIC_BUSINESS  (1u << 2)
+#define TOPIC_ALL       0xFFFFFFFFu
+
+// Immutable, reference-counted notification body. Never copied after
+// creation; observers receive a pointer to 'data'.
+typedef struct {
+    atomic_int refs;
+    uint32_t topics;
+    size_t length;
+    char data[];
+} Payload;
+
+// Optional per-subscription filter, evaluated before update()
+typedef int (*SubscriptionPredicate)(Observer* observer, const Payload* payload);
+
+// One queued delivery: which subject published which payload
+typedef struct {
+    Subject* subject;
+    Payload* payload;
+} Delivery;
+
+// Per-observer FIFO of pending events. 'scheduled' is set while a drain
+// task owns the mailbox, which is what keeps delivery ordered.
+typedef struct {
+    pthread_mutex_t lock;
+    Delivery* events;
+    int head;
+    int count;
+    int capacity;
+    int scheduled;
+} ObserverMailbox;
 
 // Observer interface
 struct Observer {
     char name[100];
     void (*update)(Observer* self, Subject* subject, const char* event_data);
     void (*destroy)(Observer* self);
+    ObserverMailbox mailbox;   // Used only by async subjects
 };
 
-// Subject interface
-#define MAX_OBSERVERS 20
+// Subscriber registry
+#define REGISTRY_BLOCK_SIZE 256
+
+// A slot's mask and predicate are written before its observer pointer is
+// published, so a reader that sees the observer also sees its filter.
+typedef struct {
+    _Atomic(Observer*) slots[REGISTRY_BLOCK_SIZE];
+    _Atomic(uint32_t) topic_masks[REGISTRY_BLOCK_SIZE];
+    _Atomic(SubscriptionPredicate) predicates[REGISTRY_BLOCK_SIZE];
+} RegistryBlock;
+
+// Block table, replaced copy-on-write when a block is added. Old tables
+// stay on the retired list until the registry is freed, so a reader that
+// still holds one never sees freed memory.
+typedef struct RegistryTable {
+    int block_count;
+    struct RegistryTable* retired_next;
+    RegistryBlock* blocks[];
+} RegistryTable;
 
+typedef struct {
+    _Atomic(RegistryTable*) table;
+    atomic_int slot_count;         // Readers scan slots [0, slot_count)
+    atomic_int live_count;
+    atomic_int active_readers[2];  // notify() calls in progress, by epoch parity
+    atomic_uint reader_epoch;      // Readers count under its low bit
+    pthread_mutex_t write_lock;    // Serializes attach/detach only
+    pthread_mutex_t sync_lock;     // One subject_synchronize() at a time
+    int* free_slots;
+    int free_count;
+    int free_capacity;
+    RegistryTable* retired;
+} ObserverRegistry;
+
+// Subject interface
 struct Subject {
-    Observer* observers[MAX_OBSERVERS];
-    int observer_count;
-    char state[256];
+    ObserverRegistry registry;
+    Payload* state;             // Latest payload (the subject holds one reference)
+    pthread_mutex_t state_lock; // Guards swapping 'state' against get_state()'s retain
+    Dispatcher* dispatcher;     // NULL = notify synchronously
+    ObserverMailbox pending;    // Events waiting to be fanned out
     
-    void (*attach)(Subject* self, Observer* observer);
-    void (*detach)(Subject* self, Observer* observer);
-    void (*notify)(Subject* self, const char* event_data);
+    int (*attach)(Subject* self, Observer* observer);      // Returns a handle
+    int (*attach_filtered)(Subject* self, Observer* observer,
+                           uint32_t topic_mask, SubscriptionPredicate predicate);
+    void (*detach)(Subject* self, Observer* observer);     // O(n) lookup by pointer
+    void (*detach_handle)(Subject* self, int handle);      // O(1)
+    void (*notify)(Subject* self, Payload* payload);
+    void (*publish)(Subject* self, Payload* payload);      // Takes over one reference
     void (*set_state)(Subject* self, const char* new_state);
-    const char* (*get_state)(Subject* self);
+    Payload* (*get_state)(Subject* self);                  // New reference: payload_release() it
     void (*destroy)(Subject* self);
 };
 
+// ---- Payloads ----
+
+// The only copy of the text: made once, by the publisher
+Payload* create_payload(const char* text, uint32_t topics) {
+    size_t length = strlen(text);
+    Payload* payload = (Payload*)malloc(sizeof(Payload) + length + 1);
+    atomic_init(&payload->refs, 1);
+    payload->topics = topics;
+    payload->length = length;
+    memcpy(payload->data, text, length + 1);
+    return payload;
+}
+
+Payload* payload_retain(Payload* payload) {
+    atomic_fetch_add_explicit(&payload->refs, 1, memory_order_relaxed);
+    return payload;
+}
+
+void payload_release(Payload* payload) {
+    if (payload && atomic_fetch_sub_explicit(&payload->refs, 1, memory_order_acq_rel) == 1) {
+        free(payload);
+    }
+}
+
+// Recover the payload behind an update()'s event_data, e.g. to keep it
+Payload* payload_from_data(const char* event_data) {
+    return (Payload*)(event_data - offsetof(Payload, data));
+}
+
+// ---- Subscriber registry ----
+
+void registry_init(ObserverRegistry* registry) {
+    RegistryTable* table = (RegistryTable*)calloc(1, sizeof(RegistryTable));
+    atomic_init(&registry->table, table);
+    atomic_init(&registry->slot_count, 0);
+    atomic_init(&registry->live_count, 0);
+    atomic_init(&registry->active_readers[0], 0);
+    atomic_init(&registry->active_readers[1], 0);
+    atomic_init(&registry->reader_epoch, 0);
+    pthread_mutex_init(&registry->write_lock, NULL);
+    pthread_mutex_init(&registry->sync_lock, NULL);
+    registry->free_slots = NULL;
+    registry->free_count = 0;
+    registry->free_capacity = 0;
+    registry->retired = NULL;
+}
+
+void registry_free(ObserverRegistry* registry) {
+    RegistryTable* table = atomic_load(&registry->table);
+    for (int i = 0; i < table->block_count; i++) {
+        free(table->blocks[i]);
+    }
+    free(table);
+    while (registry->retired != NULL) {
+        RegistryTable* next = registry->retired->retired_next;
+        free(registry->retired);
+        registry->retired = next;
+    }
+    free(registry->free_slots);
+    pthread_mutex_destroy(&registry->write_lock);
+    pthread_mutex_destroy(&registry->sync_lock);
+}
+
+static _Atomic(Observer*)* registry_slot(RegistryTable* table, int slot) {
+    return &table->blocks[slot / REGISTRY_BLOCK_SIZE]->slots[slot % REGISTRY_BLOCK_SIZE];
+}
+
+static void registry_set_filter(RegistryTable* table, int slot,
+                                uint32_t topic_mask, SubscriptionPredicate predicate) {
+    RegistryBlock* block = table->blocks[slot / REGISTRY_BLOCK_SIZE];
+    atomic_store_explicit(&block->topic_masks[slot % REGISTRY_BLOCK_SIZE], topic_mask, memory_order_relaxed);
+    atomic_store_explicit(&block->predicates[slot % REGISTRY_BLOCK_SIZE], predicate, memory_order_relaxed);
+}
+
+// Add an observer; returns its handle (slot index). O(1) amortized.
+int registry_add(ObserverRegistry* registry, Observer* observer,
+                 uint32_t topic_mask, SubscriptionPredicate predicate) {
+    pthread_mutex_lock(&registry->write_lock);
+    RegistryTable* table = atomic_load_explicit(&registry->table, memory_order_relaxed);
+    int slot;
+    if (registry->free_count > 0) {
+        slot = registry->free_slots[--registry->free_count];
+        registry_set_filter(table, slot, topic_mask, predicate);
+        atomic_store_explicit(registry_slot(table, slot), observer, memory_order_release);
+    } else {
+        slot = atomic_load_explicit(&registry->slot_count, memory_order_relaxed);
+        if (slot == table->block_count * REGISTRY_BLOCK_SIZE) {
+            // Copy the (small) block table, then publish it with one new block
+            RegistryTable* grown = (RegistryTable*)malloc(sizeof(RegistryTable) +
+                                                          (table->block_count + 1) * sizeof(RegistryBlock*));
+            grown->block_count = table->block_count + 1;
+            grown->retired_next = NULL;
+            memcpy(grown->blocks, table->blocks, table->block_count * sizeof(RegistryBlock*));
+            grown->blocks[table->block_count] = (RegistryBlock*)calloc(1, sizeof(RegistryBlock));
+            atomic_store_explicit(&registry->table, grown, memory_order_release);
+            table->retired_next = registry->retired;
+            registry->retired = table;
+            table = grown;
+        }
+        registry_set_filter(table, slot, topic_mask, predicate);
+        atomic_store_explicit(registry_slot(table, slot), observer, memory_order_release);
+        atomic_store_explicit(&registry->slot_count, slot + 1, memory_order_release);
+    }
+    atomic_fetch_add(&registry->live_count, 1);
+    pthread_mutex_unlock(&registry->write_lock);
+    return slot;
+}
+
+// Clear a handle's slot and recycle it. O(1). Returns the removed observer.
+Observer* registry_remove(ObserverRegistry* registry, int handle) {
+    Observer* removed = NULL;
+    pthread_mutex_lock(&registry->write_lock);
+    if (handle >= 0 && handle < atomic_load_explicit(&registry->slot_count, memory_order_relaxed)) {
+        RegistryTable* table = atomic_load_explicit(&registry->table, memory_order_relaxed);
+        removed = atomic_exchange(registry_slot(table, handle), NULL);
+        if (removed != NULL) {
+            if (registry->free_count == registry->free_capacity) {
+                registry->free_capacity = registry->free_capacity ? registry->free_capacity * 2 : 16;
+                registry->free_slots = (int*)realloc(registry->free_slots, registry->free_capacity * sizeof(int));
+            }
+            registry->free_slots[registry->free_count++] = handle;
+            atomic_fetch_sub(&registry->live_count, 1);
+        }
+    }
+    pthread_mutex_unlock(&registry->write_lock);
+    return removed;
+}
+
+// Linear search, kept for callers that only have the observer pointer
+int registry_find(ObserverRegistry* registry, Observer* observer) {
+    int count = atomic_load_explicit(&registry->slot_count, memory_order_acquire);
+    RegistryTable* table = atomic_load_explicit(&registry->table, memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        if (atomic_load_explicit(registry_slot(table, i), memory_order_acquire) == observer) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Lock-free read side: count first, then the table it is guaranteed to fit
+typedef struct {
+    RegistryTable* table;
+    int count;
+    int epoch;                     // Parity this reader is counted under
+} RegistrySnapshot;
+
+static RegistrySnapshot registry_read_begin(ObserverRegistry* registry) {
+    RegistrySnapshot snapshot;
+    // Counting under a parity synchronize() has just flipped away from is
+    // still safe: this reader's loads come after the detach it waited for
+    snapshot.epoch = atomic_load(&registry->reader_epoch) & 1;
+    atomic_fetch_add(&registry->active_readers[snapshot.epoch], 1);
+    snapshot.count = atomic_load_explicit(&registry->slot_count, memory_order_acquire);
+    snapshot.table = atomic_load_explicit(&registry->table, memory_order_acquire);
+    return snapshot;
+}
+
+static Observer* registry_read_slot(RegistrySnapshot* snapshot, int slot) {
+    return atomic_load_explicit(registry_slot(snapshot->table, slot), memory_order_acquire);
+}
+
+// Return the slot's observer if its subscription wants 'payload', else NULL.
+// The topic test is one AND; the predicate only runs when topics match.
+static Observer* registry_read_match(RegistrySnapshot* snapshot, int slot, const Payload* payload) {
+    Observer* observer = registry_read_slot(snapshot, slot);
+    if (observer == NULL) return NULL;
+    RegistryBlock* block = snapshot->table->blocks[slot / REGISTRY_BLOCK_SIZE];
+    uint32_t mask = atomic_load_explicit(&block->topic_masks[slot % REGISTRY_BLOCK_SIZE], memory_order_relaxed);
+    if ((mask & payload->topics) == 0) return NULL;
+    SubscriptionPredicate predicate =
+        atomic_load_explicit(&block->predicates[slot % REGISTRY_BLOCK_SIZE], memory_order_relaxed);
+    if (predicate != NULL && !predicate(observer, payload)) return NULL;
+    return observer;
+}
+
+static void registry_read_end(ObserverRegistry* registry, RegistrySnapshot* snapshot) {
+    atomic_fetch_sub(&registry->active_readers[snapshot->epoch], 1);
+}
+
+// Wait for notify() calls that might still see a detached observer (the
+// RCU "synchronize" step). Call before destroying a detached observer.
+// Flipping the epoch sends readers that start from now on to the other
+// counter, so only the ones already running are waited for and a steady
+// stream of notify() calls can't hold the detacher off forever.
+void subject_synchronize(Subject* subject) {
+    ObserverRegistry* registry = &subject->registry;
+    pthread_mutex_lock(&registry->sync_lock);
+    unsigned previous = atomic_fetch_add(&registry->reader_epoch, 1) & 1;
+    while (atomic_load(&registry->active_readers[previous]) > 0) {
+        sched_yield();
+    }
+    pthread_mutex_unlock(&registry->sync_lock);
+}
+
+// ---- Work-stealing dispatcher ----
+
+typedef struct {
+    void (*run)(Dispatcher* dispatcher, void* arg);
+    void* arg;
+} Task;
+
+// Owner pushes/pops at the tail, thieves take from the head
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;
+    int head;
+    int count;
+    int capacity;
+} WorkDeque;
+
+struct Dispatcher {
+    int worker_count;
+    pthread_t* threads;
+    WorkDeque* deques;         // One per worker, plus an injection queue at [worker_count]
+    pthread_mutex_t idle_lock;
+    pthread_cond_t work_available;
+    pthread_cond_t all_done;
+    atomic_int queued;         // Tasks sitting in deques
+    atomic_int pending;        // Tasks submitted but not finished
+    atomic_int running;
+};
+
+static _Thread_local Dispatcher* current_dispatcher = NULL;
+static _Thread_local int current_worker = -1;
+
+static void deque_push(WorkDeque* deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        int capacity = deque->capacity * 2;
+        Task* tasks = (Task*)malloc(capacity * sizeof(Task));
+        for (int i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity = capacity;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static int deque_pop(WorkDeque* deque, Task* out, int from_head) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        if (from_head) {
+            *out = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        } else {
+            *out = deque->tasks[(deque->head + deque->count - 1) % deque->capacity];
+        }
+        deque->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+void dispatcher_submit(Dispatcher* dispatcher, void (*run)(Dispatcher*, void*), void* arg) {
+    Task task = {run, arg};
+    int index = (current_dispatcher == dispatcher) ? current_worker : dispatcher->worker_count;
+    
+    atomic_fetch_add(&dispatcher->pending, 1);
+    atomic_fetch_add(&dispatcher->queued, 1);
+    deque_push(&dispatcher->deques[index], task);
+    
+    pthread_mutex_lock(&dispatcher->idle_lock);
+    pthread_cond_signal(&dispatcher->work_available);
+    pthread_mutex_unlock(&dispatcher->idle_lock);
+}
+
+// Own deque first (LIFO, cache-warm), then the injection queue, then steal
+static int dispatcher_find_task(Dispatcher* dispatcher, int self, Task* out) {
+    if (deque_pop(&dispatcher->deques[self], out, 0)) return 1;
+    if (deque_pop(&dispatcher->deques[dispatcher->worker_count], out, 1)) return 1;
+    for (int i = 1; i < dispatcher->worker_count; i++) {
+        int victim = (self + i) % dispatcher->worker_count;
+        if (deque_pop(&dispatcher->deques[victim], out, 1)) return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    Dispatcher* dispatcher;
+    int index;
+} WorkerStart;
+
+static void* dispatcher_worker(void* arg) {
+    WorkerStart start = *(WorkerStart*)arg;
+    free(arg);
+    Dispatcher* dispatcher = start.dispatcher;
+    current_dispatcher = dispatcher;
+    current_worker = start.index;
+    
+    for (;;) {
+        Task task;
+        if (dispatcher_find_task(dispatcher, start.index, &task)) {
+            atomic_fetch_sub(&dispatcher->queued, 1);
+            task.run(dispatcher, task.arg);
+            if (atomic_fetch_sub(&dispatcher->pending, 1) == 1) {
+                pthread_mutex_lock(&dispatcher->idle_lock);
+                pthread_cond_broadcast(&dispatcher->all_done);
+                pthread_mutex_unlock(&dispatcher->idle_lock);
+            }
+            continue;
+        }
+        
+        pthread_mutex_lock(&dispatcher->idle_lock);
+        while (atomic_load(&dispatcher->queued) == 0 && atomic_load(&dispatcher->running)) {
+            pthread_cond_wait(&dispatcher->work_available, &dispatcher->idle_lock);
+        }
+        int stop = !atomic_load(&dispatcher->running) && atomic_load(&dispatcher->queued) == 0;
+        pthread_mutex_unlock(&dispatcher->idle_lock);
+        if (stop) break;
+    }
+    return NULL;
+}
+
+Dispatcher* create_dispatcher(int worker_count) {
+    Dispatcher* dispatcher = (Dispatcher*)calloc(1, sizeof(Dispatcher));
+    
+    dispatcher->worker_count = worker_count;
+    dispatcher->threads = (pthread_t*)malloc(worker_count * sizeof(pthread_t));
+    dispatcher->deques = (WorkDeque*)calloc(worker_count + 1, sizeof(WorkDeque));
+    for (int i = 0; i <= worker_count; i++) {
+        pthread_mutex_init(&dispatcher->deques[i].lock, NULL);
+        dispatcher->deques[i].capacity = 64;
+        dispatcher->deques[i].tasks = (Task*)malloc(64 * sizeof(Task));
+    }
+    pthread_mutex_init(&dispatcher->idle_lock, NULL);
+    pthread_cond_init(&dispatcher->work_available, NULL);
+    pthread_cond_init(&dispatcher->all_done, NULL);
+    atomic_init(&dispatcher->queued, 0);
+    atomic_init(&dispatcher->pending, 0);
+    atomic_init(&dispatcher->running, 1);
+    
+    for (int i = 0; i < worker_count; i++) {
+        WorkerStart* start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        start->dispatcher = dispatcher;
+        start->index = i;
+        pthread_create(&dispatcher->threads[i], NULL, dispatcher_worker, start);
+    }
+    printf("🧵 Dispatcher started with %d workers\n", worker_count);
+    return dispatcher;
+}
+
+// Block until every submitted event has been delivered
+void dispatcher_flush(Dispatcher* dispatcher) {
+    pthread_mutex_lock(&dispatcher->idle_lock);
+    while (atomic_load(&dispatcher->pending) > 0) {
+        pthread_cond_wait(&dispatcher->all_done, &dispatcher->idle_lock);
+    }
+    pthread_mutex_unlock(&dispatcher->idle_lock);
+}
+
+void destroy_dispatcher(Dispatcher* dispatcher) {
+    if (dispatcher) {
+        dispatcher_flush(dispatcher);
+        pthread_mutex_lock(&dispatcher->idle_lock);
+        atomic_store(&dispatcher->running, 0);
+        pthread_cond_broadcast(&dispatcher->work_available);
+        pthread_mutex_unlock(&dispatcher->idle_lock);
+        for (int i = 0; i < dispatcher->worker_count; i++) {
+            pthread_join(dispatcher->threads[i], NULL);
+        }
+        for (int i = 0; i <= dispatcher->worker_count; i++) {
+            free(dispatcher->deques[i].tasks);
+            pthread_mutex_destroy(&dispatcher->deques[i].lock);
+        }
+        free(dispatcher->deques);
+        free(dispatcher->threads);
+        free(dispatcher);
+    }
+}
+
+// ---- Events and mailboxes ----
+
+void init_mailbox(ObserverMailbox* mailbox) {
+    pthread_mutex_init(&mailbox->lock, NULL);
+    mailbox->events = NULL;
+    mailbox->head = 0;
+    mailbox->count = 0;
+    mailbox->capacity = 0;
+    mailbox->scheduled = 0;
+}
+
+void free_mailbox(ObserverMailbox* mailbox) {
+    while (mailbox->count > 0) {
+        payload_release(mailbox->events[mailbox->head].payload);
+        mailbox->head = (mailbox->head + 1) % mailbox->capacity;
+        mailbox->count--;
+    }
+    free(mailbox->events);
+    pthread_mutex_destroy(&mailbox->lock);
+}
+
+// Append an event. Returns 1 if the caller must schedule a drain task.
+static int mailbox_push(ObserverMailbox* mailbox, Delivery event) {
+    pthread_mutex_lock(&mailbox->lock);
+    if (mailbox->count == mailbox->capacity) {
+        int capacity = mailbox->capacity ? mailbox->capacity * 2 : 8;
+        Delivery* events = (Delivery*)malloc(capacity * sizeof(Delivery));
+        for (int i = 0; i < mailbox->count; i++) {
+            events[i] = mailbox->events[(mailbox->head + i) % mailbox->capacity];
+        }
+        free(mailbox->events);
+        mailbox->events = events;
+        mailbox->head = 0;
+        mailbox->capacity = capacity;
+    }
+    mailbox->events[(mailbox->head + mailbox->count) % mailbox->capacity] = event;
+    mailbox->count++;
+    int schedule = !mailbox->scheduled;
+    mailbox->scheduled = 1;
+    pthread_mutex_unlock(&mailbox->lock);
+    return schedule;
+}
+
+// Take the oldest event, or clear 'scheduled' and return 0 when empty
+static int mailbox_take(ObserverMailbox* mailbox, Delivery* event) {
+    int found = 0;
+    pthread_mutex_lock(&mailbox->lock);
+    if (mailbox->count > 0) {
+        *event = mailbox->events[mailbox->head];
+        found = 1;
+        mailbox->head = (mailbox->head + 1) % mailbox->capacity;
+        mailbox->count--;
+    } else {
+        mailbox->scheduled = 0;
+    }
+    pthread_mutex_unlock(&mailbox->lock);
+    return found;
+}
+
+// Deliver everything queued for one observer, in order
+static void drain_observer_task(Dispatcher* dispatcher, void* arg) {
+    (void)dispatcher;
+    Observer* observer = (Observer*)arg;
+    Delivery event;
+    while (mailbox_take(&observer->mailbox, &event)) {
+        observer->update(observer, event.subject, event.payload->data);
+        payload_release(event.payload);
+        COUNTER_ADD(observer_deliveries, 1);
+    }
+}
+
+// Fan the subject's queued events out to its observers. Only one pump runs
+// per subject, so events enter every mailbox in publication order.
+static void pump_subject_task(Dispatcher* dispatcher, void* arg) {
+    Subject* subject = (Subject*)arg;
+    Delivery event;
+    while (mailbox_take(&subject->pending, &event)) {
+        RegistrySnapshot snapshot = registry_read_begin(&subject->registry);
+        for (int i = 0; i < snapshot.count; i++) {
+            Observer* observer = registry_read_match(&snapshot, i, event.payload);
+            if (observer == NULL) {
+                COUNTER_ADD(observer_skipped, 1);
+                continue;
+            }
+            Delivery delivery = {subject, payload_retain(event.payload)};
+            if (mailbox_push(&observer->mailbox, delivery)) {
+                dispatcher_submit(dispatcher, drain_observer_task, observer);
+            }
+        }
+        registry_read_end(&subject->registry, &snapshot);
+        payload_release(event.payload);
+    }
+}
+
+// Route this subject's notifications through 'dispatcher' (NULL = sync again).
+// Call dispatcher_flush() before detaching or destroying observers.
+void subject_enable_async(Subject* subject, Dispatcher* dispatcher) {
+    subject->dispatcher = dispatcher;
+}
+
+// Async notify: one queue push, however many observers
+static void subject_enqueue_event(Subject* subject, Payload* payload) {
+    Delivery event = {subject, payload_retain(payload)};
+    COUNTER_ADD(observer_async_events, 1);
+    if (mailbox_push(&subject->pending, event)) {
+        dispatcher_submit(subject->dispatcher, pump_subject_task, subject);
+    }
+}
+
 // Concrete Subject: News Agency
 typedef struct {
     Subject base;
-    char latest_news[512];
     char category[100];
 } NewsAgency;
 
-void news_agency_attach(Subject* self, Observer* observer) {
+int news_agency_attach_filtered(Subject* self, Observer* observer,
+                                uint32_t topic_mask, SubscriptionPredicate predicate) {
+    NewsAgency* agency = (NewsAgency*)self;
+    int handle = registry_add(&self->registry, observer, topic_mask, predicate);
+    printf("📰 %s subscribed to %s news\n", observer->name, agency->category);
+    return handle;
+}
+
+int news_agency_attach(Subject* self, Observer* observer) {
+    return news_agency_attach_filtered(self, observer, TOPIC_ALL, NULL);
+}
+
+void news_agency_detach_handle(Subject* self, int handle) {
     NewsAgency* agency = (NewsAgency*)self;
-    if (agency->base.observer_count < MAX_OBSERVERS) {
-        agency->base.observers[agency->base.observer_count] = observer;
-        agency->base.observer_count++;
-        printf("📰 %s subscribed to %s news\n", observer->name, agency->category);
+    Observer* observer = registry_remove(&self->registry, handle);
+    if (observer != NULL) {
+        printf("📰 %s unsubscribed from %s news\n", observer->name, agency->category);
     } else {
-        printf("Error: Too many subscribers\n");
+        printf("Error: Observer not found\n");
     }
 }
 
 void news_agency_detach(Subject* self, Observer* observer) {
-    NewsAgency* agency = (NewsAgency*)self;
-    for (int i = 0; i < agency->base.observer_count; i++) {
-        if (agency->base.observers[i] == observer) {
-            // Shift remaining observers
-            for (int j = i; j < agency->base.observer_count - 1; j++) {
-                agency->base.observers[j] = agency->base.observers[j + 1];
-            }
-            agency->base.observer_count--;
-            printf("📰 %s unsubscribed from %s news\n", observer->name, agency->category);
-            return;
+    news_agency_detach_handle(self, registry_find(&self->registry, observer));
+}
+
+// Synchronous fan-out, without the narration; returns how many observers got it
+int subject_fan_out(Subject* self, Payload* payload) {
+    COUNTER_TIME_BEGIN(observer_fan_outs);
+    int delivered = 0;
+    RegistrySnapshot snapshot = registry_read_begin(&self->registry);
+    for (int i = 0; i < snapshot.count; i++) {
+        Observer* observer = registry_read_match(&snapshot, i, payload);
+        if (observer != NULL) {
+            observer->update(observer, self, payload->data);
+            delivered++;
         }
     }
-    printf("Error: Observer not found\n");
+    registry_read_end(&self->registry, &snapshot);
+    COUNTER_ADD(observer_deliveries, delivered);
+    COUNTER_ADD(observer_skipped, snapshot.count - delivered);
+    COUNTER_TIME_END(observer_fan_outs);
+    return delivered;
 }
 
-void news_agency_notify(Subject* self, const char* event_data) {
+void news_agency_notify(Subject* self, Payload* payload) {
     NewsAgency* agency = (NewsAgency*)self;
-    printf("\n🔔 Broadcasting %s news to %d subscribers...\n", 
-           agency->category, agency->base.observer_count);
-    
-    for (int i = 0; i < agency->base.observer_count; i++) {
-        agency->base.observers[i]->update(agency->base.observers[i], self, event_data);
+    if (self->dispatcher != NULL) {
+        subject_enqueue_event(self, payload);
+        return;
     }
+    
+    PATTERN_LOG("\n🔔 Broadcasting %s news to %d subscribers...\n", 
+                agency->category, atomic_load(&self->registry.live_count));
+    subject_fan_out(self, payload);
+}
+
+// Make 'payload' the current state and notify. Consumes the caller's reference.
+void news_agency_publish(Subject* self, Payload* payload) {
+    pthread_mutex_lock(&self->state_lock);
+    Payload* previous = self->state;
+    self->state = payload;
+    pthread_mutex_unlock(&self->state_lock);
+    self->notify(self, payload);
+    payload_release(previous);
 }
 
 void news_agency_set_state(Subject* self, const char* new_state) {
-    NewsAgency* agency = (NewsAgency*)self;
-    strcpy(agency->base.state, new_state);
-    strcpy(agency->latest_news, new_state);
-    agency->base.notify(self, new_state);
+    self->publish(self, create_payload(new_state, TOPIC_ALL));
 }
 
-const char* news_agency_get_state(Subject* self) {
-    NewsAgency* agency = (NewsAgency*)self;
-    return agency->latest_news;
+// Retain under the lock: a publish() on another thread may drop the
+// subject's reference the moment 'state' is swapped
+Payload* news_agency_get_state(Subject* self) {
+    pthread_mutex_lock(&self->state_lock);
+    Payload* state = payload_retain(self->state);
+    pthread_mutex_unlock(&self->state_lock);
+    return state;
 }
 
 void news_agency_destroy(Subject* self) {
     if (self) {
+        free_mailbox(&self->pending);
+        registry_free(&self->registry);
+        payload_release(self->state);
+        pthread_mutex_destroy(&self->state_lock);
         free(self);
     }
 }
@@ -117,13 +745,18 @@ Subject* create_news_agency(const char* category) {
     NewsAgency* agency = (NewsAgency*)malloc(sizeof(NewsAgency));
     
     strcpy(agency->category, category);
-    strcpy(agency->latest_news, "No news yet");
-    strcpy(agency->base.state, "No news yet");
-    agency->base.observer_count = 0;
+    agency->base.state = create_payload("No news yet", TOPIC_ALL);
+    pthread_mutex_init(&agency->base.state_lock, NULL);
+    registry_init(&agency->base.registry);
+    agency->base.dispatcher = NULL;
+    init_mailbox(&agency->base.pending);
     
     agency->base.attach = news_agency_attach;
+    agency->base.attach_filtered = news_agency_attach_filtered;
     agency->base.detach = news_agency_detach;
+    agency->base.detach_handle = news_agency_detach_handle;
     agency->base.notify = news_agency_notify;
+    agency->base.publish = news_agency_publish;
     agency->base.set_state = news_agency_set_state;
     agency->base.get_state = news_agency_get_state;
     agency->base.destroy = news_agency_destroy;
@@ -148,6 +781,7 @@ void news_channel_update(Observer* self, Subject* subject, const char* event_dat
 
 void news_channel_destroy(Observer* self) {
     if (self) {
+        free_mailbox(&self->mailbox);
         free(self);
     }
 }
@@ -161,6 +795,7 @@ Observer* create_news_channel(const char* name, const char* type, int viewers) {
     
     channel->base.update = news_channel_update;
     channel->base.destroy = news_channel_destroy;
+    init_mailbox(&channel->base.mailbox);
     
     return (Observer*)channel;
 }
@@ -184,8 +819,15 @@ void mobile_app_update(Observer* self, Subject* subject, const char* event_data)
     }
 }
 
+// Subscription predicate: skip apps that have push turned off entirely
+int mobile_app_push_filter(Observer* self, const Payload* payload) {
+    (void)payload;
+    return ((MobileApp*)self)->push_enabled;
+}
+
 void mobile_app_destroy(Observer* self) {
     if (self) {
+        free_mailbox(&self->mailbox);
         free(self);
     }
 }
@@ -199,6 +841,7 @@ Observer* create_mobile_app(const char* name, const char* platform, int push_ena
     
     app->base.update = mobile_app_update;
     app->base.destroy = mobile_app_destroy;
+    init_mailbox(&app->base.mailbox);
     
     return (Observer*)app;
 }
@@ -208,17 +851,23 @@ typedef struct {
     Observer base;
     char email[100];
     char subscription_type[50];
+    int send_delay_ms;         // Simulated mail server latency
 } EmailSubscriber;
 
 void email_subscriber_update(Observer* self, Subject* subject, const char* event_data) {
     EmailSubscriber* subscriber = (EmailSubscriber*)self;
     
+    if (subscriber->send_delay_ms > 0) {
+        struct timespec delay = {0, subscriber->send_delay_ms * 1000000L};
+        nanosleep(&delay, NULL);
+    }
     printf("📧 Email to %s (%s): %s\n", 
            subscriber->email, subscriber->subscription_type, event_data);
 }
 
 void email_subscriber_destroy(Observer* self) {
     if (self) {
+        free_mailbox(&self->mailbox);
         free(self);
     }
 }
@@ -229,13 +878,108 @@ Observer* create_email_subscriber(const char* name, const char* email, const cha
     strcpy(subscriber->base.name, name);
     strcpy(subscriber->email, email);
     strcpy(subscriber->subscription_type, type);
+    subscriber->send_delay_ms = 0;
     
     subscriber->base.update = email_subscriber_update;
     subscriber->base.destroy = email_subscriber_destroy;
+    init_mailbox(&subscriber->base.mailbox);
     
     return (Observer*)subscriber;
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+// Counts deliveries instead of printing them
+typedef struct {
+    Observer base;
+    long updates;
+} CountingObserver;
+
+void counting_observer_update(Observer* self, Subject* subject, const char* event_data) {
+    (void)subject;
+    (void)event_data;
+    ((CountingObserver*)self)->updates++;
+}
+
+void counting_observer_destroy(Observer* self) {
+    if (self) {
+        free_mailbox(&self->mailbox);
+        free(self);
+    }
+}
+
+Observer* create_counting_observer(int index) {
+    CountingObserver* observer = (CountingObserver*)calloc(1, sizeof(CountingObserver));
+    snprintf(observer->base.name, sizeof(observer->base.name), "Counter %d", index);
+    observer->base.update = counting_observer_update;
+    observer->base.destroy = counting_observer_destroy;
+    init_mailbox(&observer->base.mailbox);
+    return (Observer*)observer;
+}
+
+#define BENCH_OBSERVERS 1000
+#define BENCH_PUBLISHES 100
+
+typedef struct {
+    Subject* subject;
+    Payload* payload;
+} FanOutBench;
+
+static void bench_sync_fan_out(void* arg) {
+    FanOutBench* bench = (FanOutBench*)arg;
+    for (int i = 0; i < BENCH_PUBLISHES; i++) {
+        bench_consume(subject_fan_out(bench->subject, bench->payload));
+    }
+}
+
+static void bench_async_notify(void* arg) {
+    FanOutBench* bench = (FanOutBench*)arg;
+    for (int i = 0; i < BENCH_PUBLISHES; i++) {
+        bench->subject->notify(bench->subject, bench->payload);
+    }
+    dispatcher_flush(bench->subject->dispatcher);
+}
+
+int main() {
+    bench_header("Observer notify fan-out");
+    
+    // Everyone follows 'everyone'; one in ten follows gadgets on 'gadgets'
+    Subject* everyone = create_news_agency("Everyone");
+    Subject* gadgets = create_news_agency("Gadgets");
+    Observer* observers[BENCH_OBSERVERS];
+    for (int i = 0; i < BENCH_OBSERVERS; i++) {
+        observers[i] = create_counting_observer(i);
+        registry_add(&everyone->registry, observers[i], TOPIC_ALL, NULL);
+        registry_add(&gadgets->registry, observers[i], i % 10 == 0 ? TOPIC_GADGETS : TOPIC_BUSINESS, NULL);
+    }
+    Payload* payload = create_payload("Benchmark headline", TOPIC_GADGETS);
+    FanOutBench all = {everyone, payload};
+    FanOutBench filtered = {gadgets, payload};
+    
+    bench_run("sync notify, 1000 observers (per delivery)", bench_sync_fan_out, &all,
+              (long)BENCH_PUBLISHES * BENCH_OBSERVERS);
+    bench_run("filtered notify, 100 of 1000 match (per notify)", bench_sync_fan_out, &filtered,
+              BENCH_PUBLISHES);
+    
+    Dispatcher* dispatcher = create_dispatcher(4);
+    subject_enable_async(everyone, dispatcher);
+    bench_run("async notify + flush, 4 workers (per delivery)", bench_async_notify, &all,
+              (long)BENCH_PUBLISHES * BENCH_OBSERVERS);
+    destroy_dispatcher(dispatcher);
+    subject_enable_async(everyone, NULL);
+    
+    counters_report();
+    
+    payload_release(payload);
+    everyone->destroy(everyone);
+    gadgets->destroy(gadgets);
+    for (int i = 0; i < BENCH_OBSERVERS; i++) {
+        observers[i]->destroy(observers[i]);
+    }
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== OBSERVER PATTERN EXAMPLE ===\n\n");
@@ -283,13 +1027,55 @@ int main() {
     // John unsubscribes from tech news
     tech_news->detach(tech_news, john_email);
     
-    // Create new subscriber
+    // Create new subscriber; keep the handle for an O(1) unsubscribe later.
+    // Its push is off, so the predicate keeps update() from being called.
     Observer* mobile_digest = create_mobile_app("Mobile Digest", "Cross-platform", 0);
-    tech_news->attach(tech_news, mobile_digest);
+    int digest_handle = tech_news->attach_filtered(tech_news, mobile_digest, TOPIC_ALL,
+                                                   mobile_app_push_filter);
+    
+    // John comes back, but only for breaking news
+    int john_handle = tech_news->attach_filtered(tech_news, john_email, TOPIC_BREAKING, NULL);
     
     // Publish another news item
     tech_news->set_state(tech_news, "Tesla unveils fully autonomous driving system!");
     
+    printf("\n--- Topic-filtered payloads ---\n");
+    
+    // One shared, immutable payload per story; only matching subscribers are called
+    tech_news->publish(tech_news, create_payload("New foldable phone reviewed", TOPIC_GADGETS));
+    tech_news->publish(tech_news, create_payload("Chip maker shares surge 20%", TOPIC_BUSINESS | TOPIC_BREAKING));
+    Payload* latest = tech_news->get_state(tech_news);
+    printf("Latest tech news: %s\n", latest->data);
+    payload_release(latest);
+    tech_news->detach_handle(tech_news, john_handle);
+    
+    tech_news->detach_handle(tech_news, digest_handle);
+    subject_synchronize(tech_news);  // No notify() can still be using it
+    
+    printf("\n--- Async dispatch ---\n");
+    
+    // A slow mail server no longer holds up the broadcast
+    ((EmailSubscriber*)jane_email)->send_delay_ms = 100;
+    Dispatcher* dispatcher = create_dispatcher(4);
+    subject_enable_async(sports_news, dispatcher);
+    
+    const char* headlines[] = {
+        "Marathon record broken in Berlin!",
+        "Underdogs win the championship!",
+        "Star striker signs record contract!"
+    };
+    for (int i = 0; i < 3; i++) {
+        struct timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        sports_news->set_state(sports_news, headlines[i]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        long micros = (end.tv_sec - begin.tv_sec) * 1000000L + (end.tv_nsec - begin.tv_nsec) / 1000;
+        printf("⚡ set_state returned after %ld us\n", micros);
+    }
+    dispatcher_flush(dispatcher);  // Wait for every subscriber to catch up
+    subject_enable_async(sports_news, NULL);
+    destroy_dispatcher(dispatcher);
+    
     printf("\n--- Observer Pattern Benefits Demonstrated ---\n");
     printf("✅ Loose coupling: Subjects don't know specific observer types\n");
     printf("✅ Dynamic subscription: Observers can subscribe/unsubscribe at runtime\n");
@@ -309,4 +1095,5 @@ int main() {
     mobile_digest->destroy(mobile_digest);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
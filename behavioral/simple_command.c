@@ -149,6 +149,39 @@ Command* create_brightness_command(Light* light, int brightness) {
     return (Command*)cmd;
 }
 
+// Command 4: Macro (several commands behind one button)
+typedef struct {
+    Command base;
+    Command** steps;
+    int step_count;
+} MacroCommand;
+
+void macro_execute(Command* self) {
+    MacroCommand* cmd = (MacroCommand*)self;
+    for (int i = 0; i < cmd->step_count; i++) {
+        printf("  Step %d: ", i + 1);
+        cmd->steps[i]->execute(cmd->steps[i]);
+    }
+}
+
+void macro_undo(Command* self) {
+    MacroCommand* cmd = (MacroCommand*)self;
+    // Undo in reverse order so each step sees the state it produced
+    for (int i = cmd->step_count - 1; i >= 0; i--) {
+        cmd->steps[i]->undo(cmd->steps[i]);
+    }
+}
+
+Command* create_macro_command(const char* name, Command** steps, int step_count) {
+    MacroCommand* cmd = malloc(sizeof(MacroCommand));
+    strcpy(cmd->base.name, name);
+    cmd->steps = steps;
+    cmd->step_count = step_count;
+    cmd->base.execute = macro_execute;
+    cmd->base.undo = macro_undo;
+    return (Command*)cmd;
+}
+
 // =============================================================================
 // STEP 4: Simple Remote Control (stores and executes commands)
 // =============================================================================
@@ -227,14 +260,13 @@ int main() {
     
     printf("\n--- Command Pattern as Macro ---\n");
     
-    // You can store commands and execute them later (like a macro)
+    // You can store commands and execute them later (like a macro).
+    // The macro is one command, so one press and one UNDO cover all steps.
     Command* bedtime_routine[] = {turn_on, dim, turn_off};
+    Command* bedtime = create_macro_command("Bedtime Routine", bedtime_routine, 3);
     
-    printf("Executing bedtime routine:\n");
-    for (int i = 0; i < 3; i++) {
-        printf("  Step %d: ", i + 1);
-        bedtime_routine[i]->execute(bedtime_routine[i]);
-    }
+    press_button(remote, bedtime);
+    press_undo(remote);
     
     printf("\n✨ Command Pattern Benefits:\n");
     printf("   • Actions become objects you can store and pass around\n");
@@ -250,6 +282,7 @@ int main() {
     free(turn_off);
     free(dim);
     free(bright);
+    free(bedtime);
     
     return 0;
 }
\ No newline at end of file
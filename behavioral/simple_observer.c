@@ -27,36 +27,64 @@ struct Observer {
 // STEP 2: Define what a Subject (thing being observed) looks like
 // =============================================================================
 
-#define MAX_OBSERVERS 5
-
+// The list grows as needed. subscribe() hands back a "handle" (a ticket
+// number); unsubscribe() uses it to find the observer instantly and fills
+// the gap with the last observer (swap-remove), so nothing is shifted.
 typedef struct {
-    Observer* observers[MAX_OBSERVERS];  // List of who's watching
-    int observer_count;                  // How many are watching
-    char current_status[100];            // Current state
+    Observer** observers;     // Packed list of who's watching
+    int* handle_at;           // handle_at[position] = handle of that observer
+    int observer_count;       // How many are watching
+    int capacity;
+    int* position_of;         // position_of[handle] = where it is, -1 if gone
+    int handle_count;         // Handles handed out so far
+    int* free_handles;        // Handles we can give out again
+    int free_count;
+    char current_status[100]; // Current state
 } Subject;
 
-// Add someone to watch this subject
-void subscribe(Subject* subject, Observer* observer) {
-    if (subject->observer_count < MAX_OBSERVERS) {
-        subject->observers[subject->observer_count] = observer;
-        subject->observer_count++;
-        printf("✅ %s subscribed\n", observer->name);
+// Add someone to watch this subject, returns their handle
+int subscribe(Subject* subject, Observer* observer) {
+    if (subject->observer_count == subject->capacity) {
+        subject->capacity = subject->capacity ? subject->capacity * 2 : 4;
+        subject->observers = realloc(subject->observers, subject->capacity * sizeof(Observer*));
+        subject->handle_at = realloc(subject->handle_at, subject->capacity * sizeof(int));
+    }
+    
+    int handle;
+    if (subject->free_count > 0) {
+        handle = subject->free_handles[--subject->free_count];
+    } else {
+        handle = subject->handle_count++;
+        subject->position_of = realloc(subject->position_of, subject->handle_count * sizeof(int));
+        subject->free_handles = realloc(subject->free_handles, subject->handle_count * sizeof(int));
     }
+    
+    int position = subject->observer_count++;
+    subject->observers[position] = observer;
+    subject->handle_at[position] = handle;
+    subject->position_of[handle] = position;
+    printf("✅ %s subscribed\n", observer->name);
+    return handle;
 }
 
-// Remove someone from watching
-void unsubscribe(Subject* subject, Observer* observer) {
-    for (int i = 0; i < subject->observer_count; i++) {
-        if (subject->observers[i] == observer) {
-            // Move everyone else down
-            for (int j = i; j < subject->observer_count - 1; j++) {
-                subject->observers[j] = subject->observers[j + 1];
-            }
-            subject->observer_count--;
-            printf("❌ %s unsubscribed\n", observer->name);
-            return;
-        }
+// Remove someone from watching using their handle
+void unsubscribe(Subject* subject, int handle) {
+    if (handle < 0 || handle >= subject->handle_count || subject->position_of[handle] < 0) {
+        return;
     }
+    
+    int position = subject->position_of[handle];
+    int last = subject->observer_count - 1;
+    printf("❌ %s unsubscribed\n", subject->observers[position]->name);
+    
+    // Move the last observer into the gap
+    subject->observers[position] = subject->observers[last];
+    subject->handle_at[position] = subject->handle_at[last];
+    subject->position_of[subject->handle_at[position]] = position;
+    subject->observer_count--;
+    
+    subject->position_of[handle] = -1;
+    subject->free_handles[subject->free_count++] = handle;
 }
 
 // Tell everyone something changed!
@@ -116,8 +144,7 @@ Observer* create_sms_subscriber(const char* name) {
 // =============================================================================
 
 Subject* create_weather_station() {
-    Subject* station = malloc(sizeof(Subject));
-    station->observer_count = 0;
+    Subject* station = calloc(1, sizeof(Subject));
     strcpy(station->current_status, "Unknown");
     return station;
 }
@@ -140,7 +167,7 @@ int main() {
     printf("--- Setting up subscriptions ---\n");
     // People subscribe to weather updates
     subscribe(weather_station, alice_email);
-    subscribe(weather_station, bob_phone);
+    int bob_handle = subscribe(weather_station, bob_phone);
     subscribe(weather_station, charlie_sms);
     
     printf("\n--- Weather changes, everyone gets notified ---\n");
@@ -150,7 +177,7 @@ int main() {
     
     printf("\n--- Someone unsubscribes ---\n");
     // Bob doesn't want notifications anymore
-    unsubscribe(weather_station, bob_phone);
+    unsubscribe(weather_station, bob_handle);
     
     printf("\n--- Weather changes again ---\n");
     // Only Alice and Charlie get notified now
@@ -168,6 +195,10 @@ int main() {
     printf("   • Loose coupling between weather station and subscribers\n");
     
     // Cleanup
+    free(weather_station->observers);
+    free(weather_station->handle_at);
+    free(weather_station->position_of);
+    free(weather_station->free_handles);
     free(weather_station);
     free(alice_email);
     free(bob_phone);
@@ -17,16 +17,74 @@
  * Cons:
  * - Increased number of classes
  * - Overhead for simple state machines
+ *
+ * Table-driven fleets: every state also declares, per event, an action
+ * ID and the state it moves to. compile_vending_table() packs those
+ * declarations into a dense (state x event) table. A VendingFleet keeps
+ * millions of machines as columns of small integers, and
+ * fleet_apply_events() runs a batch of events as one table-lookup loop.
+ *
+ * Concurrent frontends: stock counters are atomic and only change by
+ * compare-and-swap (take_stock), so two dispenses cannot both get the
+ * last item. Frontends do not call the state handlers themselves. They
+ * push events onto the machine's lock-free queue, and one consumer
+ * drains it, so transitions happen one at a time. The consumer also
+ * appends each event to a binary log that replay_event_log() can run
+ * through the fleet table to rebuild the machines at startup.
+ *
+ * Compile with: gcc -pthread state.c
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 // Forward declarations
 typedef struct VendingMachine VendingMachine;
 typedef struct State State;
 
+#define PRODUCT_COUNT 5
+
+// IDs for the table-driven mode
+typedef enum {
+    STATE_IDLE,
+    STATE_COIN_INSERTED,
+    STATE_PRODUCT_SELECTED,
+    STATE_DISPENSING,
+    STATE_OUT_OF_ORDER,
+    STATE_COUNT
+} StateId;
+
+typedef enum {
+    EVENT_INSERT_COIN,
+    EVENT_SELECT_PRODUCT,
+    EVENT_DISPENSE,
+    EVENT_CANCEL,
+    EVENT_COUNT
+} EventId;
+
+// What the state's handler does, as data. ACTION_SELECT only moves on
+// when the product is in stock and paid for; the others always do.
+typedef enum {
+    ACTION_REJECT,        // Print an error, change nothing
+    ACTION_ADD_COIN,
+    ACTION_SELECT,
+    ACTION_DISPENSE,      // Passes through Dispensing back to Idle
+    ACTION_REFUND,
+    ACTION_COUNT
+} ActionId;
+
+typedef struct {
+    uint8_t action;
+    uint8_t next_state;
+} Transition;
+
 // State interface
 struct State {
     char name[50];
@@ -35,15 +93,32 @@ struct State {
     void (*dispense)(State* self, VendingMachine* machine);
     void (*cancel)(State* self, VendingMachine* machine);
     void (*display_message)(State* self);
+    
+    // Table-driven mode: mirrors the handlers above
+    StateId id;
+    Transition transitions[EVENT_COUNT];
 };
 
+// Fill in a state's transitions, one per event
+static void declare_transitions(State* state, StateId id,
+                                Transition insert_coin, Transition select_product,
+                                Transition dispense, Transition cancel) {
+    state->id = id;
+    state->transitions[EVENT_INSERT_COIN] = insert_coin;
+    state->transitions[EVENT_SELECT_PRODUCT] = select_product;
+    state->transitions[EVENT_DISPENSE] = dispense;
+    state->transitions[EVENT_CANCEL] = cancel;
+}
+
+#define REJECT(state) ((Transition){ACTION_REJECT, state})
+
 // Context: Vending Machine
 struct VendingMachine {
     State* current_state;
     int inserted_amount;
     int selected_product_price;
     char selected_product_name[100];
-    int product_stock[5];  // Stock for 5 different products
+    atomic_int product_stock[5];  // Stock for 5 different products; take with take_stock()
     char product_names[5][50];
     int product_prices[5];
     
@@ -51,6 +126,18 @@ struct VendingMachine {
     void (*display_status)(VendingMachine* self);
 };
 
+// Take one item off a shelf unless it is empty. Returns 1 if we got it.
+int take_stock(atomic_int* stock) {
+    int current = atomic_load_explicit(stock, memory_order_relaxed);
+    while (current > 0) {
+        if (atomic_compare_exchange_weak_explicit(stock, &current, current - 1,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 // Forward declare states
 State* get_idle_state();
 State* get_coin_inserted_state();
@@ -143,6 +230,9 @@ State* get_idle_state() {
         idle_state.base.dispense = idle_dispense;
         idle_state.base.cancel = idle_cancel;
         idle_state.base.display_message = idle_display_message;
+        declare_transitions(&idle_state.base, STATE_IDLE,
+                            (Transition){ACTION_ADD_COIN, STATE_COIN_INSERTED},
+                            REJECT(STATE_IDLE), REJECT(STATE_IDLE), REJECT(STATE_IDLE));
     }
     return (State*)&idle_state;
 }
@@ -208,6 +298,11 @@ State* get_coin_inserted_state() {
         coin_inserted_state.base.dispense = coin_inserted_dispense;
         coin_inserted_state.base.cancel = coin_inserted_cancel;
         coin_inserted_state.base.display_message = coin_inserted_display_message;
+        declare_transitions(&coin_inserted_state.base, STATE_COIN_INSERTED,
+                            (Transition){ACTION_ADD_COIN, STATE_COIN_INSERTED},
+                            (Transition){ACTION_SELECT, STATE_PRODUCT_SELECTED},
+                            REJECT(STATE_COIN_INSERTED),
+                            (Transition){ACTION_REFUND, STATE_IDLE});
     }
     return (State*)&coin_inserted_state;
 }
@@ -252,6 +347,11 @@ State* get_product_selected_state() {
         product_selected_state.base.dispense = product_selected_dispense;
         product_selected_state.base.cancel = product_selected_cancel;
         product_selected_state.base.display_message = product_selected_display_message;
+        declare_transitions(&product_selected_state.base, STATE_PRODUCT_SELECTED,
+                            (Transition){ACTION_ADD_COIN, STATE_PRODUCT_SELECTED},
+                            REJECT(STATE_PRODUCT_SELECTED),
+                            (Transition){ACTION_DISPENSE, STATE_IDLE},
+                            (Transition){ACTION_REFUND, STATE_IDLE});
     }
     return (State*)&product_selected_state;
 }
@@ -275,7 +375,16 @@ void dispensing_dispense(State* self, VendingMachine* machine) {
     // Find product index and reduce stock
     for (int i = 0; i < 5; i++) {
         if (strcmp(machine->product_names[i], machine->selected_product_name) == 0) {
-            machine->product_stock[i]--;
+            if (!take_stock(&machine->product_stock[i])) {
+                // Someone else took the last one since it was selected
+                printf("❌ %s sold out\n", machine->selected_product_name);
+                printf("💰 Returning $%.2f\n", machine->inserted_amount / 100.0);
+                machine->inserted_amount = 0;
+                strcpy(machine->selected_product_name, "");
+                machine->selected_product_price = 0;
+                machine->set_state(machine, get_idle_state());
+                return;
+            }
             break;
         }
     }
@@ -313,6 +422,9 @@ State* get_dispensing_state() {
         dispensing_state.base.dispense = dispensing_dispense;
         dispensing_state.base.cancel = dispensing_cancel;
         dispensing_state.base.display_message = dispensing_display_message;
+        declare_transitions(&dispensing_state.base, STATE_DISPENSING,
+                            REJECT(STATE_DISPENSING), REJECT(STATE_DISPENSING),
+                            (Transition){ACTION_DISPENSE, STATE_IDLE}, REJECT(STATE_DISPENSING));
     }
     return (State*)&dispensing_state;
 }
@@ -351,6 +463,9 @@ State* get_out_of_order_state() {
         out_of_order_state.base.dispense = out_of_order_dispense;
         out_of_order_state.base.cancel = out_of_order_cancel;
         out_of_order_state.base.display_message = out_of_order_display_message;
+        declare_transitions(&out_of_order_state.base, STATE_OUT_OF_ORDER,
+                            REJECT(STATE_OUT_OF_ORDER), REJECT(STATE_OUT_OF_ORDER),
+                            REJECT(STATE_OUT_OF_ORDER), REJECT(STATE_OUT_OF_ORDER));
     }
     return (State*)&out_of_order_state;
 }
@@ -361,6 +476,427 @@ void destroy_vending_machine(VendingMachine* machine) {
     }
 }
 
+// ---- Table-driven fleet ----
+
+typedef struct {
+    Transition entries[STATE_COUNT][EVENT_COUNT];
+} VendingTable;
+
+// Gather every state's declared transitions into one dense table
+void compile_vending_table(VendingTable* table) {
+    State* states[] = {get_idle_state(), get_coin_inserted_state(), get_product_selected_state(),
+                       get_dispensing_state(), get_out_of_order_state()};
+    for (int i = 0; i < STATE_COUNT; i++) {
+        memcpy(table->entries[states[i]->id], states[i]->transitions, sizeof(states[i]->transitions));
+    }
+}
+
+State* state_for_id(StateId id) {
+    switch (id) {
+        case STATE_IDLE: return get_idle_state();
+        case STATE_COIN_INSERTED: return get_coin_inserted_state();
+        case STATE_PRODUCT_SELECTED: return get_product_selected_state();
+        case STATE_DISPENSING: return get_dispensing_state();
+        default: return get_out_of_order_state();
+    }
+}
+
+// Every machine is one row across these columns (11 bytes per machine).
+// All machines share one price list.
+typedef struct {
+    int count;
+    int capacity;
+    uint8_t* state;
+    int32_t* inserted_amount;             // Cents
+    uint8_t* selected;                    // Product index while a product is selected
+    uint8_t (*stock)[PRODUCT_COUNT];
+    int32_t prices[PRODUCT_COUNT];
+    VendingTable table;
+} VendingFleet;
+
+// One event for one machine: 8 bytes
+typedef struct {
+    uint32_t machine;
+    uint8_t event;                        // EventId
+    uint8_t product_id;                   // 1..PRODUCT_COUNT, for EVENT_SELECT_PRODUCT
+    uint16_t amount;                      // Cents, for EVENT_INSERT_COIN
+} FleetEvent;
+
+typedef struct {
+    long events;
+    long rejected;
+    long dispensed;
+    long sales;                           // Cents
+    long change_returned;                 // Cents
+    long refunded;                        // Cents
+} FleetStats;
+
+// Prices come from 'model', as does each new machine's start (see fleet_add_machine)
+VendingFleet* create_vending_fleet(int capacity, VendingMachine* model) {
+    VendingFleet* fleet = (VendingFleet*)calloc(1, sizeof(VendingFleet));
+    fleet->capacity = capacity;
+    fleet->state = (uint8_t*)malloc(capacity * sizeof(uint8_t));
+    fleet->inserted_amount = (int32_t*)malloc(capacity * sizeof(int32_t));
+    fleet->selected = (uint8_t*)malloc(capacity * sizeof(uint8_t));
+    fleet->stock = malloc(capacity * sizeof(*fleet->stock));
+    for (int p = 0; p < PRODUCT_COUNT; p++) {
+        fleet->prices[p] = model->product_prices[p];
+    }
+    compile_vending_table(&fleet->table);
+    return fleet;
+}
+
+// Copy a machine into the fleet; returns its index, or -1 if full
+int fleet_add_machine(VendingFleet* fleet, VendingMachine* machine) {
+    if (fleet->count == fleet->capacity) return -1;
+    int m = fleet->count++;
+    fleet->state[m] = (uint8_t)machine->current_state->id;
+    fleet->inserted_amount[m] = machine->inserted_amount;
+    fleet->selected[m] = 0;
+    for (int p = 0; p < PRODUCT_COUNT; p++) {
+        fleet->stock[m][p] = (uint8_t)machine->product_stock[p];
+        if (strcmp(machine->product_names[p], machine->selected_product_name) == 0) {
+            fleet->selected[m] = (uint8_t)p;
+        }
+    }
+    return m;
+}
+
+// Run 'count' events in order; 'stats' is added to
+void fleet_apply_events(VendingFleet* fleet, const FleetEvent* events, int count, FleetStats* stats) {
+    long rejected = 0, dispensed = 0, sales = 0, change = 0, refunded = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t m = events[i].machine;
+        uint8_t state = fleet->state[m];
+        Transition t = fleet->table.entries[state][events[i].event];
+        int moved = 1;
+        switch (t.action) {
+            case ACTION_ADD_COIN:
+                fleet->inserted_amount[m] += events[i].amount;
+                break;
+            case ACTION_SELECT: {
+                unsigned p = events[i].product_id - 1u;
+                moved = p < PRODUCT_COUNT && fleet->stock[m][p] > 0 &&
+                        fleet->inserted_amount[m] >= fleet->prices[p];
+                if (moved) fleet->selected[m] = (uint8_t)p;
+                break;
+            }
+            case ACTION_DISPENSE: {
+                unsigned p = fleet->selected[m];
+                fleet->stock[m][p]--;
+                sales += fleet->prices[p];
+                change += fleet->inserted_amount[m] - fleet->prices[p];
+                fleet->inserted_amount[m] = 0;
+                dispensed++;
+                break;
+            }
+            case ACTION_REFUND:
+                refunded += fleet->inserted_amount[m];
+                fleet->inserted_amount[m] = 0;
+                break;
+            default:
+                moved = 0;
+                break;
+        }
+        rejected += !moved;
+        fleet->state[m] = moved ? t.next_state : state;
+    }
+    stats->events += count;
+    stats->rejected += rejected;
+    stats->dispensed += dispensed;
+    stats->sales += sales;
+    stats->change_returned += change;
+    stats->refunded += refunded;
+}
+
+void destroy_vending_fleet(VendingFleet* fleet) {
+    if (fleet) {
+        free(fleet->state);
+        free(fleet->inserted_amount);
+        free(fleet->selected);
+        free(fleet->stock);
+        free(fleet);
+    }
+}
+
+// ---- Concurrent frontends ----
+
+// Run one event through the machine's current state
+void vending_machine_handle(VendingMachine* machine, const FleetEvent* event) {
+    State* state = machine->current_state;
+    switch (event->event) {
+        case EVENT_INSERT_COIN: state->insert_coin(state, machine, event->amount); break;
+        case EVENT_SELECT_PRODUCT: state->select_product(state, machine, event->product_id); break;
+        case EVENT_DISPENSE: state->dispense(state, machine); break;
+        case EVENT_CANCEL: state->cancel(state, machine); break;
+    }
+}
+
+// Bounded lock-free queue, many producers and one consumer. Each slot's
+// sequence says whose turn it is: pos means free for the producer that
+// claims pos, pos + 1 means filled and waiting for the consumer.
+typedef struct {
+    atomic_size_t sequence;
+    FleetEvent event;
+} EventSlot;
+
+typedef struct {
+    EventSlot* slots;
+    size_t mask;                          // Capacity - 1; capacity is a power of two
+    _Alignas(64) atomic_size_t tail;      // Next position producers claim
+    _Alignas(64) size_t head;             // Next position the consumer reads
+} EventQueue;
+
+void event_queue_init(EventQueue* queue, size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    queue->slots = (EventSlot*)malloc(size * sizeof(EventSlot));
+    queue->mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    atomic_init(&queue->tail, 0);
+    queue->head = 0;
+}
+
+// Returns 0 if the queue is full
+int event_queue_push(EventQueue* queue, const FleetEvent* event) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    for (;;) {
+        EventSlot* slot = &queue->slots[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->event = *event;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return 1;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+// Consumer only. Returns 0 if nothing is waiting.
+int event_queue_pop(EventQueue* queue, FleetEvent* event) {
+    EventSlot* slot = &queue->slots[queue->head & queue->mask];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != queue->head + 1) {
+        return 0;
+    }
+    *event = slot->event;
+    atomic_store_explicit(&slot->sequence, queue->head + queue->mask + 1, memory_order_release);
+    queue->head++;
+    return 1;
+}
+
+void event_queue_destroy(EventQueue* queue) {
+    free(queue->slots);
+}
+
+// Append-only event log: a header, then fixed-size FleetEvent records.
+// A torn record at the end (crash mid-write) is ignored on replay and
+// cut off when the log is reopened for appending.
+#define EVENT_LOG_MAGIC 0x444E4556u       // "VEND"
+#define EVENT_LOG_VERSION 1
+#define EVENT_LOG_BUFFER 4096
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+} EventLogHeader;
+
+typedef struct {
+    FILE* file;
+    int buffered;
+    long appended;
+    FleetEvent buffer[EVENT_LOG_BUFFER];
+} EventLog;
+
+// Opens for appending, writing the header if the file is new. An existing
+// file must carry our header; a torn record at its end is cut off so new
+// records start on a record boundary. NULL on failure or a foreign file.
+EventLog* open_event_log(const char* path) {
+    FILE* file = fopen(path, "r+b");
+    if (!file) file = fopen(path, "w+b");
+    if (!file) return NULL;
+    EventLogHeader expected = {EVENT_LOG_MAGIC, EVENT_LOG_VERSION, sizeof(FleetEvent)};
+    EventLogHeader header;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    if (size == 0) {
+        fwrite(&expected, sizeof(expected), 1, file);
+        size = sizeof(expected);
+    } else {
+        rewind(file);
+        if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != expected.magic ||
+            header.version != expected.version || header.record_size != expected.record_size) {
+            fclose(file);
+            return NULL;
+        }
+        long whole = sizeof(header) + (size - (long)sizeof(header)) / sizeof(FleetEvent) * sizeof(FleetEvent);
+        if (whole != size && ftruncate(fileno(file), whole) != 0) {
+            fclose(file);
+            return NULL;
+        }
+        size = whole;
+    }
+    fseek(file, size, SEEK_SET);
+    EventLog* log = (EventLog*)malloc(sizeof(EventLog));
+    log->file = file;
+    log->buffered = 0;
+    log->appended = 0;
+    return log;
+}
+
+void event_log_flush(EventLog* log) {
+    fwrite(log->buffer, sizeof(FleetEvent), log->buffered, log->file);
+    fflush(log->file);
+    log->buffered = 0;
+}
+
+void event_log_append(EventLog* log, const FleetEvent* event) {
+    log->buffer[log->buffered++] = *event;
+    log->appended++;
+    if (log->buffered == EVENT_LOG_BUFFER) {
+        event_log_flush(log);
+    }
+}
+
+void close_event_log(EventLog* log) {
+    if (log) {
+        event_log_flush(log);
+        fclose(log->file);
+        free(log);
+    }
+}
+
+// 1 if every record in the rest of 'file' names a machine and event
+// 'fleet' has
+static int event_log_records_valid(FILE* file, FleetEvent* chunk, const VendingFleet* fleet) {
+    size_t read;
+    while ((read = fread(chunk, sizeof(FleetEvent), EVENT_LOG_BUFFER, file)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            if (chunk[i].machine >= (uint32_t)fleet->count || chunk[i].event >= EVENT_COUNT) return 0;
+        }
+    }
+    return 1;
+}
+
+// Run every logged event through 'fleet', whose machines must start as
+// they were when the log began. Returns the number of events replayed,
+// or -1 if the file is missing, not an event log, or names a machine
+// or event the fleet does not have. The whole log is checked before
+// anything is applied, so on -1 the fleet is untouched.
+long replay_event_log(const char* path, VendingFleet* fleet, FleetStats* stats) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return -1;
+    EventLogHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != EVENT_LOG_MAGIC ||
+        header.version != EVENT_LOG_VERSION || header.record_size != sizeof(FleetEvent)) {
+        fclose(file);
+        return -1;
+    }
+    
+    FleetEvent* chunk = (FleetEvent*)malloc(EVENT_LOG_BUFFER * sizeof(FleetEvent));
+    if (!event_log_records_valid(file, chunk, fleet)) {
+        free(chunk);
+        fclose(file);
+        return -1;
+    }
+    
+    fseek(file, sizeof(header), SEEK_SET);
+    long replayed = 0;
+    size_t read;
+    while ((read = fread(chunk, sizeof(FleetEvent), EVENT_LOG_BUFFER, file)) > 0) {
+        fleet_apply_events(fleet, chunk, (int)read, stats);
+        replayed += (long)read;
+    }
+    free(chunk);
+    fclose(file);
+    return replayed;
+}
+
+// A machine that several frontends can drive at once
+typedef struct {
+    VendingMachine* machine;
+    uint32_t machine_id;                  // Written into log records
+    EventQueue queue;
+    EventLog* log;                        // Optional
+} SharedVendingMachine;
+
+SharedVendingMachine* create_shared_machine(VendingMachine* machine, uint32_t machine_id,
+                                            size_t queue_capacity, EventLog* log) {
+    SharedVendingMachine* shared = (SharedVendingMachine*)malloc(sizeof(SharedVendingMachine));
+    shared->machine = machine;
+    shared->machine_id = machine_id;
+    event_queue_init(&shared->queue, queue_capacity);
+    shared->log = log;
+    return shared;
+}
+
+// Any thread. Returns 0 if the queue is full; try again later.
+int shared_machine_submit(SharedVendingMachine* shared, FleetEvent event) {
+    event.machine = shared->machine_id;
+    return event_queue_push(&shared->queue, &event);
+}
+
+// The consumer thread only: log and apply everything queued so far
+int shared_machine_drain(SharedVendingMachine* shared) {
+    FleetEvent event;
+    int handled = 0;
+    while (event_queue_pop(&shared->queue, &event)) {
+        if (shared->log) event_log_append(shared->log, &event);
+        vending_machine_handle(shared->machine, &event);
+        handled++;
+    }
+    return handled;
+}
+
+void destroy_shared_machine(SharedVendingMachine* shared) {
+    if (shared) {
+        event_queue_destroy(&shared->queue);
+        free(shared);
+    }
+}
+
+// Demo frontends
+typedef struct {
+    SharedVendingMachine* shared;
+    const FleetEvent* script;
+    int count;
+    atomic_int* running;
+} Frontend;
+
+void* frontend_run(void* arg) {
+    Frontend* frontend = (Frontend*)arg;
+    for (int i = 0; i < frontend->count; i++) {
+        while (!shared_machine_submit(frontend->shared, frontend->script[i])) {
+            sched_yield();
+        }
+    }
+    atomic_fetch_sub(frontend->running, 1);
+    return NULL;
+}
+
+typedef struct {
+    atomic_int* shelf;
+    int attempts;
+    int taken;
+} ShelfRaider;
+
+void* shelf_raider_run(void* arg) {
+    ShelfRaider* raider = (ShelfRaider*)arg;
+    for (int i = 0; i < raider->attempts; i++) {
+        raider->taken += take_stock(raider->shelf);
+    }
+    return NULL;
+}
+
 // Example usage
 int main() {
     printf("=== STATE PATTERN EXAMPLE ===\n\n");
@@ -419,12 +955,216 @@ int main() {
     machine->current_state->select_product(machine->current_state, machine, 3); // Water
     machine->current_state->cancel(machine->current_state, machine);
     
+    printf("\n--- Table-Driven Fleet ---\n");
+    
+    // The same purchase on an object machine and on a one-machine fleet
+    VendingMachine* reference = create_vending_machine();
+    VendingFleet* single = create_vending_fleet(1, reference);
+    fleet_add_machine(single, reference);
+    FleetEvent script[] = {
+        {0, EVENT_INSERT_COIN, 0, 100}, {0, EVENT_SELECT_PRODUCT, 4, 0},
+        {0, EVENT_INSERT_COIN, 0, 150}, {0, EVENT_SELECT_PRODUCT, 4, 0},
+        {0, EVENT_DISPENSE, 0, 0}, {0, EVENT_CANCEL, 0, 0},
+    };
+    FleetStats single_stats = {0};
+    fleet_apply_events(single, script, 6, &single_stats);
+    reference->current_state->insert_coin(reference->current_state, reference, 100);
+    reference->current_state->select_product(reference->current_state, reference, 4);
+    reference->current_state->insert_coin(reference->current_state, reference, 150);
+    reference->current_state->select_product(reference->current_state, reference, 4);
+    reference->current_state->dispense(reference->current_state, reference);
+    reference->current_state->cancel(reference->current_state, reference);
+    int same = single->state[0] == reference->current_state->id &&
+               single->inserted_amount[0] == reference->inserted_amount;
+    for (int p = 0; p < PRODUCT_COUNT; p++) {
+        same = same && single->stock[0][p] == reference->product_stock[p];
+    }
+    printf("%s Fleet machine ends in %s like the object machine (%ld of 6 events rejected)\n",
+           same ? "✅" : "❌", state_for_id(single->state[0])->name, single_stats.rejected);
+    destroy_vending_fleet(single);
+    
+    // A million machines, ten million events
+    int fleet_size = 1000000;
+    int event_count = 10000000;
+    VendingFleet* fleet = create_vending_fleet(fleet_size, reference);
+    for (int i = 0; i < fleet_size; i++) {
+        fleet_add_machine(fleet, reference);
+    }
+    FleetEvent* events = (FleetEvent*)malloc(event_count * sizeof(FleetEvent));
+    unsigned seed = 99;
+    for (int i = 0; i < event_count; i++) {
+        seed = seed * 1103515245u + 12345u;
+        events[i].machine = (seed >> 8) % fleet_size;
+        seed = seed * 1103515245u + 12345u;
+        events[i].event = (uint8_t)((seed >> 16) % EVENT_COUNT);
+        events[i].product_id = (uint8_t)(1 + (seed >> 20) % PRODUCT_COUNT);
+        events[i].amount = (uint16_t)(25 * (1 + (seed >> 24) % 8));
+    }
+    FleetStats stats = {0};
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fleet_apply_events(fleet, events, event_count, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("⏱️  %ld events over %d machines in %.1f ms\n", stats.events, fleet->count,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    printf("   %ld dispensed, %ld rejected, sales $%.2f, change $%.2f, refunds $%.2f\n",
+           stats.dispensed, stats.rejected, stats.sales / 100.0,
+           stats.change_returned / 100.0, stats.refunded / 100.0);
+    free(events);
+    destroy_vending_fleet(fleet);
+    destroy_vending_machine(reference);
+    
+    printf("\n--- Concurrent Frontends ---\n");
+    
+    // Two threads race for 1000 items
+    atomic_int shelf = 1000;
+    ShelfRaider raiders[2] = {{&shelf, 1000, 0}, {&shelf, 1000, 0}};
+    pthread_t raider_threads[2];
+    for (int t = 0; t < 2; t++) {
+        pthread_create(&raider_threads[t], NULL, shelf_raider_run, &raiders[t]);
+    }
+    for (int t = 0; t < 2; t++) {
+        pthread_join(raider_threads[t], NULL);
+    }
+    printf("%s Two frontends took %d + %d of 1000 items, %d left\n",
+           raiders[0].taken + raiders[1].taken == 1000 && shelf == 0 ? "✅" : "❌",
+           raiders[0].taken, raiders[1].taken, atomic_load(&shelf));
+    
+    // A coin acceptor and a network API drive one machine through its queue
+    const char* log_path = "vending_events.log";
+    remove(log_path);
+    EventLog* log = open_event_log(log_path);
+    VendingMachine* kiosk = create_vending_machine();
+    SharedVendingMachine* shared = create_shared_machine(kiosk, 0, 64, log);
+    FleetEvent coins[] = {
+        {0, EVENT_INSERT_COIN, 0, 100}, {0, EVENT_INSERT_COIN, 0, 100},
+        {0, EVENT_INSERT_COIN, 0, 25}, {0, EVENT_INSERT_COIN, 0, 100},
+    };
+    FleetEvent api[] = {
+        {0, EVENT_SELECT_PRODUCT, 3, 0}, {0, EVENT_DISPENSE, 0, 0},
+        {0, EVENT_SELECT_PRODUCT, 5, 0}, {0, EVENT_DISPENSE, 0, 0}, {0, EVENT_CANCEL, 0, 0},
+    };
+    atomic_int running = 2;
+    Frontend frontends[2] = {{shared, coins, 4, &running}, {shared, api, 5, &running}};
+    pthread_t frontend_threads[2];
+    for (int t = 0; t < 2; t++) {
+        pthread_create(&frontend_threads[t], NULL, frontend_run, &frontends[t]);
+    }
+    while (atomic_load(&running) > 0) {
+        if (!shared_machine_drain(shared)) sched_yield();
+    }
+    shared_machine_drain(shared);
+    for (int t = 0; t < 2; t++) {
+        pthread_join(frontend_threads[t], NULL);
+    }
+    long logged = log->appended;
+    close_event_log(log);
+    
+    // Rebuild the kiosk from its log, as if restarting
+    VendingMachine* fresh = create_vending_machine();
+    VendingFleet* rebuilt = create_vending_fleet(1, fresh);
+    fleet_add_machine(rebuilt, fresh);
+    FleetStats replay_stats = {0};
+    long replayed = replay_event_log(log_path, rebuilt, &replay_stats);
+    int restored = replayed == logged && rebuilt->state[0] == kiosk->current_state->id &&
+                   rebuilt->inserted_amount[0] == kiosk->inserted_amount;
+    for (int p = 0; p < PRODUCT_COUNT; p++) {
+        restored = restored && rebuilt->stock[0][p] == kiosk->product_stock[p];
+    }
+    printf("%s Replayed %ld logged events: %s with $%.2f inserted, like the live kiosk\n",
+           restored ? "✅" : "❌", replayed, state_for_id(rebuilt->state[0])->name,
+           rebuilt->inserted_amount[0] / 100.0);
+    
+    // A crash mid-write leaves a torn record; reopening cuts it off so the
+    // next record still lines up
+    FILE* raw = fopen(log_path, "ab");
+    fwrite(&coins[0], 3, 1, raw);
+    fclose(raw);
+    log = open_event_log(log_path);
+    FleetEvent refund = {0, EVENT_CANCEL, 0, 0};
+    event_log_append(log, &refund);
+    close_event_log(log);
+    raw = fopen(log_path, "rb");
+    fseek(raw, 0, SEEK_END);
+    long log_bytes = ftell(raw);
+    fclose(raw);
+    printf("%s Torn record cut off on reopen: %ld bytes = header + %ld records\n",
+           log_bytes == (long)(sizeof(EventLogHeader) + (logged + 1) * sizeof(FleetEvent)) ? "✅" : "❌",
+           log_bytes, logged + 1);
+    
+    const char* foreign_path = "not_an_event_log.txt";
+    raw = fopen(foreign_path, "wb");
+    fputs("shopping list: coins, snacks\n", raw);
+    fclose(raw);
+    EventLog* foreign = open_event_log(foreign_path);
+    printf("%s A file without the log header is not appended to\n", foreign == NULL ? "✅" : "❌");
+    close_event_log(foreign);
+    remove(foreign_path);
+    
+    // A record for a machine the fleet lacks rejects the whole log up front
+    log = open_event_log(log_path);
+    FleetEvent stray = {7, EVENT_INSERT_COIN, 0, 100};
+    event_log_append(log, &stray);
+    close_event_log(log);
+    VendingFleet* rejected = create_vending_fleet(1, fresh);
+    fleet_add_machine(rejected, fresh);
+    FleetStats rejected_stats = {0};
+    long rejected_count = replay_event_log(log_path, rejected, &rejected_stats);
+    int untouched = rejected_count == -1 && rejected_stats.dispensed == 0;
+    for (int p = 0; p < PRODUCT_COUNT; p++) {
+        untouched = untouched && rejected->stock[0][p] == fresh->product_stock[p];
+    }
+    printf("%s Log naming machine 7 rejected (%ld) before any of its %ld events were applied\n",
+           untouched ? "✅" : "❌", rejected_count, logged + 2);
+    destroy_vending_fleet(rejected);
+    destroy_vending_fleet(rebuilt);
+    destroy_shared_machine(shared);
+    destroy_vending_machine(kiosk);
+    
+    // Startup replay speed: a million logged events over a thousand machines
+    int logged_machines = 1000;
+    int logged_events = 1000000;
+    VendingFleet* live = create_vending_fleet(logged_machines, fresh);
+    VendingFleet* restarted = create_vending_fleet(logged_machines, fresh);
+    for (int i = 0; i < logged_machines; i++) {
+        fleet_add_machine(live, fresh);
+        fleet_add_machine(restarted, fresh);
+    }
+    remove(log_path);
+    log = open_event_log(log_path);
+    FleetStats live_stats = {0};
+    for (int i = 0; i < logged_events; i++) {
+        seed = seed * 1103515245u + 12345u;
+        FleetEvent event = {(seed >> 8) % logged_machines, (uint8_t)((seed >> 4) % EVENT_COUNT),
+                            (uint8_t)(1 + (seed >> 20) % PRODUCT_COUNT), (uint16_t)(25 * (1 + (seed >> 24) % 8))};
+        fleet_apply_events(live, &event, 1, &live_stats);
+        event_log_append(log, &event);
+    }
+    close_event_log(log);
+    FleetStats restart_stats = {0};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    replayed = replay_event_log(log_path, restarted, &restart_stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    restored = replayed == logged_events &&
+               memcmp(live->state, restarted->state, logged_machines) == 0 &&
+               memcmp(live->stock, restarted->stock, logged_machines * sizeof(*live->stock)) == 0 &&
+               restart_stats.sales == live_stats.sales;
+    printf("%s Replayed %ld events for %d machines in %.1f ms\n", restored ? "✅" : "❌",
+           replayed, logged_machines,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    remove(log_path);
+    destroy_vending_fleet(live);
+    destroy_vending_fleet(restarted);
+    destroy_vending_machine(fresh);
+    
     printf("\n--- State Pattern Benefits Demonstrated ---\n");
     printf("✅ State-specific behavior is encapsulated in state classes\n");
     printf("✅ State transitions are explicit and controlled\n");
     printf("✅ Easy to add new states without modifying existing code\n");
     printf("✅ Eliminates complex if-else chains\n");
     printf("✅ Each state can have different responses to same input\n");
+    printf("✅ States declared as data compile into a fast transition table\n");
+    printf("✅ One consumer per machine serializes transitions from many frontends\n");
     
     destroy_vending_machine(machine);
     
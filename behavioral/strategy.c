@@ -17,11 +17,53 @@
  * Cons:
  * - Clients must be aware of different strategies
  * - Increased number of objects
+ *
+ * Batch settlement: every strategy's fee is a fixed part plus a rate
+ * times the amount, so each one compiles to a FeeSchedule in whole
+ * cents and parts per million. The processor caches those schedules
+ * for its registered payment methods. process_payment_batch() groups
+ * transactions by method and runs a SIMD fee kernel over each group.
+ * Sums stay exact integer cents, and nothing is printed on the way.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for fee and settlement
+ * microbenchmarks instead of the demo, and with -DPATTERN_COUNTERS for
+ * hot-path counters (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../bench.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SIMD 1
+#endif
+
+HOT_COUNTER(strategy_batches, "strategy", "settlement batches");
+HOT_COUNTER(strategy_settled, "strategy", "transactions settled");
+HOT_COUNTER(strategy_rejected, "strategy", "transactions rejected");
+HOT_COUNTER(strategy_kernel_calls, "strategy", "fee kernel calls");
+
+// A fee as integers: fixed_cents + amount * rate_ppm / 1,000,000, with
+// the rate part rounded to the nearest cent (ties to even). Batches only
+// take rates from 0 to MAX_RATE_PPM.
+#define MAX_RATE_PPM 1000000             // 100%
+
+typedef struct {
+    int32_t fixed_cents;
+    int32_t rate_ppm;
+} FeeSchedule;
+
+// Non-negative dollars or rates to whole units of 1/scale
+static int32_t to_fixed(double value, double scale) {
+    return (int32_t)(value * scale + 0.5);
+}
 
 // Strategy interface
 typedef struct PaymentStrategy PaymentStrategy;
@@ -29,9 +71,117 @@ struct PaymentStrategy {
     char name[50];
     double (*calculate_fee)(PaymentStrategy* self, double amount);
     void (*process_payment)(PaymentStrategy* self, double amount, const char* description);
+    FeeSchedule (*fee_schedule)(PaymentStrategy* self);
     void (*destroy)(PaymentStrategy* self);
 };
 
+// ---- Fee kernels ----
+// Exact as long as 0 <= rate_ppm <= MAX_RATE_PPM, which
+// register_payment_method() checks. |amount * rate_ppm| is then at most
+// 2^31 * 1e6 < 2^51, so the product is exact in a double. The quotient
+// (the rate part, at most the amount: under 2^31 cents) is off by at most
+// half of 2^-22, well inside the 1e-6 gap between it and a half cent, so
+// rounding it to the nearest integer gives the exact cent.
+
+typedef struct {
+    const char* name;
+    void (*compute_fees)(const int32_t* amounts, int count, FeeSchedule schedule, int32_t* fees);
+} FeeKernel;
+
+// Adding then subtracting 1.5 * 2^52 rounds a double to the nearest integer
+#define ROUND_MAGIC 0x1.8p52
+
+static void compute_fees_scalar(const int32_t* amounts, int count, FeeSchedule schedule, int32_t* fees) {
+    double rate = schedule.rate_ppm;
+    for (int i = 0; i < count; i++) {
+        double quotient = amounts[i] * rate / 1e6;
+        fees[i] = schedule.fixed_cents + (int32_t)((quotient + ROUND_MAGIC) - ROUND_MAGIC);
+    }
+}
+
+static const FeeKernel scalar_fee_kernel = {"scalar", compute_fees_scalar};
+
+#if HAVE_X86_SIMD
+// Four amounts per step, as two pairs of doubles
+static void compute_fees_sse2(const int32_t* amounts, int count, FeeSchedule schedule, int32_t* fees) {
+    __m128d rate = _mm_set1_pd(schedule.rate_ppm), million = _mm_set1_pd(1e6);
+    __m128d magic = _mm_set1_pd(ROUND_MAGIC);
+    __m128i fixed = _mm_set1_epi32(schedule.fixed_cents);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(amounts + i));
+        __m128d low = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(a), rate), million);
+        __m128d high = _mm_div_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(a, 0xEE)), rate), million);
+        low = _mm_sub_pd(_mm_add_pd(low, magic), magic);
+        high = _mm_sub_pd(_mm_add_pd(high, magic), magic);
+        __m128i rounded = _mm_unpacklo_epi64(_mm_cvttpd_epi32(low), _mm_cvttpd_epi32(high));
+        _mm_storeu_si128((__m128i*)(fees + i), _mm_add_epi32(rounded, fixed));
+    }
+    compute_fees_scalar(amounts + i, count - i, schedule, fees + i);
+}
+
+// Eight amounts per step, as two sets of four doubles
+__attribute__((target("avx2")))
+static void compute_fees_avx2(const int32_t* amounts, int count, FeeSchedule schedule, int32_t* fees) {
+    __m256d rate = _mm256_set1_pd(schedule.rate_ppm), million = _mm256_set1_pd(1e6);
+    __m256i fixed = _mm256_set1_epi32(schedule.fixed_cents);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(amounts + i));
+        __m256d low = _mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)), rate), million);
+        __m256d high = _mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)), rate), million);
+        low = _mm256_round_pd(low, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        high = _mm256_round_pd(high, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256i rounded = _mm256_set_m128i(_mm256_cvttpd_epi32(high), _mm256_cvttpd_epi32(low));
+        _mm256_storeu_si256((__m256i*)(fees + i), _mm256_add_epi32(rounded, fixed));
+    }
+    compute_fees_scalar(amounts + i, count - i, schedule, fees + i);
+}
+
+static const FeeKernel sse2_fee_kernel = {"SSE2", compute_fees_sse2};
+static const FeeKernel avx2_fee_kernel = {"AVX2", compute_fees_avx2};
+#endif
+
+#if HAVE_NEON_SIMD
+static void compute_fees_neon(const int32_t* amounts, int count, FeeSchedule schedule, int32_t* fees) {
+    float64x2_t rate = vdupq_n_f64(schedule.rate_ppm), million = vdupq_n_f64(1e6);
+    int32x4_t fixed = vdupq_n_s32(schedule.fixed_cents);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32x4_t a = vld1q_s32(amounts + i);
+        float64x2_t low = vcvtq_f64_s64(vmovl_s32(vget_low_s32(a)));
+        float64x2_t high = vcvtq_f64_s64(vmovl_s32(vget_high_s32(a)));
+        low = vrndnq_f64(vdivq_f64(vmulq_f64(low, rate), million));
+        high = vrndnq_f64(vdivq_f64(vmulq_f64(high, rate), million));
+        int32x4_t rounded = vcombine_s32(vmovn_s64(vcvtq_s64_f64(low)), vmovn_s64(vcvtq_s64_f64(high)));
+        vst1q_s32(fees + i, vaddq_s32(rounded, fixed));
+    }
+    compute_fees_scalar(amounts + i, count - i, schedule, fees + i);
+}
+
+static const FeeKernel neon_fee_kernel = {"NEON", compute_fees_neon};
+#endif
+
+#define MAX_FEE_KERNELS 3
+
+// Every kernel this CPU can run, best last; returns the count
+int available_fee_kernels(const FeeKernel** kernels) {
+    int count = 0;
+    kernels[count++] = &scalar_fee_kernel;
+#if HAVE_X86_SIMD
+    kernels[count++] = &sse2_fee_kernel;
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = &avx2_fee_kernel;
+#elif HAVE_NEON_SIMD
+    kernels[count++] = &neon_fee_kernel;
+#endif
+    return count;
+}
+
+const FeeKernel* detect_fee_kernel(void) {
+    const FeeKernel* kernels[MAX_FEE_KERNELS];
+    return kernels[available_fee_kernels(kernels) - 1];
+}
+
 // Concrete Strategy 1: Credit Card Payment
 typedef struct {
     PaymentStrategy base;
@@ -60,6 +210,11 @@ void credit_card_process_payment(PaymentStrategy* self, double amount, const cha
     printf("   Status: ✅ Payment Successful\n");
 }
 
+FeeSchedule credit_card_fee_schedule(PaymentStrategy* self) {
+    CreditCardStrategy* cc = (CreditCardStrategy*)self;
+    return (FeeSchedule){0, to_fixed(cc->transaction_fee_rate, 1e6)};
+}
+
 void credit_card_destroy(PaymentStrategy* self) {
     if (self) {
         free(self);
@@ -76,6 +231,7 @@ PaymentStrategy* create_credit_card_strategy(const char* card_number, const char
     
     cc->base.calculate_fee = credit_card_calculate_fee;
     cc->base.process_payment = credit_card_process_payment;
+    cc->base.fee_schedule = credit_card_fee_schedule;
     cc->base.destroy = credit_card_destroy;
     
     return (PaymentStrategy*)cc;
@@ -109,6 +265,11 @@ void paypal_process_payment(PaymentStrategy* self, double amount, const char* de
     printf("   Status: ✅ Payment Successful\n");
 }
 
+FeeSchedule paypal_fee_schedule(PaymentStrategy* self) {
+    PayPalStrategy* pp = (PayPalStrategy*)self;
+    return (FeeSchedule){to_fixed(pp->fixed_fee, 100), to_fixed(pp->percentage_fee, 1e6)};
+}
+
 void paypal_destroy(PaymentStrategy* self) {
     if (self) {
         free(self);
@@ -125,6 +286,7 @@ PaymentStrategy* create_paypal_strategy(const char* email) {
     
     pp->base.calculate_fee = paypal_calculate_fee;
     pp->base.process_payment = paypal_process_payment;
+    pp->base.fee_schedule = paypal_fee_schedule;
     pp->base.destroy = paypal_destroy;
     
     return (PaymentStrategy*)pp;
@@ -158,6 +320,11 @@ void bank_transfer_process_payment(PaymentStrategy* self, double amount, const c
     printf("   Status: ✅ Transfer Initiated (1-3 business days)\n");
 }
 
+FeeSchedule bank_transfer_fee_schedule(PaymentStrategy* self) {
+    BankTransferStrategy* bt = (BankTransferStrategy*)self;
+    return (FeeSchedule){to_fixed(bt->flat_fee, 100), 0};
+}
+
 void bank_transfer_destroy(PaymentStrategy* self) {
     if (self) {
         free(self);
@@ -174,6 +341,7 @@ PaymentStrategy* create_bank_transfer_strategy(const char* bank_name, const char
     
     bt->base.calculate_fee = bank_transfer_calculate_fee;
     bt->base.process_payment = bank_transfer_process_payment;
+    bt->base.fee_schedule = bank_transfer_fee_schedule;
     bt->base.destroy = bank_transfer_destroy;
     
     return (PaymentStrategy*)bt;
@@ -208,6 +376,11 @@ void crypto_process_payment(PaymentStrategy* self, double amount, const char* de
     printf("   Status: ✅ Transaction Broadcast to Network\n");
 }
 
+FeeSchedule crypto_fee_schedule(PaymentStrategy* self) {
+    CryptocurrencyStrategy* crypto = (CryptocurrencyStrategy*)self;
+    return (FeeSchedule){to_fixed(crypto->network_fee, 100), 0};
+}
+
 void crypto_destroy(PaymentStrategy* self) {
     if (self) {
         free(self);
@@ -224,19 +397,48 @@ PaymentStrategy* create_cryptocurrency_strategy(const char* crypto_type, const c
     
     crypto->base.calculate_fee = crypto_calculate_fee;
     crypto->base.process_payment = crypto_process_payment;
+    crypto->base.fee_schedule = crypto_fee_schedule;
     crypto->base.destroy = crypto_destroy;
     
     return (PaymentStrategy*)crypto;
 }
 
 // Context: Payment Processor
+#define MAX_PAYMENT_METHODS 16
+
 typedef struct {
     PaymentStrategy* strategy;
     char merchant_name[100];
     double total_processed;
     int transaction_count;
+    
+    // Batch settlement: method IDs index these; schedules are cached at registration
+    PaymentStrategy* methods[MAX_PAYMENT_METHODS];
+    FeeSchedule schedules[MAX_PAYMENT_METHODS];
+    int method_count;
+    const FeeKernel* fee_kernel;
+    
+    // Reused across batches
+    int scratch_capacity;
+    int32_t* grouped_amounts;
+    int32_t* grouped_fees;
+    int* grouped_positions;              // Where each grouped transaction sits in the batch
 } PaymentProcessor;
 
+typedef struct {
+    int count;
+    int64_t amount_cents;
+    int64_t fee_cents;
+} MethodTotals;
+
+typedef struct {
+    MethodTotals methods[MAX_PAYMENT_METHODS];
+    int processed;
+    int rejected;                        // Unknown method IDs
+    int64_t amount_cents;
+    int64_t fee_cents;
+} BatchSettlement;
+
 PaymentProcessor* create_payment_processor(const char* merchant_name) {
     PaymentProcessor* processor = (PaymentProcessor*)malloc(sizeof(PaymentProcessor));
     
@@ -244,10 +446,35 @@ PaymentProcessor* create_payment_processor(const char* merchant_name) {
     processor->strategy = NULL;
     processor->total_processed = 0.0;
     processor->transaction_count = 0;
+    processor->method_count = 0;
+    processor->fee_kernel = detect_fee_kernel();
+    processor->scratch_capacity = 0;
+    processor->grouped_amounts = NULL;
+    processor->grouped_fees = NULL;
+    processor->grouped_positions = NULL;
     
     return processor;
 }
 
+// Returns the method ID for batches, or -1 if the table is full or the
+// strategy's rate is outside 0-100% (the fee kernels are only exact
+// there). Register again after changing a strategy's fees.
+int register_payment_method(PaymentProcessor* processor, PaymentStrategy* strategy) {
+    FeeSchedule schedule = strategy->fee_schedule(strategy);
+    if (schedule.rate_ppm < 0 || schedule.rate_ppm > MAX_RATE_PPM) return -1;
+    for (int i = 0; i < processor->method_count; i++) {
+        if (processor->methods[i] == strategy) {
+            processor->schedules[i] = schedule;
+            return i;
+        }
+    }
+    if (processor->method_count == MAX_PAYMENT_METHODS) return -1;
+    int id = processor->method_count++;
+    processor->methods[id] = strategy;
+    processor->schedules[id] = schedule;
+    return id;
+}
+
 void set_payment_strategy(PaymentProcessor* processor, PaymentStrategy* strategy) {
     processor->strategy = strategy;
     printf("🔄 Payment method changed to: %s\n", strategy->name);
@@ -275,6 +502,88 @@ double calculate_total_fees(PaymentProcessor* processor, double amount) {
     return processor->strategy->calculate_fee(processor->strategy, amount);
 }
 
+// Settle 'count' transactions: amounts in cents, each paid with method_ids[i].
+// fees_out (may be NULL) gets each fee in cents, or -1 for an unknown method.
+// Processor totals are updated once; nothing is printed.
+void process_payment_batch(PaymentProcessor* processor, const int32_t* amounts_cents,
+                           const uint8_t* method_ids, int count, int32_t* fees_out,
+                           BatchSettlement* settlement) {
+    memset(settlement, 0, sizeof(*settlement));
+    if (count > processor->scratch_capacity) {
+        processor->scratch_capacity = count;
+        processor->grouped_amounts = (int32_t*)realloc(processor->grouped_amounts, count * sizeof(int32_t));
+        processor->grouped_fees = (int32_t*)realloc(processor->grouped_fees, count * sizeof(int32_t));
+        processor->grouped_positions = (int*)realloc(processor->grouped_positions, count * sizeof(int));
+    }
+    
+    // Group by method with a counting sort
+    int starts[MAX_PAYMENT_METHODS + 1] = {0};
+    for (int i = 0; i < count; i++) {
+        if (method_ids[i] < processor->method_count) {
+            settlement->methods[method_ids[i]].count++;
+        } else {
+            settlement->rejected++;
+            if (fees_out) fees_out[i] = -1;
+        }
+    }
+    for (int m = 0; m < processor->method_count; m++) {
+        starts[m + 1] = starts[m] + settlement->methods[m].count;
+    }
+    int next[MAX_PAYMENT_METHODS];
+    memcpy(next, starts, sizeof(next));
+    for (int i = 0; i < count; i++) {
+        int m = method_ids[i];
+        if (m < processor->method_count) {
+            processor->grouped_amounts[next[m]] = amounts_cents[i];
+            processor->grouped_positions[next[m]++] = i;
+        }
+    }
+    
+    // One kernel call per method, then exact totals
+    for (int m = 0; m < processor->method_count; m++) {
+        int start = starts[m], n = settlement->methods[m].count;
+        COUNTER_TIME_BEGIN(strategy_kernel_calls);
+        processor->fee_kernel->compute_fees(processor->grouped_amounts + start, n,
+                                            processor->schedules[m], processor->grouped_fees + start);
+        COUNTER_TIME_END(strategy_kernel_calls);
+        int64_t amount = 0, fee = 0;
+        for (int i = start; i < start + n; i++) {
+            amount += processor->grouped_amounts[i];
+            fee += processor->grouped_fees[i];
+        }
+        if (fees_out) {
+            for (int i = start; i < start + n; i++) {
+                fees_out[processor->grouped_positions[i]] = processor->grouped_fees[i];
+            }
+        }
+        settlement->methods[m].amount_cents = amount;
+        settlement->methods[m].fee_cents = fee;
+        settlement->amount_cents += amount;
+        settlement->fee_cents += fee;
+    }
+    settlement->processed = count - settlement->rejected;
+    COUNTER_ADD(strategy_batches, 1);
+    COUNTER_ADD(strategy_settled, settlement->processed);
+    COUNTER_ADD(strategy_rejected, settlement->rejected);
+    
+    processor->total_processed += settlement->amount_cents / 100.0;
+    processor->transaction_count += settlement->processed;
+}
+
+void print_batch_settlement(PaymentProcessor* processor, const BatchSettlement* settlement) {
+    printf("\n🧾 Batch Settlement for %s (%s fee kernel):\n",
+           processor->merchant_name, processor->fee_kernel->name);
+    for (int m = 0; m < processor->method_count; m++) {
+        const MethodTotals* totals = &settlement->methods[m];
+        printf("   %-14s %8d payments  $%12.2f  fees $%10.2f\n", processor->methods[m]->name,
+               totals->count, totals->amount_cents / 100.0, totals->fee_cents / 100.0);
+    }
+    printf("   Total: %d payments, $%.2f, fees $%.2f", settlement->processed,
+           settlement->amount_cents / 100.0, settlement->fee_cents / 100.0);
+    if (settlement->rejected) printf(", %d rejected", settlement->rejected);
+    printf("\n");
+}
+
 void print_processor_stats(PaymentProcessor* processor) {
     printf("\n📊 Payment Processor Statistics for %s:\n", processor->merchant_name);
     printf("   Total Transactions: %d\n", processor->transaction_count);
@@ -286,10 +595,100 @@ void print_processor_stats(PaymentProcessor* processor) {
 
 void destroy_payment_processor(PaymentProcessor* processor) {
     if (processor) {
+        free(processor->grouped_amounts);
+        free(processor->grouped_fees);
+        free(processor->grouped_positions);
         free(processor);
     }
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_TRANSACTIONS 1000000
+
+typedef struct {
+    PaymentProcessor* processor;
+    int32_t* amounts;
+    uint8_t* methods;
+    int32_t* fees;
+    const FeeKernel* kernel;
+} SettlementBench;
+
+static void bench_per_call_fees(void* arg) {
+    SettlementBench* bench = (SettlementBench*)arg;
+    double total = 0.0;
+    for (int i = 0; i < BENCH_TRANSACTIONS; i++) {
+        PaymentStrategy* method = bench->processor->methods[bench->methods[i]];
+        total += method->calculate_fee(method, bench->amounts[i] / 100.0);
+    }
+    bench_consume((uint64_t)total);
+}
+
+static void bench_batch_settlement(void* arg) {
+    SettlementBench* bench = (SettlementBench*)arg;
+    BatchSettlement settlement;
+    process_payment_batch(bench->processor, bench->amounts, bench->methods, BENCH_TRANSACTIONS,
+                          bench->fees, &settlement);
+    bench_consume(settlement.fee_cents);
+}
+
+static void bench_fee_kernel(void* arg) {
+    SettlementBench* bench = (SettlementBench*)arg;
+    bench->kernel->compute_fees(bench->amounts, BENCH_TRANSACTIONS, bench->processor->schedules[1],
+                                bench->fees);
+    bench_consume(bench->fees[BENCH_TRANSACTIONS - 1]);
+}
+
+int main() {
+    bench_header("Payment processing throughput");
+    
+    PaymentStrategy* strategies[] = {
+        create_credit_card_strategy("1234567812345678", "John Doe"),
+        create_paypal_strategy("john.doe@email.com"),
+        create_bank_transfer_strategy("First National Bank", "1234567890"),
+        create_cryptocurrency_strategy("Bitcoin", "1A1zP1eP5QGefi2DMPTfTL5SLmv7DivfNa"),
+    };
+    SettlementBench bench;
+    bench.processor = create_payment_processor("Benchmark Settlement");
+    for (int m = 0; m < 4; m++) {
+        register_payment_method(bench.processor, strategies[m]);
+    }
+    bench.amounts = (int32_t*)malloc(BENCH_TRANSACTIONS * sizeof(int32_t));
+    bench.methods = (uint8_t*)malloc(BENCH_TRANSACTIONS);
+    bench.fees = (int32_t*)malloc(BENCH_TRANSACTIONS * sizeof(int32_t));
+    unsigned seed = 2024;
+    for (int i = 0; i < BENCH_TRANSACTIONS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        bench.amounts[i] = 100 + (int32_t)((seed >> 4) % 500000);
+        bench.methods[i] = (uint8_t)((seed >> 28) % 4);
+    }
+    
+    bench_run("per-call calculate_fee (per transaction)", bench_per_call_fees, &bench, BENCH_TRANSACTIONS);
+    bench_run("process_payment_batch (per transaction)", bench_batch_settlement, &bench, BENCH_TRANSACTIONS);
+    
+    // The PayPal schedule has both a fixed and a rate part
+    const FeeKernel* kernels[MAX_FEE_KERNELS];
+    int kernel_count = available_fee_kernels(kernels);
+    char name[64];
+    for (int k = 0; k < kernel_count; k++) {
+        bench.kernel = kernels[k];
+        snprintf(name, sizeof(name), "%s fee kernel (per transaction)", kernels[k]->name);
+        bench_run(name, bench_fee_kernel, &bench, BENCH_TRANSACTIONS);
+    }
+    
+    counters_report();
+    
+    free(bench.amounts);
+    free(bench.methods);
+    free(bench.fees);
+    destroy_payment_processor(bench.processor);
+    for (int m = 0; m < 4; m++) {
+        strategies[m]->destroy(strategies[m]);
+    }
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== STRATEGY PATTERN EXAMPLE ===\n\n");
@@ -332,11 +731,94 @@ int main() {
     
     print_processor_stats(processor);
     
+    printf("\n--- Batch settlement ---\n");
+    
+    // The four purchases above, settled again in one call on a separate
+    // processor so the store's totals don't count them twice
+    PaymentProcessor* reconciler = create_payment_processor("TechStore Reconciliation");
+    int card_id = register_payment_method(reconciler, credit_card);
+    int paypal_id = register_payment_method(reconciler, paypal);
+    int bank_id = register_payment_method(reconciler, bank_transfer);
+    int bitcoin_id = register_payment_method(reconciler, bitcoin);
+    int32_t amounts[] = {29999, 8950, 129900, 4575, 10000};
+    uint8_t method_ids[] = {card_id, paypal_id, bank_id, bitcoin_id, 99};
+    int32_t fees[5];
+    BatchSettlement settlement;
+    process_payment_batch(reconciler, amounts, method_ids, 5, fees, &settlement);
+    for (int i = 0; i < 4; i++) {
+        PaymentStrategy* method = reconciler->methods[method_ids[i]];
+        printf("   $%.2f by %s: fee $%.2f (per-call: $%.4f)\n", amounts[i] / 100.0, method->name,
+               fees[i] / 100.0, method->calculate_fee(method, amounts[i] / 100.0));
+    }
+    print_batch_settlement(reconciler, &settlement);
+    destroy_payment_processor(reconciler);
+    
+    // A settlement run
+    int run_size = 4000000;
+    int32_t* run_amounts = (int32_t*)malloc(run_size * sizeof(int32_t));
+    uint8_t* run_methods = (uint8_t*)malloc(run_size);
+    int32_t* run_fees = (int32_t*)malloc(run_size * sizeof(int32_t));
+    unsigned seed = 2024;
+    for (int i = 0; i < run_size; i++) {
+        seed = seed * 1103515245u + 12345u;
+        run_amounts[i] = 100 + (int32_t)((seed >> 4) % 500000);   // $1.00 to $5,000.99
+        run_methods[i] = (uint8_t)((seed >> 28) % 4);
+    }
+    PaymentProcessor* settler = create_payment_processor("Nightly Settlement");
+    register_payment_method(settler, credit_card);
+    register_payment_method(settler, paypal);
+    register_payment_method(settler, bank_transfer);
+    register_payment_method(settler, bitcoin);
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double per_call_fees = 0.0;
+    for (int i = 0; i < run_size; i++) {
+        PaymentStrategy* method = settler->methods[run_methods[i]];
+        per_call_fees += method->calculate_fee(method, run_amounts[i] / 100.0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double per_call_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    
+    // Twice: the first batch also grows the processor's scratch buffers
+    double batch_ms[2];
+    for (int run = 0; run < 2; run++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        process_payment_batch(settler, run_amounts, run_methods, run_size, run_fees, &settlement);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        batch_ms[run] = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    }
+    print_batch_settlement(settler, &settlement);
+    printf("⏱️  Per-call calculate_fee: %.1f ms, $%.4f in fractional-cent fees\n", per_call_ms, per_call_fees);
+    printf("⏱️  Batch: %.1f ms first, %.1f ms reusing scratch, $%.2f in whole-cent fees\n",
+           batch_ms[0], batch_ms[1], settlement.fee_cents / 100.0);
+    
+    // Every kernel should charge exactly what the scalar one does
+    const FeeKernel* kernels[MAX_FEE_KERNELS];
+    int kernel_count = available_fee_kernels(kernels);
+    int32_t* expected = (int32_t*)malloc(run_size * sizeof(int32_t));
+    for (int k = 0; k < kernel_count; k++) {
+        int matches = 1;
+        for (int m = 0; m < settler->method_count; m++) {
+            compute_fees_scalar(run_amounts, run_size, settler->schedules[m], expected);
+            kernels[k]->compute_fees(run_amounts, run_size, settler->schedules[m], run_fees);
+            matches = matches && memcmp(expected, run_fees, run_size * sizeof(int32_t)) == 0;
+        }
+        printf("%s %s fee kernel matches\n", matches ? "✅" : "❌", kernels[k]->name);
+    }
+    free(expected);
+    free(run_amounts);
+    free(run_methods);
+    free(run_fees);
+    print_processor_stats(settler);
+    destroy_payment_processor(settler);
+    
     printf("\n--- Strategy Pattern Benefits Demonstrated ---\n");
     printf("✅ Algorithms (payment methods) are interchangeable at runtime\n");
     printf("✅ Easy to add new payment strategies without changing existing code\n");
     printf("✅ Client code doesn't depend on specific payment implementation\n");
     printf("✅ Each strategy encapsulates its own fee calculation logic\n");
+    printf("✅ Strategies compiled to fee schedules settle in exact cents, in bulk\n");
     
     // Cleanup
     destroy_payment_processor(processor);
@@ -346,4 +828,5 @@ int main() {
     bitcoin->destroy(bitcoin);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
@@ -18,159 +18,887 @@
  * Cons:
  * - Limited flexibility
  * - Violates Liskov substitution if not designed carefully
+ *
+ * Streaming: process_stream() runs the same steps over fixed-size chunks
+ * pulled from a file descriptor or callback. Each step sees only whole
+ * records; a record cut by a chunk boundary is carried into the next
+ * chunk, so memory stays at one chunk plus its output however large the
+ * input is.
+ *
+ * Mapped files: a processor created with an input path maps the file
+ * read-only, and process_mapped() hands the steps views straight into the
+ * mapping, so nothing is copied. With data_processor_write_to_fd() the
+ * output goes from the reusable output buffer to a file descriptor.
+ *
+ * Parallel: process_parallel() cuts the input into batches of whole
+ * records. Workers run read/process on their own clone of the processor,
+ * and the caller's thread writes the results in input order through a
+ * reorder buffer.
+ *
+ * Text kernels: CSV delimiter/newline scanning and ASCII uppercasing use
+ * SSE2/AVX2 (x86) or NEON (ARM) when the CPU has them, picked at runtime.
+ * The scalar versions define the expected results.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for processing-throughput
+ * microbenchmarks instead of the demo (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "../bench.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SIMD 1
+#endif
+
+#define DEFAULT_CHUNK_SIZE 4096
+#define RAW_PREVIEW_BYTES 48      // How much of its input read_data() echoes
+
+// Where streamed input comes from. read() fills up to 'capacity' bytes and
+// returns the count, 0 at end of input, or -1 on error.
+typedef struct {
+    long (*read)(void* context, char* buffer, size_t capacity);
+    void* context;
+} ChunkSource;
 
 // Abstract base class (simulated with function pointers)
 typedef struct DataProcessor DataProcessor;
 
 struct DataProcessor {
     char processor_name[100];
-    char input_data[500];
-    char processed_data[500];
+    const char* input_data;     // Current input (not owned, not NUL-terminated)
+    size_t input_length;
+    char* processed_data;       // Output buffer, grown on demand and reused
+    size_t processed_length;
+    size_t processed_capacity;
+    const char* mapped_data;    // Read-only mapping of the input file, if any
+    size_t mapped_length;
+    int output_fd;              // -1: print output; otherwise write it here
     
-    // Template method (final - shouldn't be overridden)
+    // Template methods (final - shouldn't be overridden)
     void (*process)(DataProcessor* self, const char* input);
+    int (*process_stream)(DataProcessor* self, ChunkSource* source, size_t chunk_size);
+    int (*process_mapped)(DataProcessor* self, size_t window_size);
+    int (*process_parallel)(DataProcessor* self, const char* input, size_t length,
+                            size_t batch_size, int thread_count);
     
     // Abstract methods (must be implemented by concrete classes)
-    void (*read_data)(DataProcessor* self, const char* input);
+    void (*read_data)(DataProcessor* self, const char* input, size_t length);
     void (*process_data)(DataProcessor* self);
     void (*write_data)(DataProcessor* self);
     
     // Hook methods (optional to override)
-    int (*validate_input)(DataProcessor* self, const char* input);
+    int (*validate_input)(DataProcessor* self, const char* input, size_t length);
     void (*log_processing)(DataProcessor* self, const char* step);
     
+    DataProcessor* (*clone)(DataProcessor* self);  // Same settings, own buffers
     void (*destroy)(DataProcessor* self);
 };
 
-// Template method implementation
-void data_processor_process(DataProcessor* self, const char* input) {
-    printf("\n🔄 Starting data processing with %s\n", self->processor_name);
-    printf("=====================================\n");
-    
-    // Step 1: Validate input (hook method)
-    if (!self->validate_input(self, input)) {
-        printf("❌ Input validation failed\n");
+// ---- Output buffer helpers (shared by all processors) ----
+
+// Make room for 'extra' more bytes plus a terminator; returns the write position
+char* output_reserve(DataProcessor* self, size_t extra) {
+    size_t needed = self->processed_length + extra + 1;
+    if (needed > self->processed_capacity) {
+        size_t capacity = self->processed_capacity ? self->processed_capacity : 256;
+        while (capacity < needed) capacity *= 2;
+        self->processed_data = (char*)realloc(self->processed_data, capacity);
+        self->processed_capacity = capacity;
+    }
+    return self->processed_data + self->processed_length;
+}
+
+void output_append(DataProcessor* self, const char* data, size_t length) {
+    memcpy(output_reserve(self, length), data, length);
+    self->processed_length += length;
+    self->processed_data[self->processed_length] = '\0';
+}
+
+void output_reset(DataProcessor* self) {
+    self->processed_length = 0;
+    output_reserve(self, 0)[0] = '\0';
+}
+
+// Send the output buffer to output_fd, or print it when there is none.
+// Used by every write_data() for its "Output" line.
+void emit_output(DataProcessor* self) {
+    if (self->output_fd < 0) {
+        PATTERN_LOG("   Output: %s\n", self->processed_data);
         return;
     }
-    
+    fflush(stdout);  // Keep our own messages in order with the raw bytes
+    size_t written = 0;
+    while (written < self->processed_length) {
+        ssize_t count = write(self->output_fd, self->processed_data + written,
+                              self->processed_length - written);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            printf("   ❌ Write to fd %d failed\n", self->output_fd);
+            return;
+        }
+        written += (size_t)count;
+    }
+    PATTERN_LOG("   Output: %zu bytes written to fd %d\n", written, self->output_fd);
+}
+
+// Steps 2-4 of the algorithm on one piece of input
+static void data_processor_run_steps(DataProcessor* self, const char* input, size_t length) {
     // Step 2: Read data (abstract method)
     self->log_processing(self, "Reading data");
-    self->read_data(self, input);
+    self->read_data(self, input, length);
     
     // Step 3: Process data (abstract method)
     self->log_processing(self, "Processing data");
+    output_reset(self);
     self->process_data(self);
     
     // Step 4: Write data (abstract method)
     self->log_processing(self, "Writing data");
     self->write_data(self);
+}
+
+// Template method implementation
+void data_processor_process(DataProcessor* self, const char* input) {
+    PATTERN_LOG("\n🔄 Starting data processing with %s\n", self->processor_name);
+    PATTERN_LOG("=====================================\n");
+    
+    size_t length = input ? strlen(input) : 0;
+    
+    // Step 1: Validate input (hook method)
+    if (!self->validate_input(self, input, length)) {
+        printf("❌ Input validation failed\n");
+        return;
+    }
+    
+    data_processor_run_steps(self, input, length);
+    
+    PATTERN_LOG("✅ Processing completed\n");
+    PATTERN_LOG("=====================================\n");
+}
+
+// Length of the whole records at the start of buffer[0..length), i.e. up to
+// and including the last newline; 0 if no record has ended yet
+static size_t complete_records_length(const char* buffer, size_t length) {
+    for (size_t i = length; i > 0; i--) {
+        if (buffer[i - 1] == '\n') return i;
+    }
+    return 0;
+}
+
+// Streaming template method: the same steps, one chunk of whole records at
+// a time. The partial record at the end of a chunk is moved to the front of
+// the buffer and completed by the next read. A single record longer than
+// the chunk is passed on in chunk-sized pieces. Returns 0, or -1 on error.
+int data_processor_process_stream(DataProcessor* self, ChunkSource* source, size_t chunk_size) {
+    PATTERN_LOG("\n🔄 Streaming data processing with %s (%zu-byte chunks)\n",
+                self->processor_name, chunk_size);
+    PATTERN_LOG("=====================================\n");
+    
+    char* buffer = (char*)malloc(chunk_size);
+    size_t carried = 0;          // Bytes of an unfinished record kept from last time
+    size_t total_bytes = 0;
+    int chunks = 0;
+    int split_records = 0;
+    int result = 0;
+    
+    for (;;) {
+        // Fill the chunk; sources may return fewer bytes than asked for
+        size_t filled = carried;
+        long got = 1;
+        while (filled < chunk_size && got > 0) {
+            got = source->read(source->context, buffer + filled, chunk_size - filled);
+            if (got > 0) filled += (size_t)got;
+        }
+        if (got < 0) {
+            printf("❌ Read error after %zu bytes\n", total_bytes);
+            result = -1;
+            break;
+        }
+        int at_end = (got == 0);
+        
+        size_t usable = at_end ? filled : complete_records_length(buffer, filled);
+        if (usable == 0 && filled == chunk_size) {
+            usable = filled;     // One record fills the whole chunk: split it
+            split_records++;
+        }
+        
+        if (usable > 0) {
+            // Step 1: Validate input (hook method) - once, on the first chunk
+            if (chunks == 0 && !self->validate_input(self, buffer, usable)) {
+                printf("❌ Input validation failed\n");
+                result = -1;
+                break;
+            }
+            PATTERN_LOG("📦 Chunk %d: %zu bytes\n", chunks + 1, usable);
+            data_processor_run_steps(self, buffer, usable);
+            total_bytes += usable;
+            chunks++;
+        }
+        
+        carried = filled - usable;
+        memmove(buffer, buffer + usable, carried);
+        if (at_end) break;
+    }
+    
+    free(buffer);
+    if (result == 0) {
+        PATTERN_LOG("✅ Streaming completed: %zu bytes in %d chunks", total_bytes, chunks);
+        if (split_records > 0) {
+            PATTERN_LOG(" (%d oversized records split)", split_records);
+        }
+        PATTERN_LOG("\n");
+    }
+    PATTERN_LOG("=====================================\n");
+    return result;
+}
+
+// Mapped-file template method: the same steps over windows of whole
+// records taken directly from the mapping (views, not copies). Windows keep
+// the output buffer bounded. Returns 0, or -1 on error.
+int data_processor_process_mapped(DataProcessor* self, size_t window_size) {
+    PATTERN_LOG("\n🔄 Processing mapped file with %s (%zu-byte windows)\n",
+                self->processor_name, window_size);
+    PATTERN_LOG("=====================================\n");
+    
+    if (self->mapped_data == NULL || self->mapped_length == 0) {
+        self->validate_input(self, NULL, 0);
+        printf("❌ Input validation failed\n");
+        PATTERN_LOG("=====================================\n");
+        return -1;
+    }
+    
+    const char* data = self->mapped_data;
+    size_t length = self->mapped_length;
+    size_t offset = 0;
+    int windows = 0;
+    int split_records = 0;
     
-    printf("✅ Processing completed\n");
-    printf("=====================================\n");
+    while (offset < length) {
+        size_t usable = length - offset;
+        if (usable > window_size) {
+            usable = complete_records_length(data + offset, window_size);
+            if (usable == 0) {
+                usable = window_size;
+                split_records++;
+            }
+        }
+        
+        // Step 1: Validate input (hook method) - once, on the first window
+        if (windows == 0 && !self->validate_input(self, data, usable)) {
+            printf("❌ Input validation failed\n");
+            PATTERN_LOG("=====================================\n");
+            return -1;
+        }
+        PATTERN_LOG("📦 Window %d: %zu bytes at offset %zu\n", windows + 1, usable, offset);
+        data_processor_run_steps(self, data + offset, usable);
+        offset += usable;
+        windows++;
+    }
+    
+    PATTERN_LOG("✅ Mapped processing completed: %zu bytes in %d windows", length, windows);
+    if (split_records > 0) {
+        PATTERN_LOG(" (%d oversized records split)", split_records);
+    }
+    PATTERN_LOG("\n");
+    PATTERN_LOG("=====================================\n");
+    return 0;
+}
+
+// ---- Parallel execution ----
+
+#define MAX_WORKERS 64
+#define SLOTS_PER_WORKER 2
+
+// One entry of the reorder buffer. Batch b always lives in slot
+// b % slot_count, and each slot has its own processor clone, so a finished
+// batch keeps its output until its turn to be written.
+typedef struct {
+    DataProcessor* processor;
+    const char* input;
+    size_t length;
+    int done;
+} ReorderSlot;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t slot_done;
+    ReorderSlot* slots;
+    int slot_count;
+    int* pending;              // Ring of slot numbers waiting for a worker
+    int pending_head;
+    int pending_count;
+    int stopping;
+} ParallelRun;
+
+static void* parallel_worker(void* arg) {
+    ParallelRun* run = (ParallelRun*)arg;
+    pthread_mutex_lock(&run->lock);
+    for (;;) {
+        while (run->pending_count == 0 && !run->stopping) {
+            pthread_cond_wait(&run->work_ready, &run->lock);
+        }
+        if (run->pending_count == 0) break;
+        ReorderSlot* slot = &run->slots[run->pending[run->pending_head]];
+        run->pending_head = (run->pending_head + 1) % run->slot_count;
+        run->pending_count--;
+        pthread_mutex_unlock(&run->lock);
+        
+        // Steps 2-3 on this batch, in parallel with the other workers
+        DataProcessor* processor = slot->processor;
+        processor->log_processing(processor, "Reading data");
+        processor->read_data(processor, slot->input, slot->length);
+        processor->log_processing(processor, "Processing data");
+        output_reset(processor);
+        processor->process_data(processor);
+        
+        pthread_mutex_lock(&run->lock);
+        slot->done = 1;
+        pthread_cond_broadcast(&run->slot_done);
+    }
+    pthread_mutex_unlock(&run->lock);
+    return NULL;
+}
+
+// Caller holds run->lock
+static void parallel_dispatch(ParallelRun* run, int slot_number, const char* input, size_t length) {
+    ReorderSlot* slot = &run->slots[slot_number];
+    slot->input = input;
+    slot->length = length;
+    slot->done = 0;
+    run->pending[(run->pending_head + run->pending_count) % run->slot_count] = slot_number;
+    run->pending_count++;
+    pthread_cond_signal(&run->work_ready);
+}
+
+// Length of the next batch at 'input': about batch_size, cut after a newline
+static size_t next_batch_length(const char* input, size_t remaining, size_t batch_size) {
+    if (remaining <= batch_size) return remaining;
+    size_t usable = complete_records_length(input, batch_size);
+    if (usable > 0) return usable;
+    // One record longer than a batch: extend it to its own end
+    const char* newline = memchr(input + batch_size, '\n', remaining - batch_size);
+    return newline ? (size_t)(newline - input) + 1 : remaining;
+}
+
+// Parallel template method for record-oriented input (CSV rows, NDJSON).
+// Validates the first batch, then keeps up to SLOTS_PER_WORKER batches per
+// worker in flight and writes each one as soon as all earlier ones are
+// written. Returns 0, or -1 on error.
+int data_processor_process_parallel(DataProcessor* self, const char* input, size_t length,
+                                    size_t batch_size, int thread_count) {
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_WORKERS) thread_count = MAX_WORKERS;
+    PATTERN_LOG("\n🔄 Parallel data processing with %s (%d workers, %zu-byte batches)\n",
+                self->processor_name, thread_count, batch_size);
+    PATTERN_LOG("=====================================\n");
+    
+    size_t first_length = input ? next_batch_length(input, length, batch_size) : 0;
+    if (!self->validate_input(self, input, first_length)) {
+        printf("❌ Input validation failed\n");
+        PATTERN_LOG("=====================================\n");
+        return -1;
+    }
+    
+    ParallelRun run;
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.work_ready, NULL);
+    pthread_cond_init(&run.slot_done, NULL);
+    run.slot_count = thread_count * SLOTS_PER_WORKER;
+    run.slots = (ReorderSlot*)calloc(run.slot_count, sizeof(ReorderSlot));
+    run.pending = (int*)malloc(run.slot_count * sizeof(int));
+    run.pending_head = 0;
+    run.pending_count = 0;
+    run.stopping = 0;
+    for (int i = 0; i < run.slot_count; i++) {
+        run.slots[i].processor = self->clone(self);
+    }
+    
+    pthread_t workers[MAX_WORKERS];
+    for (int i = 0; i < thread_count; i++) {
+        pthread_create(&workers[i], NULL, parallel_worker, &run);
+    }
+    
+    size_t offset = 0;
+    long dispatched = 0;
+    long written = 0;
+    
+    pthread_mutex_lock(&run.lock);
+    while (dispatched < run.slot_count && offset < length) {
+        size_t batch = next_batch_length(input + offset, length - offset, batch_size);
+        parallel_dispatch(&run, (int)(dispatched % run.slot_count), input + offset, batch);
+        offset += batch;
+        dispatched++;
+    }
+    
+    while (written < dispatched) {
+        int slot_number = (int)(written % run.slot_count);
+        ReorderSlot* slot = &run.slots[slot_number];
+        while (!slot->done) {
+            pthread_cond_wait(&run.slot_done, &run.lock);
+        }
+        pthread_mutex_unlock(&run.lock);
+        
+        // Step 4 in input order, on this thread
+        slot->processor->log_processing(slot->processor, "Writing data");
+        slot->processor->write_data(slot->processor);
+        written++;
+        
+        pthread_mutex_lock(&run.lock);
+        if (offset < length) {
+            size_t batch = next_batch_length(input + offset, length - offset, batch_size);
+            parallel_dispatch(&run, slot_number, input + offset, batch);
+            offset += batch;
+            dispatched++;
+        }
+    }
+    run.stopping = 1;
+    pthread_cond_broadcast(&run.work_ready);
+    pthread_mutex_unlock(&run.lock);
+    
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    for (int i = 0; i < run.slot_count; i++) {
+        run.slots[i].processor->destroy(run.slots[i].processor);
+    }
+    free(run.slots);
+    free(run.pending);
+    pthread_cond_destroy(&run.work_ready);
+    pthread_cond_destroy(&run.slot_done);
+    pthread_mutex_destroy(&run.lock);
+    
+    PATTERN_LOG("✅ Parallel processing completed: %zu bytes in %ld batches\n", length, written);
+    PATTERN_LOG("=====================================\n");
+    return 0;
+}
+
+// ---- Chunk sources ----
+
+static long fd_chunk_read(void* context, char* buffer, size_t capacity) {
+    int fd = (int)(intptr_t)context;
+    for (;;) {
+        ssize_t got = read(fd, buffer, capacity);
+        if (got >= 0) return (long)got;
+        if (errno != EINTR) return -1;
+    }
+}
+
+// Stream from an open file descriptor (file, pipe, socket...)
+ChunkSource chunk_source_from_fd(int fd) {
+    ChunkSource source = {fd_chunk_read, (void*)(intptr_t)fd};
+    return source;
+}
+
+// Stream from any producer callback
+ChunkSource chunk_source_from_callback(long (*read)(void* context, char* buffer, size_t capacity),
+                                       void* context) {
+    ChunkSource source = {read, context};
+    return source;
 }
 
 // Default hook method implementations
-int default_validate_input(DataProcessor* self, const char* input) {
-    if (input == NULL || strlen(input) == 0) {
+int default_validate_input(DataProcessor* self, const char* input, size_t length) {
+    if (input == NULL || length == 0) {
         printf("❌ Validation failed: Empty input\n");
         return 0;
     }
-    printf("✅ Input validation passed\n");
+    PATTERN_LOG("✅ Input validation passed\n");
     return 1;
 }
 
 void default_log_processing(DataProcessor* self, const char* step) {
-    printf("📝 [%s] %s\n", self->processor_name, step);
+    PATTERN_LOG("📝 [%s] %s\n", self->processor_name, step);
+}
+
+// Map 'path' read-only as the processor's input. An empty or missing file
+// leaves no mapping, which process_mapped() reports as empty input.
+static void data_processor_map_input(DataProcessor* self, const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("❌ Cannot open %s\n", path);
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+            self->mapped_data = (const char*)mapping;
+            self->mapped_length = (size_t)info.st_size;
+        } else {
+            printf("❌ Cannot map %s\n", path);
+        }
+    }
+    close(fd);  // The mapping stays valid without the descriptor
+}
+
+// Shared part of every constructor. 'input_path' may be NULL.
+void data_processor_init(DataProcessor* self, const char* name, const char* input_path) {
+    strcpy(self->processor_name, name);
+    self->input_data = "";
+    self->input_length = 0;
+    self->processed_data = NULL;
+    self->processed_length = 0;
+    self->processed_capacity = 0;
+    self->mapped_data = NULL;
+    self->mapped_length = 0;
+    self->output_fd = -1;
+    output_reset(self);
+    self->process = data_processor_process;
+    self->process_stream = data_processor_process_stream;
+    self->process_mapped = data_processor_process_mapped;
+    self->process_parallel = data_processor_process_parallel;
+    if (input_path != NULL) {
+        data_processor_map_input(self, input_path);
+    }
+}
+
+// Send output to 'fd' instead of printing it (-1 to print again)
+void data_processor_write_to_fd(DataProcessor* self, int fd) {
+    self->output_fd = fd;
+}
+
+// Finish a memberwise copy made by a clone() method: the copy gets its own
+// output buffer and never owns the original's mapping
+void data_processor_init_clone(DataProcessor* copy) {
+    copy->input_data = "";
+    copy->input_length = 0;
+    copy->processed_data = NULL;
+    copy->processed_length = 0;
+    copy->processed_capacity = 0;
+    copy->mapped_data = NULL;
+    copy->mapped_length = 0;
+    output_reset(copy);
+}
+
+void data_processor_release(DataProcessor* self) {
+    if (self->mapped_data != NULL) {
+        munmap((void*)self->mapped_data, self->mapped_length);
+    }
+    free(self->processed_data);
+    free(self);
+}
+
+// Emit prefix + record + suffix for every line of the input, keeping the
+// newlines between records
+void wrap_each_record(DataProcessor* self, const char* prefix, size_t prefix_length,
+                      const char* suffix, size_t suffix_length) {
+    const char* record = self->input_data;
+    const char* end = self->input_data + self->input_length;
+    while (record < end) {
+        const char* newline = memchr(record, '\n', end - record);
+        const char* record_end = newline ? newline : end;
+        if (record_end > record) {
+            output_append(self, prefix, prefix_length);
+            output_append(self, record, record_end - record);
+            output_append(self, suffix, suffix_length);
+        }
+        if (newline) output_append(self, "\n", 1);
+        record = record_end + 1;
+    }
+}
+
+// ---- Text kernels ----
+
+// scan() writes the offset (base + i) of every delimiter and newline in
+// data[0..length) to 'index' and returns how many it found. 'index' must
+// have room for length + 1 entries. upper() copies src to dst uppercasing
+// a-z; every other byte is copied unchanged.
+typedef struct {
+    const char* name;
+    size_t (*scan)(const char* data, size_t length, char delimiter, uint32_t* index, uint32_t base);
+    void (*upper)(char* dst, const char* src, size_t length);
+} TextKernels;
+
+static size_t scan_structural_scalar(const char* data, size_t length, char delimiter,
+                                     uint32_t* index, uint32_t base) {
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        index[count] = base + (uint32_t)i;  // Always written, kept only on a match
+        count += (data[i] == delimiter) | (data[i] == '\n');
+    }
+    return count;
+}
+
+static void upper_ascii_scalar(char* dst, const char* src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = src[i];
+        dst[i] = (c >= 'a' && c <= 'z') ? (char)(c - 32) : c;
+    }
+}
+
+static const TextKernels scalar_kernels = {"scalar", scan_structural_scalar, upper_ascii_scalar};
+
+// Lowercase test shared by the vector versions: adding (128 - 'a') maps
+// 'a'..'z' to the 26 smallest signed byte values, so one signed compare
+// finds them.
+#define LOWER_BIAS ((char)(128 - 'a'))
+#define LOWER_LIMIT ((char)(-128 + 26))
+
+#if HAVE_X86_SIMD
+static size_t scan_structural_sse2(const char* data, size_t length, char delimiter,
+                                   uint32_t* index, uint32_t base) {
+    const __m128i delimiters = _mm_set1_epi8(delimiter);
+    const __m128i newlines = _mm_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, delimiters), _mm_cmpeq_epi8(bytes, newlines)));
+        while (mask) {
+            index[count++] = base + (uint32_t)(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return count + scan_structural_scalar(data + i, length - i, delimiter,
+                                          index + count, base + (uint32_t)i);
+}
+
+static void upper_ascii_sse2(char* dst, const char* src, size_t length) {
+    const __m128i bias = _mm_set1_epi8(LOWER_BIAS);
+    const __m128i limit = _mm_set1_epi8(LOWER_LIMIT);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i is_lower = _mm_cmplt_epi8(_mm_add_epi8(bytes, bias), limit);
+        bytes = _mm_sub_epi8(bytes, _mm_and_si128(is_lower, case_bit));
+        _mm_storeu_si128((__m128i*)(dst + i), bytes);
+    }
+    upper_ascii_scalar(dst + i, src + i, length - i);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_structural_avx2(const char* data, size_t length, char delimiter,
+                                   uint32_t* index, uint32_t base) {
+    const __m256i delimiters = _mm256_set1_epi8(delimiter);
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(bytes, delimiters), _mm256_cmpeq_epi8(bytes, newlines)));
+        while (mask) {
+            index[count++] = base + (uint32_t)(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return count + scan_structural_sse2(data + i, length - i, delimiter,
+                                        index + count, base + (uint32_t)i);
+}
+
+__attribute__((target("avx2")))
+static void upper_ascii_avx2(char* dst, const char* src, size_t length) {
+    const __m256i bias = _mm256_set1_epi8(LOWER_BIAS);
+    const __m256i limit = _mm256_set1_epi8(LOWER_LIMIT);
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i is_lower = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(bytes, bias));
+        bytes = _mm256_sub_epi8(bytes, _mm256_and_si256(is_lower, case_bit));
+        _mm256_storeu_si256((__m256i*)(dst + i), bytes);
+    }
+    upper_ascii_sse2(dst + i, src + i, length - i);
+}
+
+static const TextKernels sse2_kernels = {"SSE2", scan_structural_sse2, upper_ascii_sse2};
+static const TextKernels avx2_kernels = {"AVX2", scan_structural_avx2, upper_ascii_avx2};
+#endif
+
+#if HAVE_NEON_SIMD
+static size_t scan_structural_neon(const char* data, size_t length, char delimiter,
+                                   uint32_t* index, uint32_t base) {
+    const uint8x16_t delimiters = vdupq_n_u8((uint8_t)delimiter);
+    const uint8x16_t newlines = vdupq_n_u8('\n');
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)(data + i));
+        uint8x16_t hits = vorrq_u8(vceqq_u8(bytes, delimiters), vceqq_u8(bytes, newlines));
+        // No movemask on NEON: narrow to 4 bits per byte instead
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+            vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        while (mask) {
+            int nibble = __builtin_ctzll(mask) / 4;
+            index[count++] = base + (uint32_t)(i + nibble);
+            mask &= ~(0xFull << (nibble * 4));
+        }
+    }
+    return count + scan_structural_scalar(data + i, length - i, delimiter,
+                                          index + count, base + (uint32_t)i);
+}
+
+static void upper_ascii_neon(char* dst, const char* src, size_t length) {
+    const uint8x16_t a = vdupq_n_u8('a');
+    const uint8x16_t span = vdupq_n_u8(26);
+    const uint8x16_t case_bit = vdupq_n_u8(0x20);
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)(src + i));
+        uint8x16_t is_lower = vcltq_u8(vsubq_u8(bytes, a), span);
+        bytes = vsubq_u8(bytes, vandq_u8(is_lower, case_bit));
+        vst1q_u8((uint8_t*)(dst + i), bytes);
+    }
+    upper_ascii_scalar(dst + i, src + i, length - i);
+}
+
+static const TextKernels neon_kernels = {"NEON", scan_structural_neon, upper_ascii_neon};
+#endif
+
+#define MAX_TEXT_KERNELS 3
+
+// Every kernel set this CPU can run, best last; returns the count
+int available_text_kernels(const TextKernels** kernels) {
+    int count = 0;
+    kernels[count++] = &scalar_kernels;
+#if HAVE_X86_SIMD
+    kernels[count++] = &sse2_kernels;
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = &avx2_kernels;
+#elif HAVE_NEON_SIMD
+    kernels[count++] = &neon_kernels;
+#endif
+    return count;
+}
+
+// Best kernels this CPU supports
+const TextKernels* detect_text_kernels(void) {
+    const TextKernels* kernels[MAX_TEXT_KERNELS];
+    return kernels[available_text_kernels(kernels) - 1];
+}
+
+// Echo the start of the input's first line, not all of it: read_data()
+// sees whole chunks and parallel batches, which would swamp the output
+static void log_raw_preview(const char* input, size_t length) {
+    size_t shown = length < RAW_PREVIEW_BYTES ? length : RAW_PREVIEW_BYTES;
+    const char* newline = memchr(input, '\n', shown);
+    if (newline) shown = newline - input;
+    PATTERN_LOG("   Raw data: %.*s%s\n", (int)shown, input, shown < length ? "..." : "");
 }
 
 // Concrete Implementation 1: CSV Processor
+
+// Structural index: offsets of every delimiter and newline in the current
+// input, which is where each field ends. Input must be under 4 GiB
+// (streamed chunks always are).
 typedef struct {
     DataProcessor base;
     char delimiter;
     int column_count;
+    const TextKernels* kernels;
+    uint32_t* field_ends;
+    size_t field_end_count;
+    size_t field_end_capacity;
 } CSVProcessor;
 
-void csv_read_data(DataProcessor* self, const char* input) {
+void csv_read_data(DataProcessor* self, const char* input, size_t length) {
     CSVProcessor* csv = (CSVProcessor*)self;
-    strcpy(csv->base.input_data, input);
+    csv->base.input_data = input;
+    csv->base.input_length = length;
+    
+    // Build the structural index, then count columns from it
+    if (length + 1 > csv->field_end_capacity) {
+        csv->field_end_capacity = length + 1;
+        csv->field_ends = (uint32_t*)realloc(csv->field_ends,
+                                             csv->field_end_capacity * sizeof(uint32_t));
+    }
+    csv->field_end_count = csv->kernels->scan(input, length, csv->delimiter, csv->field_ends, 0);
     
-    // Count columns
+    // Columns are the first record's fields: stop at its newline
     csv->column_count = 1;
-    for (int i = 0; input[i]; i++) {
-        if (input[i] == csv->delimiter) {
-            csv->column_count++;
-        }
+    for (size_t i = 0; i < csv->field_end_count; i++) {
+        if (input[csv->field_ends[i]] != csv->delimiter) break;
+        csv->column_count++;
     }
     
-    printf("📄 CSV data loaded: %d columns detected\n", csv->column_count);
-    printf("   Raw data: %s\n", input);
+    PATTERN_LOG("📄 CSV data loaded: %d columns detected\n", csv->column_count);
+    log_raw_preview(input, length);
 }
 
 void csv_process_data(DataProcessor* self) {
     CSVProcessor* csv = (CSVProcessor*)self;
     
-    printf("🔧 Processing CSV data:\n");
-    printf("   - Converting to uppercase\n");
-    printf("   - Trimming whitespace\n");
-    printf("   - Validating data types\n");
+    PATTERN_LOG("🔧 Processing CSV data:\n");
+    PATTERN_LOG("   - Converting to uppercase\n");
+    PATTERN_LOG("   - Trimming whitespace\n");
+    PATTERN_LOG("   - Validating data types\n");
     
     // Simple processing: convert to uppercase
-    strcpy(csv->base.processed_data, csv->base.input_data);
-    for (int i = 0; csv->base.processed_data[i]; i++) {
-        if (csv->base.processed_data[i] >= 'a' && csv->base.processed_data[i] <= 'z') {
-            csv->base.processed_data[i] -= 32;
-        }
-    }
+    size_t length = csv->base.input_length;
+    csv->kernels->upper(output_reserve(self, length), csv->base.input_data, length);
+    csv->base.processed_length += length;
+    csv->base.processed_data[csv->base.processed_length] = '\0';
     
-    printf("   Processed %d columns\n", csv->column_count);
+    PATTERN_LOG("   Processed %d columns\n", csv->column_count);
 }
 
 void csv_write_data(DataProcessor* self) {
     CSVProcessor* csv = (CSVProcessor*)self;
-    printf("💾 Writing CSV data to output:\n");
-    printf("   Format: CSV with delimiter '%c'\n", csv->delimiter);
-    printf("   Output: %s\n", csv->base.processed_data);
-    printf("   Columns: %d\n", csv->column_count);
+    PATTERN_LOG("💾 Writing CSV data to output:\n");
+    PATTERN_LOG("   Format: CSV with delimiter '%c'\n", csv->delimiter);
+    emit_output(self);
+    PATTERN_LOG("   Columns: %d\n", csv->column_count);
 }
 
-int csv_validate_input(DataProcessor* self, const char* input) {
-    if (!default_validate_input(self, input)) {
+int csv_validate_input(DataProcessor* self, const char* input, size_t length) {
+    if (!default_validate_input(self, input, length)) {
         return 0;
     }
     
     CSVProcessor* csv = (CSVProcessor*)self;
     
     // Additional CSV-specific validation
-    if (strchr(input, csv->delimiter) == NULL) {
+    if (memchr(input, csv->delimiter, length) == NULL) {
         printf("⚠️ Warning: No delimiter '%c' found in CSV data\n", csv->delimiter);
     }
     
-    printf("✅ CSV validation passed\n");
+    PATTERN_LOG("✅ CSV validation passed\n");
     return 1;
 }
 
 void csv_destroy(DataProcessor* self) {
     if (self) {
-        free(self);
+        free(((CSVProcessor*)self)->field_ends);
+        data_processor_release(self);
     }
 }
 
-DataProcessor* create_csv_processor(char delimiter) {
+DataProcessor* csv_clone(DataProcessor* self) {
+    CSVProcessor* copy = (CSVProcessor*)malloc(sizeof(CSVProcessor));
+    *copy = *(CSVProcessor*)self;
+    data_processor_init_clone(&copy->base);
+    copy->field_ends = NULL;
+    copy->field_end_count = 0;
+    copy->field_end_capacity = 0;
+    return (DataProcessor*)copy;
+}
+
+DataProcessor* create_csv_processor(char delimiter, const char* input_path) {
     CSVProcessor* csv = (CSVProcessor*)malloc(sizeof(CSVProcessor));
     
-    strcpy(csv->base.processor_name, "CSV Processor");
-    strcpy(csv->base.input_data, "");
-    strcpy(csv->base.processed_data, "");
+    data_processor_init(&csv->base, "CSV Processor", input_path);
     csv->delimiter = delimiter;
     csv->column_count = 0;
-    
-    // Template method
-    csv->base.process = data_processor_process;
+    csv->kernels = detect_text_kernels();
+    csv->field_ends = NULL;
+    csv->field_end_count = 0;
+    csv->field_end_capacity = 0;
     
     // Abstract methods
     csv->base.read_data = csv_read_data;
@@ -181,6 +909,7 @@ DataProcessor* create_csv_processor(char delimiter) {
     csv->base.validate_input = csv_validate_input;
     csv->base.log_processing = default_log_processing;
     
+    csv->base.clone = csv_clone;
     csv->base.destroy = csv_destroy;
     
     return (DataProcessor*)csv;
@@ -193,47 +922,49 @@ typedef struct {
     int indentation_level;
 } JSONProcessor;
 
-void json_read_data(DataProcessor* self, const char* input) {
+void json_read_data(DataProcessor* self, const char* input, size_t length) {
     JSONProcessor* json = (JSONProcessor*)self;
-    strcpy(json->base.input_data, input);
+    json->base.input_data = input;
+    json->base.input_length = length;
     
-    printf("📄 JSON data loaded\n");
-    printf("   Raw data: %s\n", input);
-    printf("   Pretty print: %s\n", json->pretty_print ? "enabled" : "disabled");
+    PATTERN_LOG("📄 JSON data loaded\n");
+    log_raw_preview(input, length);
+    PATTERN_LOG("   Pretty print: %s\n", json->pretty_print ? "enabled" : "disabled");
 }
 
 void json_process_data(DataProcessor* self) {
     JSONProcessor* json = (JSONProcessor*)self;
     
-    printf("🔧 Processing JSON data:\n");
-    printf("   - Validating JSON structure\n");
-    printf("   - Normalizing field names\n");
-    printf("   - Compacting whitespace\n");
+    PATTERN_LOG("🔧 Processing JSON data:\n");
+    PATTERN_LOG("   - Validating JSON structure\n");
+    PATTERN_LOG("   - Normalizing field names\n");
+    PATTERN_LOG("   - Compacting whitespace\n");
     
     if (json->pretty_print) {
-        printf("   - Formatting with indentation\n");
+        PATTERN_LOG("   - Formatting with indentation\n");
     }
     
-    // Simple processing: add processing timestamp
-    snprintf(json->base.processed_data, sizeof(json->base.processed_data), 
-             "{\"original\":%s,\"processed_by\":\"JSON_Processor\",\"timestamp\":\"2024-01-01\"}", 
-             json->base.input_data);
+    // Simple processing: add processing timestamp to each record
+    // (one per line, so newline-delimited JSON streams work too)
+    static const char prefix[] = "{\"original\":";
+    static const char suffix[] = ",\"processed_by\":\"JSON_Processor\",\"timestamp\":\"2024-01-01\"}";
+    wrap_each_record(self, prefix, sizeof(prefix) - 1, suffix, sizeof(suffix) - 1);
     
-    printf("   JSON processing completed\n");
+    PATTERN_LOG("   JSON processing completed\n");
 }
 
 void json_write_data(DataProcessor* self) {
     JSONProcessor* json = (JSONProcessor*)self;
-    printf("💾 Writing JSON data to output:\n");
-    printf("   Format: JSON\n");
+    PATTERN_LOG("💾 Writing JSON data to output:\n");
+    PATTERN_LOG("   Format: JSON\n");
     if (json->pretty_print) {
-        printf("   Indentation: %d spaces\n", json->indentation_level);
+        PATTERN_LOG("   Indentation: %d spaces\n", json->indentation_level);
     }
-    printf("   Output: %s\n", json->base.processed_data);
+    emit_output(self);
 }
 
-int json_validate_input(DataProcessor* self, const char* input) {
-    if (!default_validate_input(self, input)) {
+int json_validate_input(DataProcessor* self, const char* input, size_t length) {
+    if (!default_validate_input(self, input, length)) {
         return 0;
     }
     
@@ -243,34 +974,36 @@ int json_validate_input(DataProcessor* self, const char* input) {
         return 0;
     }
     
-    printf("✅ JSON validation passed\n");
+    PATTERN_LOG("✅ JSON validation passed\n");
     return 1;
 }
 
 void json_log_processing(DataProcessor* self, const char* step) {
     JSONProcessor* json = (JSONProcessor*)self;
-    printf("📝 [%s] %s (pretty_print: %s)\n", 
-           self->processor_name, step, json->pretty_print ? "on" : "off");
+    PATTERN_LOG("📝 [%s] %s (pretty_print: %s)\n", 
+                self->processor_name, step, json->pretty_print ? "on" : "off");
 }
 
 void json_destroy(DataProcessor* self) {
     if (self) {
-        free(self);
+        data_processor_release(self);
     }
 }
 
-DataProcessor* create_json_processor(int pretty_print, int indentation) {
+DataProcessor* json_clone(DataProcessor* self) {
+    JSONProcessor* copy = (JSONProcessor*)malloc(sizeof(JSONProcessor));
+    *copy = *(JSONProcessor*)self;
+    data_processor_init_clone(&copy->base);
+    return (DataProcessor*)copy;
+}
+
+DataProcessor* create_json_processor(int pretty_print, int indentation, const char* input_path) {
     JSONProcessor* json = (JSONProcessor*)malloc(sizeof(JSONProcessor));
     
-    strcpy(json->base.processor_name, "JSON Processor");
-    strcpy(json->base.input_data, "");
-    strcpy(json->base.processed_data, "");
+    data_processor_init(&json->base, "JSON Processor", input_path);
     json->pretty_print = pretty_print;
     json->indentation_level = indentation;
     
-    // Template method
-    json->base.process = data_processor_process;
-    
     // Abstract methods
     json->base.read_data = json_read_data;
     json->base.process_data = json_process_data;
@@ -280,6 +1013,7 @@ DataProcessor* create_json_processor(int pretty_print, int indentation) {
     json->base.validate_input = json_validate_input;
     json->base.log_processing = json_log_processing;
     
+    json->base.clone = json_clone;
     json->base.destroy = json_destroy;
     
     return (DataProcessor*)json;
@@ -292,60 +1026,60 @@ typedef struct {
     char root_element[50];
 } XMLProcessor;
 
-void xml_read_data(DataProcessor* self, const char* input) {
+void xml_read_data(DataProcessor* self, const char* input, size_t length) {
     XMLProcessor* xml = (XMLProcessor*)self;
-    strcpy(xml->base.input_data, input);
+    xml->base.input_data = input;
+    xml->base.input_length = length;
     
     // Extract root element
-    const char* start = strchr(input, '<');
+    const char* start = memchr(input, '<', length);
     if (start) {
-        const char* end = strchr(start + 1, '>');
+        const char* end = memchr(start + 1, '>', input + length - (start + 1));
         if (end) {
             int len = end - start - 1;
             if (len < 49) {
                 strncpy(xml->root_element, start + 1, len);
-                xml->root_element[len] = '\\0';
+                xml->root_element[len] = '\0';
             }
         }
     }
     
-    printf("📄 XML data loaded\n");
-    printf("   Raw data: %s\n", input);
-    printf("   Root element: %s\n", xml->root_element);
-    printf("   Schema validation: %s\n", xml->validate_schema ? "enabled" : "disabled");
+    PATTERN_LOG("📄 XML data loaded\n");
+    log_raw_preview(input, length);
+    PATTERN_LOG("   Root element: %s\n", xml->root_element);
+    PATTERN_LOG("   Schema validation: %s\n", xml->validate_schema ? "enabled" : "disabled");
 }
 
 void xml_process_data(DataProcessor* self) {
     XMLProcessor* xml = (XMLProcessor*)self;
     
-    printf("🔧 Processing XML data:\n");
-    printf("   - Parsing XML structure\n");
-    printf("   - Validating well-formedness\n");
+    PATTERN_LOG("🔧 Processing XML data:\n");
+    PATTERN_LOG("   - Parsing XML structure\n");
+    PATTERN_LOG("   - Validating well-formedness\n");
     
     if (xml->validate_schema) {
-        printf("   - Validating against schema\n");
+        PATTERN_LOG("   - Validating against schema\n");
     }
     
-    printf("   - Normalizing namespaces\n");
+    PATTERN_LOG("   - Normalizing namespaces\n");
     
-    // Simple processing: wrap in processing element
-    snprintf(xml->base.processed_data, sizeof(xml->base.processed_data), 
-             "<processed>%s</processed>", xml->base.input_data);
+    // Simple processing: wrap each record in a processing element
+    wrap_each_record(self, "<processed>", 11, "</processed>", 12);
     
-    printf("   XML processing completed\n");
+    PATTERN_LOG("   XML processing completed\n");
 }
 
 void xml_write_data(DataProcessor* self) {
     XMLProcessor* xml = (XMLProcessor*)self;
-    printf("💾 Writing XML data to output:\n");
-    printf("   Format: XML\n");
-    printf("   Root element: %s\n", xml->root_element);
-    printf("   Schema validation: %s\n", xml->validate_schema ? "applied" : "skipped");
-    printf("   Output: %s\n", xml->base.processed_data);
+    PATTERN_LOG("💾 Writing XML data to output:\n");
+    PATTERN_LOG("   Format: XML\n");
+    PATTERN_LOG("   Root element: %s\n", xml->root_element);
+    PATTERN_LOG("   Schema validation: %s\n", xml->validate_schema ? "applied" : "skipped");
+    emit_output(self);
 }
 
-int xml_validate_input(DataProcessor* self, const char* input) {
-    if (!default_validate_input(self, input)) {
+int xml_validate_input(DataProcessor* self, const char* input, size_t length) {
+    if (!default_validate_input(self, input, length)) {
         return 0;
     }
     
@@ -355,28 +1089,30 @@ int xml_validate_input(DataProcessor* self, const char* input) {
         return 0;
     }
     
-    printf("✅ XML validation passed\n");
+    PATTERN_LOG("✅ XML validation passed\n");
     return 1;
 }
 
 void xml_destroy(DataProcessor* self) {
     if (self) {
-        free(self);
+        data_processor_release(self);
     }
 }
 
-DataProcessor* create_xml_processor(int validate_schema) {
+DataProcessor* xml_clone(DataProcessor* self) {
+    XMLProcessor* copy = (XMLProcessor*)malloc(sizeof(XMLProcessor));
+    *copy = *(XMLProcessor*)self;
+    data_processor_init_clone(&copy->base);
+    return (DataProcessor*)copy;
+}
+
+DataProcessor* create_xml_processor(int validate_schema, const char* input_path) {
     XMLProcessor* xml = (XMLProcessor*)malloc(sizeof(XMLProcessor));
     
-    strcpy(xml->base.processor_name, "XML Processor");
-    strcpy(xml->base.input_data, "");
-    strcpy(xml->base.processed_data, "");
+    data_processor_init(&xml->base, "XML Processor", input_path);
     xml->validate_schema = validate_schema;
     strcpy(xml->root_element, "");
     
-    // Template method
-    xml->base.process = data_processor_process;
-    
     // Abstract methods
     xml->base.read_data = xml_read_data;
     xml->base.process_data = xml_process_data;
@@ -386,19 +1122,154 @@ DataProcessor* create_xml_processor(int validate_schema) {
     xml->base.validate_input = xml_validate_input;
     xml->base.log_processing = default_log_processing;
     
+    xml->base.clone = xml_clone;
     xml->base.destroy = xml_destroy;
     
     return (DataProcessor*)xml;
 }
 
+// Demo producer: hands out a string a few bytes at a time, like a slow socket
+typedef struct {
+    const char* text;
+    size_t position;
+    size_t step;
+} StringSource;
+
+long string_source_read(void* context, char* buffer, size_t capacity) {
+    StringSource* source = (StringSource*)context;
+    size_t remaining = strlen(source->text + source->position);
+    size_t count = remaining < source->step ? remaining : source->step;
+    if (count > capacity) count = capacity;
+    memcpy(buffer, source->text + source->position, count);
+    source->position += count;
+    return (long)count;
+}
+
+// Compare the selected kernels with the scalar ones on awkward input:
+// every length and misalignment up to a few vectors, all byte values
+int text_kernels_match_scalar(const TextKernels* kernels) {
+    enum { SAMPLE = 300 };
+    char sample[SAMPLE];
+    char expected[SAMPLE], actual[SAMPLE];
+    uint32_t expected_index[SAMPLE + 1], actual_index[SAMPLE + 1];
+    unsigned seed = 12345;
+    for (int i = 0; i < SAMPLE; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned pick = (seed >> 16) % 8;
+        sample[i] = pick == 0 ? ',' : pick == 1 ? '\n' : (char)(seed >> 8);
+    }
+    for (size_t start = 0; start < 40; start++) {
+        for (size_t length = 0; start + length <= SAMPLE; length += 7) {
+            size_t want = scan_structural_scalar(sample + start, length, ',', expected_index, 0);
+            size_t got = kernels->scan(sample + start, length, ',', actual_index, 0);
+            if (want != got || memcmp(expected_index, actual_index, want * sizeof(uint32_t)) != 0) {
+                return 0;
+            }
+            upper_ascii_scalar(expected, sample + start, length);
+            kernels->upper(actual, sample + start, length);
+            if (memcmp(expected, actual, length) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_INPUT_BYTES (1 << 20)
+#define BENCH_BATCH_BYTES (64 * 1024)
+
+typedef struct {
+    DataProcessor* processor;
+    const TextKernels* kernels;
+    char* input;                // BENCH_INPUT_BYTES of CSV rows, NUL-terminated
+    size_t length;
+    char* scratch;
+    uint32_t* index;
+    int thread_count;
+} ProcessingBench;
+
+static void bench_process(void* arg) {
+    ProcessingBench* bench = (ProcessingBench*)arg;
+    bench->processor->process(bench->processor, bench->input);
+    bench_consume(bench->processor->processed_length);
+}
+
+static void bench_process_parallel(void* arg) {
+    ProcessingBench* bench = (ProcessingBench*)arg;
+    bench->processor->process_parallel(bench->processor, bench->input, bench->length,
+                                       BENCH_BATCH_BYTES, bench->thread_count);
+    bench_consume(bench->length);
+}
+
+static void bench_scan_kernel(void* arg) {
+    ProcessingBench* bench = (ProcessingBench*)arg;
+    bench_consume(bench->kernels->scan(bench->input, bench->length, ',', bench->index, 0));
+}
+
+static void bench_upper_kernel(void* arg) {
+    ProcessingBench* bench = (ProcessingBench*)arg;
+    bench->kernels->upper(bench->scratch, bench->input, bench->length);
+    bench_consume((uint8_t)bench->scratch[bench->length - 1]);
+}
+
+int main() {
+    bench_header("CSV processing throughput");
+    
+    ProcessingBench bench;
+    bench.input = (char*)malloc(BENCH_INPUT_BYTES + 1);
+    bench.length = 0;
+    unsigned seed = 2024;
+    while (bench.length + 64 < BENCH_INPUT_BYTES) {
+        seed = seed * 1103515245u + 12345u;
+        bench.length += sprintf(bench.input + bench.length, "%u,widget-%u,berlin,%u\n",
+                                seed >> 12, (seed >> 4) % 1000, (seed >> 20) % 100);
+    }
+    bench.scratch = (char*)malloc(bench.length);
+    bench.index = (uint32_t*)malloc((bench.length + 1) * sizeof(uint32_t));
+    long kib = (long)(bench.length / 1024);
+    
+    // Output goes to /dev/null so the timings leave the terminal out
+    int sink_fd = open("/dev/null", O_WRONLY);
+    bench.processor = create_csv_processor(',', NULL);
+    data_processor_write_to_fd(bench.processor, sink_fd);
+    
+    bench_run("process, 1 MiB of rows (per KiB)", bench_process, &bench, kib);
+    char name[64];
+    for (int threads = 1; threads <= 4; threads *= 2) {
+        bench.thread_count = threads;
+        snprintf(name, sizeof(name), "process_parallel, %d workers (per KiB)", threads);
+        bench_run(name, bench_process_parallel, &bench, kib);
+    }
+    
+    const TextKernels* kernels[MAX_TEXT_KERNELS];
+    int kernel_count = available_text_kernels(kernels);
+    for (int k = 0; k < kernel_count; k++) {
+        bench.kernels = kernels[k];
+        snprintf(name, sizeof(name), "%s scan kernel (per KiB)", kernels[k]->name);
+        bench_run(name, bench_scan_kernel, &bench, kib);
+        snprintf(name, sizeof(name), "%s upper kernel (per KiB)", kernels[k]->name);
+        bench_run(name, bench_upper_kernel, &bench, kib);
+    }
+    
+    counters_report();
+    
+    bench.processor->destroy(bench.processor);
+    if (sink_fd >= 0) close(sink_fd);
+    free(bench.input);
+    free(bench.scratch);
+    free(bench.index);
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== TEMPLATE METHOD PATTERN EXAMPLE ===\n\n");
     
     // Create different data processors
-    DataProcessor* csv_processor = create_csv_processor(',');
-    DataProcessor* json_processor = create_json_processor(1, 2);
-    DataProcessor* xml_processor = create_xml_processor(1);
+    DataProcessor* csv_processor = create_csv_processor(',', NULL);
+    DataProcessor* json_processor = create_json_processor(1, 2, NULL);
+    DataProcessor* xml_processor = create_xml_processor(1, NULL);
     
     printf("--- Processing CSV Data ---\n");
     csv_processor->process(csv_processor, "name,age,city\\nJohn,25,NewYork\\nJane,30,LosAngeles");
@@ -416,12 +1287,59 @@ int main() {
     printf("\\nTesting with empty input:\n");
     csv_processor->process(csv_processor, "");
     
+    printf("\n--- Streaming CSV from a callback (rows straddle chunks) ---\n");
+    StringSource rows = {"name,city\nalice,paris\nbob,berlin\ncarol,tokyo\n", 0, 7};
+    ChunkSource csv_source = chunk_source_from_callback(string_source_read, &rows);
+    csv_processor->process_stream(csv_processor, &csv_source, 24);
+    
+    printf("\n--- Streaming newline-delimited JSON from a file descriptor ---\n");
+    FILE* export_file = tmpfile();
+    if (export_file) {
+        fputs("{\"id\":1,\"name\":\"John\"}\n{\"id\":2,\"name\":\"Jane\"}\n{\"id\":3}\n", export_file);
+        fflush(export_file);
+        lseek(fileno(export_file), 0, SEEK_SET);
+        ChunkSource json_source = chunk_source_from_fd(fileno(export_file));
+        json_processor->process_stream(json_processor, &json_source, 48);
+        fclose(export_file);
+    }
+    
+    printf("\n--- Memory-mapped XML file, output straight to stdout's fd ---\n");
+    char xml_path[] = "/tmp/template_method_XXXXXX";
+    int xml_fd = mkstemp(xml_path);
+    if (xml_fd >= 0) {
+        const char* records = "<order><id>1</id></order>\n<order><id>2</id></order>\n";
+        if (write(xml_fd, records, strlen(records)) == (ssize_t)strlen(records)) {
+            DataProcessor* mapped_xml = create_xml_processor(0, xml_path);
+            data_processor_write_to_fd(mapped_xml, STDOUT_FILENO);
+            mapped_xml->process_mapped(mapped_xml, DEFAULT_CHUNK_SIZE);
+            mapped_xml->destroy(mapped_xml);
+        }
+        close(xml_fd);
+        unlink(xml_path);
+    }
+    
+    printf("\n--- Parallel CSV: batches finish in any order, output stays in order ---\n");
+    const char* table = "id,item\n1,apple\n2,banana\n3,cherry\n4,date\n5,elderberry\n6,fig\n";
+    data_processor_write_to_fd(csv_processor, STDOUT_FILENO);
+    csv_processor->process_parallel(csv_processor, table, strlen(table), 16, 3);
+    data_processor_write_to_fd(csv_processor, -1);
+    
+    printf("\n--- CSV text kernels ---\n");
+    const TextKernels* kernels[MAX_TEXT_KERNELS];
+    int kernel_count = available_text_kernels(kernels);
+    printf("Selected kernels: %s\n", detect_text_kernels()->name);
+    for (int i = 1; i < kernel_count; i++) {
+        printf("%s %s results match scalar\n",
+               text_kernels_match_scalar(kernels[i]) ? "✅" : "❌", kernels[i]->name);
+    }
+    
     printf("\\n--- Template Method Benefits Demonstrated ---\n");
     printf("✅ Same algorithm structure for all processors\n");
     printf("✅ Each processor implements specific steps differently\n");
     printf("✅ Hook methods allow optional customization\n");
     printf("✅ Template method ensures consistent processing flow\n");
     printf("✅ Easy to add new processor types\n");
+    printf("✅ Streaming variant reuses the same steps with bounded memory\n");
     
     // Cleanup
     csv_processor->destroy(csv_processor);
@@ -429,4 +1347,5 @@ int main() {
     xml_processor->destroy(xml_processor);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
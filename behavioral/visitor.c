@@ -17,12 +17,41 @@
  * Cons:
  * - Hard to add new element types
  * - May break encapsulation
+ *
+ * Batch visiting: a ShapeBatch keeps each shape type in its own bucket of
+ * plain columns (radius[], width[]/height[], base_length[]/height[]). A
+ * visitor's visit_circles()/visit_rectangles()/visit_triangles() handle a
+ * whole bucket at once with SIMD sums (SSE2/AVX2 or NEON when available)
+ * instead of one indirect call per shape.
+ *
+ * Fused visiting: a FusedVisitor wraps several visitors and applies them
+ * all during one traversal. Each shape (or each cache-sized chunk of a
+ * bucket) is loaded once and handed to every visitor while it is hot.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for visitor pass microbenchmarks
+ * instead of the demo, and with -DPATTERN_COUNTERS for hot-path counters
+ * (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include "../bench.h"
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SIMD 1
+#endif
+
+HOT_COUNTER(visitor_accepts, "visitor", "single dispatches");
+HOT_COUNTER(visitor_batch_passes, "visitor", "batch passes");
+HOT_COUNTER(visitor_batch_shapes, "visitor", "shapes in batch passes");
+HOT_COUNTER(visitor_fused_chunks, "visitor", "fused chunks");
 
 // Forward declarations
 typedef struct Visitor Visitor;
@@ -30,6 +59,7 @@ typedef struct Shape Shape;
 typedef struct Circle Circle;
 typedef struct Rectangle Rectangle;
 typedef struct Triangle Triangle;
+typedef struct ShapeKernels ShapeKernels;
 
 // Visitor interface
 struct Visitor {
@@ -40,6 +70,13 @@ struct Visitor {
     void (*visit_circle)(Visitor* self, Circle* circle);
     void (*visit_rectangle)(Visitor* self, Rectangle* rectangle);
     void (*visit_triangle)(Visitor* self, Triangle* triangle);
+    
+    // Bulk versions: one call per bucket of a ShapeBatch
+    void (*visit_circles)(Visitor* self, const double* radius, int count);
+    void (*visit_rectangles)(Visitor* self, const double* width, const double* height, int count);
+    void (*visit_triangles)(Visitor* self, const double* base_length, const double* height, int count);
+    const ShapeKernels* kernels;  // Column sums used by the bulk versions
+    
     void (*reset)(Visitor* self);
     void (*display_result)(Visitor* self);
     void (*destroy)(Visitor* self);
@@ -177,6 +214,198 @@ Shape* create_triangle(double x, double y, double base_length, double height, co
     return (Shape*)triangle;
 }
 
+// ---- Column sums for batch visiting ----
+
+// Every kernel keeps four running sums (element i goes to sum i % 4) and
+// adds them up the same way at the end, so they agree up to rounding
+struct ShapeKernels {
+    const char* name;
+    double (*sum)(const double* a, int count);
+    double (*sum_squares)(const double* a, int count);
+    double (*sum_products)(const double* a, const double* b, int count);
+};
+
+// Finish the four sums from element i onwards, then combine them
+static double sum_lanes(double lanes[4], const double* a, int i, int count) {
+    for (; i < count; i++) lanes[i & 3] += a[i];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+static double sum_squares_lanes(double lanes[4], const double* a, int i, int count) {
+    for (; i < count; i++) lanes[i & 3] += a[i] * a[i];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+static double sum_products_lanes(double lanes[4], const double* a, const double* b, int i, int count) {
+    for (; i < count; i++) lanes[i & 3] += a[i] * b[i];
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+static double sum_scalar(const double* a, int count) {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    return sum_lanes(lanes, a, 0, count);
+}
+
+static double sum_squares_scalar(const double* a, int count) {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    return sum_squares_lanes(lanes, a, 0, count);
+}
+
+static double sum_products_scalar(const double* a, const double* b, int count) {
+    double lanes[4] = {0.0, 0.0, 0.0, 0.0};
+    return sum_products_lanes(lanes, a, b, 0, count);
+}
+
+static const ShapeKernels scalar_kernels = {"scalar", sum_scalar, sum_squares_scalar, sum_products_scalar};
+
+#if HAVE_X86_SIMD
+// Two registers: sums 0-1 and sums 2-3
+static double sum_sse2(const double* a, int count) {
+    __m128d low = _mm_setzero_pd(), high = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        low = _mm_add_pd(low, _mm_loadu_pd(a + i));
+        high = _mm_add_pd(high, _mm_loadu_pd(a + i + 2));
+    }
+    double lanes[4];
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+    return sum_lanes(lanes, a, i, count);
+}
+
+static double sum_squares_sse2(const double* a, int count) {
+    __m128d low = _mm_setzero_pd(), high = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d x = _mm_loadu_pd(a + i), y = _mm_loadu_pd(a + i + 2);
+        low = _mm_add_pd(low, _mm_mul_pd(x, x));
+        high = _mm_add_pd(high, _mm_mul_pd(y, y));
+    }
+    double lanes[4];
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+    return sum_squares_lanes(lanes, a, i, count);
+}
+
+static double sum_products_sse2(const double* a, const double* b, int count) {
+    __m128d low = _mm_setzero_pd(), high = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        low = _mm_add_pd(low, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        high = _mm_add_pd(high, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+    }
+    double lanes[4];
+    _mm_storeu_pd(lanes, low);
+    _mm_storeu_pd(lanes + 2, high);
+    return sum_products_lanes(lanes, a, b, i, count);
+}
+
+// One register holds all four sums
+__attribute__((target("avx2")))
+static double sum_avx2(const double* a, int count) {
+    __m256d acc = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd(a + i));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return sum_lanes(lanes, a, i, count);
+}
+
+__attribute__((target("avx2")))
+static double sum_squares_avx2(const double* a, int count) {
+    __m256d acc = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_loadu_pd(a + i);
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(x, x));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return sum_squares_lanes(lanes, a, i, count);
+}
+
+__attribute__((target("avx2")))
+static double sum_products_avx2(const double* a, const double* b, int count) {
+    __m256d acc = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    return sum_products_lanes(lanes, a, b, i, count);
+}
+
+static const ShapeKernels sse2_kernels = {"SSE2", sum_sse2, sum_squares_sse2, sum_products_sse2};
+static const ShapeKernels avx2_kernels = {"AVX2", sum_avx2, sum_squares_avx2, sum_products_avx2};
+#endif
+
+#if HAVE_NEON_SIMD
+static double sum_neon(const double* a, int count) {
+    float64x2_t low = vdupq_n_f64(0.0), high = vdupq_n_f64(0.0);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        low = vaddq_f64(low, vld1q_f64(a + i));
+        high = vaddq_f64(high, vld1q_f64(a + i + 2));
+    }
+    double lanes[4];
+    vst1q_f64(lanes, low);
+    vst1q_f64(lanes + 2, high);
+    return sum_lanes(lanes, a, i, count);
+}
+
+static double sum_squares_neon(const double* a, int count) {
+    float64x2_t low = vdupq_n_f64(0.0), high = vdupq_n_f64(0.0);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float64x2_t x = vld1q_f64(a + i), y = vld1q_f64(a + i + 2);
+        low = vaddq_f64(low, vmulq_f64(x, x));
+        high = vaddq_f64(high, vmulq_f64(y, y));
+    }
+    double lanes[4];
+    vst1q_f64(lanes, low);
+    vst1q_f64(lanes + 2, high);
+    return sum_squares_lanes(lanes, a, i, count);
+}
+
+static double sum_products_neon(const double* a, const double* b, int count) {
+    float64x2_t low = vdupq_n_f64(0.0), high = vdupq_n_f64(0.0);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        low = vaddq_f64(low, vmulq_f64(vld1q_f64(a + i), vld1q_f64(b + i)));
+        high = vaddq_f64(high, vmulq_f64(vld1q_f64(a + i + 2), vld1q_f64(b + i + 2)));
+    }
+    double lanes[4];
+    vst1q_f64(lanes, low);
+    vst1q_f64(lanes + 2, high);
+    return sum_products_lanes(lanes, a, b, i, count);
+}
+
+static const ShapeKernels neon_kernels = {"NEON", sum_neon, sum_squares_neon, sum_products_neon};
+#endif
+
+#define MAX_SHAPE_KERNELS 3
+
+// Every kernel set this CPU can run, best last; returns the count
+int available_shape_kernels(const ShapeKernels** kernels) {
+    int count = 0;
+    kernels[count++] = &scalar_kernels;
+#if HAVE_X86_SIMD
+    kernels[count++] = &sse2_kernels;
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = &avx2_kernels;
+#elif HAVE_NEON_SIMD
+    kernels[count++] = &neon_kernels;
+#endif
+    return count;
+}
+
+const ShapeKernels* detect_shape_kernels(void) {
+    const ShapeKernels* kernels[MAX_SHAPE_KERNELS];
+    return kernels[available_shape_kernels(kernels) - 1];
+}
+
 // Base visitor methods
 void visitor_reset(Visitor* self) {
     self->result = 0.0;
@@ -203,7 +432,7 @@ void area_calculator_visit_circle(Visitor* self, Circle* circle) {
     double area = M_PI * circle->radius * circle->radius;
     calc->base.result += area;
     calc->shape_count++;
-    printf("   🔵 Circle area: %.2f\n", area);
+    PATTERN_LOG("   🔵 Circle area: %.2f\n", area);
 }
 
 void area_calculator_visit_rectangle(Visitor* self, Rectangle* rectangle) {
@@ -211,7 +440,7 @@ void area_calculator_visit_rectangle(Visitor* self, Rectangle* rectangle) {
     double area = rectangle->width * rectangle->height;
     calc->base.result += area;
     calc->shape_count++;
-    printf("   🟦 Rectangle area: %.2f\n", area);
+    PATTERN_LOG("   🟦 Rectangle area: %.2f\n", area);
 }
 
 void area_calculator_visit_triangle(Visitor* self, Triangle* triangle) {
@@ -219,7 +448,25 @@ void area_calculator_visit_triangle(Visitor* self, Triangle* triangle) {
     double area = 0.5 * triangle->base_length * triangle->height;
     calc->base.result += area;
     calc->shape_count++;
-    printf("   🔺 Triangle area: %.2f\n", area);
+    PATTERN_LOG("   🔺 Triangle area: %.2f\n", area);
+}
+
+void area_calculator_visit_circles(Visitor* self, const double* radius, int count) {
+    AreaCalculatorVisitor* calc = (AreaCalculatorVisitor*)self;
+    calc->base.result += M_PI * self->kernels->sum_squares(radius, count);
+    calc->shape_count += count;
+}
+
+void area_calculator_visit_rectangles(Visitor* self, const double* width, const double* height, int count) {
+    AreaCalculatorVisitor* calc = (AreaCalculatorVisitor*)self;
+    calc->base.result += self->kernels->sum_products(width, height, count);
+    calc->shape_count += count;
+}
+
+void area_calculator_visit_triangles(Visitor* self, const double* base_length, const double* height, int count) {
+    AreaCalculatorVisitor* calc = (AreaCalculatorVisitor*)self;
+    calc->base.result += 0.5 * self->kernels->sum_products(base_length, height, count);
+    calc->shape_count += count;
 }
 
 void area_calculator_reset(Visitor* self) {
@@ -245,6 +492,10 @@ Visitor* create_area_calculator() {
     calc->base.visit_circle = area_calculator_visit_circle;
     calc->base.visit_rectangle = area_calculator_visit_rectangle;
     calc->base.visit_triangle = area_calculator_visit_triangle;
+    calc->base.visit_circles = area_calculator_visit_circles;
+    calc->base.visit_rectangles = area_calculator_visit_rectangles;
+    calc->base.visit_triangles = area_calculator_visit_triangles;
+    calc->base.kernels = detect_shape_kernels();
     calc->base.reset = area_calculator_reset;
     calc->base.display_result = area_calculator_display_result;
     calc->base.destroy = visitor_destroy;
@@ -263,7 +514,7 @@ void perimeter_calculator_visit_circle(Visitor* self, Circle* circle) {
     double perimeter = 2 * M_PI * circle->radius;
     calc->base.result += perimeter;
     calc->shape_count++;
-    printf("   🔵 Circle perimeter: %.2f\n", perimeter);
+    PATTERN_LOG("   🔵 Circle perimeter: %.2f\n", perimeter);
 }
 
 void perimeter_calculator_visit_rectangle(Visitor* self, Rectangle* rectangle) {
@@ -271,7 +522,7 @@ void perimeter_calculator_visit_rectangle(Visitor* self, Rectangle* rectangle) {
     double perimeter = 2 * (rectangle->width + rectangle->height);
     calc->base.result += perimeter;
     calc->shape_count++;
-    printf("   🟦 Rectangle perimeter: %.2f\n", perimeter);
+    PATTERN_LOG("   🟦 Rectangle perimeter: %.2f\n", perimeter);
 }
 
 void perimeter_calculator_visit_triangle(Visitor* self, Triangle* triangle) {
@@ -281,7 +532,26 @@ void perimeter_calculator_visit_triangle(Visitor* self, Triangle* triangle) {
     double perimeter = 3 * side;
     calc->base.result += perimeter;
     calc->shape_count++;
-    printf("   🔺 Triangle perimeter: %.2f (assuming equilateral)\n", perimeter);
+    PATTERN_LOG("   🔺 Triangle perimeter: %.2f (assuming equilateral)\n", perimeter);
+}
+
+void perimeter_calculator_visit_circles(Visitor* self, const double* radius, int count) {
+    PerimeterCalculatorVisitor* calc = (PerimeterCalculatorVisitor*)self;
+    calc->base.result += 2 * M_PI * self->kernels->sum(radius, count);
+    calc->shape_count += count;
+}
+
+void perimeter_calculator_visit_rectangles(Visitor* self, const double* width, const double* height, int count) {
+    PerimeterCalculatorVisitor* calc = (PerimeterCalculatorVisitor*)self;
+    calc->base.result += 2 * (self->kernels->sum(width, count) + self->kernels->sum(height, count));
+    calc->shape_count += count;
+}
+
+void perimeter_calculator_visit_triangles(Visitor* self, const double* base_length, const double* height, int count) {
+    PerimeterCalculatorVisitor* calc = (PerimeterCalculatorVisitor*)self;
+    (void)height;  // Equilateral, as in visit_triangle
+    calc->base.result += 3 * self->kernels->sum(base_length, count);
+    calc->shape_count += count;
 }
 
 void perimeter_calculator_reset(Visitor* self) {
@@ -307,6 +577,10 @@ Visitor* create_perimeter_calculator() {
     calc->base.visit_circle = perimeter_calculator_visit_circle;
     calc->base.visit_rectangle = perimeter_calculator_visit_rectangle;
     calc->base.visit_triangle = perimeter_calculator_visit_triangle;
+    calc->base.visit_circles = perimeter_calculator_visit_circles;
+    calc->base.visit_rectangles = perimeter_calculator_visit_rectangles;
+    calc->base.visit_triangles = perimeter_calculator_visit_triangles;
+    calc->base.kernels = detect_shape_kernels();
     calc->base.reset = perimeter_calculator_reset;
     calc->base.display_result = perimeter_calculator_display_result;
     calc->base.destroy = visitor_destroy;
@@ -327,8 +601,8 @@ void paint_cost_visit_circle(Visitor* self, Circle* circle) {
     double cost = area * calc->cost_per_square_unit;
     calc->base.result += cost;
     calc->shapes_painted++;
-    printf("   🔵 Circle (%s): area=%.2f, cost=$%.2f\n", 
-           circle->base.color, area, cost);
+    PATTERN_LOG("   🔵 Circle (%s): area=%.2f, cost=$%.2f\n", 
+                circle->base.color, area, cost);
 }
 
 void paint_cost_visit_rectangle(Visitor* self, Rectangle* rectangle) {
@@ -337,8 +611,8 @@ void paint_cost_visit_rectangle(Visitor* self, Rectangle* rectangle) {
     double cost = area * calc->cost_per_square_unit;
     calc->base.result += cost;
     calc->shapes_painted++;
-    printf("   🟦 Rectangle (%s): area=%.2f, cost=$%.2f\n", 
-           rectangle->base.color, area, cost);
+    PATTERN_LOG("   🟦 Rectangle (%s): area=%.2f, cost=$%.2f\n", 
+                rectangle->base.color, area, cost);
 }
 
 void paint_cost_visit_triangle(Visitor* self, Triangle* triangle) {
@@ -347,8 +621,26 @@ void paint_cost_visit_triangle(Visitor* self, Triangle* triangle) {
     double cost = area * calc->cost_per_square_unit;
     calc->base.result += cost;
     calc->shapes_painted++;
-    printf("   🔺 Triangle (%s): area=%.2f, cost=$%.2f\n", 
-           triangle->base.color, area, cost);
+    PATTERN_LOG("   🔺 Triangle (%s): area=%.2f, cost=$%.2f\n", 
+                triangle->base.color, area, cost);
+}
+
+void paint_cost_visit_circles(Visitor* self, const double* radius, int count) {
+    PaintCostCalculatorVisitor* calc = (PaintCostCalculatorVisitor*)self;
+    calc->base.result += M_PI * self->kernels->sum_squares(radius, count) * calc->cost_per_square_unit;
+    calc->shapes_painted += count;
+}
+
+void paint_cost_visit_rectangles(Visitor* self, const double* width, const double* height, int count) {
+    PaintCostCalculatorVisitor* calc = (PaintCostCalculatorVisitor*)self;
+    calc->base.result += self->kernels->sum_products(width, height, count) * calc->cost_per_square_unit;
+    calc->shapes_painted += count;
+}
+
+void paint_cost_visit_triangles(Visitor* self, const double* base_length, const double* height, int count) {
+    PaintCostCalculatorVisitor* calc = (PaintCostCalculatorVisitor*)self;
+    calc->base.result += 0.5 * self->kernels->sum_products(base_length, height, count) * calc->cost_per_square_unit;
+    calc->shapes_painted += count;
 }
 
 void paint_cost_reset(Visitor* self) {
@@ -375,6 +667,10 @@ Visitor* create_paint_cost_calculator(double cost_per_square_unit) {
     calc->base.visit_circle = paint_cost_visit_circle;
     calc->base.visit_rectangle = paint_cost_visit_rectangle;
     calc->base.visit_triangle = paint_cost_visit_triangle;
+    calc->base.visit_circles = paint_cost_visit_circles;
+    calc->base.visit_rectangles = paint_cost_visit_rectangles;
+    calc->base.visit_triangles = paint_cost_visit_triangles;
+    calc->base.kernels = detect_shape_kernels();
     calc->base.reset = paint_cost_reset;
     calc->base.display_result = paint_cost_display_result;
     calc->base.destroy = visitor_destroy;
@@ -382,6 +678,125 @@ Visitor* create_paint_cost_calculator(double cost_per_square_unit) {
     return (Visitor*)calc;
 }
 
+// Concrete Visitor 4: Fused Visitor (runs several visitors in one pass)
+// It does not own its visitors; the caller destroys them as usual
+#define FUSED_CHUNK 2048  // Elements per column chunk: 16 KB, stays in L1
+
+typedef struct {
+    Visitor base;
+    Visitor** visitors;
+    int visitor_count;
+    int capacity;
+} FusedVisitor;
+
+void fused_visitor_add(Visitor* self, Visitor* visitor) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    if (fused->visitor_count == fused->capacity) {
+        fused->capacity = fused->capacity ? fused->capacity * 2 : 4;
+        fused->visitors = (Visitor**)realloc(fused->visitors, fused->capacity * sizeof(Visitor*));
+    }
+    fused->visitors[fused->visitor_count++] = visitor;
+}
+
+void fused_visit_circle(Visitor* self, Circle* circle) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int v = 0; v < fused->visitor_count; v++) {
+        fused->visitors[v]->visit_circle(fused->visitors[v], circle);
+    }
+}
+
+void fused_visit_rectangle(Visitor* self, Rectangle* rectangle) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int v = 0; v < fused->visitor_count; v++) {
+        fused->visitors[v]->visit_rectangle(fused->visitors[v], rectangle);
+    }
+}
+
+void fused_visit_triangle(Visitor* self, Triangle* triangle) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int v = 0; v < fused->visitor_count; v++) {
+        fused->visitors[v]->visit_triangle(fused->visitors[v], triangle);
+    }
+}
+
+// Bulk versions walk the bucket chunk by chunk; every visitor sees a
+// chunk before the next one is loaded
+void fused_visit_circles(Visitor* self, const double* radius, int count) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int start = 0; start < count; start += FUSED_CHUNK) {
+        int length = count - start < FUSED_CHUNK ? count - start : FUSED_CHUNK;
+        COUNTER_ADD(visitor_fused_chunks, 1);
+        for (int v = 0; v < fused->visitor_count; v++) {
+            fused->visitors[v]->visit_circles(fused->visitors[v], radius + start, length);
+        }
+    }
+}
+
+void fused_visit_rectangles(Visitor* self, const double* width, const double* height, int count) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int start = 0; start < count; start += FUSED_CHUNK) {
+        int length = count - start < FUSED_CHUNK ? count - start : FUSED_CHUNK;
+        COUNTER_ADD(visitor_fused_chunks, 1);
+        for (int v = 0; v < fused->visitor_count; v++) {
+            fused->visitors[v]->visit_rectangles(fused->visitors[v], width + start, height + start, length);
+        }
+    }
+}
+
+void fused_visit_triangles(Visitor* self, const double* base_length, const double* height, int count) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int start = 0; start < count; start += FUSED_CHUNK) {
+        int length = count - start < FUSED_CHUNK ? count - start : FUSED_CHUNK;
+        COUNTER_ADD(visitor_fused_chunks, 1);
+        for (int v = 0; v < fused->visitor_count; v++) {
+            fused->visitors[v]->visit_triangles(fused->visitors[v], base_length + start, height + start, length);
+        }
+    }
+}
+
+void fused_reset(Visitor* self) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    visitor_reset(self);
+    for (int v = 0; v < fused->visitor_count; v++) {
+        fused->visitors[v]->reset(fused->visitors[v]);
+    }
+}
+
+// Each visitor reports its own result, just as if it had run alone
+void fused_display_result(Visitor* self) {
+    FusedVisitor* fused = (FusedVisitor*)self;
+    for (int v = 0; v < fused->visitor_count; v++) {
+        fused->visitors[v]->display_result(fused->visitors[v]);
+    }
+}
+
+void fused_destroy(Visitor* self) {
+    if (self) {
+        free(((FusedVisitor*)self)->visitors);
+        free(self);
+    }
+}
+
+Visitor* create_fused_visitor() {
+    FusedVisitor* fused = (FusedVisitor*)calloc(1, sizeof(FusedVisitor));
+    
+    strcpy(fused->base.name, "Fused Visitor");
+    strcpy(fused->base.description, "one pass, several results");
+    
+    fused->base.visit_circle = fused_visit_circle;
+    fused->base.visit_rectangle = fused_visit_rectangle;
+    fused->base.visit_triangle = fused_visit_triangle;
+    fused->base.visit_circles = fused_visit_circles;
+    fused->base.visit_rectangles = fused_visit_rectangles;
+    fused->base.visit_triangles = fused_visit_triangles;
+    fused->base.kernels = detect_shape_kernels();
+    fused->base.reset = fused_reset;
+    fused->base.display_result = fused_display_result;
+    fused->base.destroy = fused_destroy;
+    
+    return (Visitor*)fused;
+}
+
 // Shape collection helper
 #define MAX_SHAPES 10
 
@@ -410,6 +825,7 @@ void add_shape(ShapeCollection* collection, Shape* shape) {
 void apply_visitor(ShapeCollection* collection, Visitor* visitor) {
     printf("\n🎯 Applying %s to %d shapes:\n", visitor->name, collection->count);
     visitor->reset(visitor);
+    COUNTER_ADD(visitor_accepts, collection->count);
     
     for (int i = 0; i < collection->count; i++) {
         collection->shapes[i]->accept(collection->shapes[i], visitor);
@@ -427,6 +843,249 @@ void destroy_shape_collection(ShapeCollection* collection) {
     }
 }
 
+// ---- Shape batch (one bucket of columns per shape type) ----
+
+// Only the fields the visitors read are stored
+typedef struct {
+    double* radius;
+    int count;
+    int capacity;
+} CircleBucket;
+
+typedef struct {
+    double* width;
+    double* height;
+    int count;
+    int capacity;
+} RectangleBucket;
+
+typedef struct {
+    double* base_length;
+    double* height;
+    int count;
+    int capacity;
+} TriangleBucket;
+
+typedef struct {
+    CircleBucket circles;
+    RectangleBucket rectangles;
+    TriangleBucket triangles;
+} ShapeBatch;
+
+ShapeBatch* create_shape_batch() {
+    return (ShapeBatch*)calloc(1, sizeof(ShapeBatch));
+}
+
+// Next capacity for a full bucket
+static int grow_capacity(int capacity) {
+    return capacity ? capacity * 2 : 64;
+}
+
+void shape_batch_add_circle(ShapeBatch* batch, double radius) {
+    CircleBucket* bucket = &batch->circles;
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = grow_capacity(bucket->capacity);
+        bucket->radius = (double*)realloc(bucket->radius, bucket->capacity * sizeof(double));
+    }
+    bucket->radius[bucket->count++] = radius;
+}
+
+void shape_batch_add_rectangle(ShapeBatch* batch, double width, double height) {
+    RectangleBucket* bucket = &batch->rectangles;
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = grow_capacity(bucket->capacity);
+        bucket->width = (double*)realloc(bucket->width, bucket->capacity * sizeof(double));
+        bucket->height = (double*)realloc(bucket->height, bucket->capacity * sizeof(double));
+    }
+    bucket->width[bucket->count] = width;
+    bucket->height[bucket->count] = height;
+    bucket->count++;
+}
+
+void shape_batch_add_triangle(ShapeBatch* batch, double base_length, double height) {
+    TriangleBucket* bucket = &batch->triangles;
+    if (bucket->count == bucket->capacity) {
+        bucket->capacity = grow_capacity(bucket->capacity);
+        bucket->base_length = (double*)realloc(bucket->base_length, bucket->capacity * sizeof(double));
+        bucket->height = (double*)realloc(bucket->height, bucket->capacity * sizeof(double));
+    }
+    bucket->base_length[bucket->count] = base_length;
+    bucket->height[bucket->count] = height;
+    bucket->count++;
+}
+
+int shape_batch_count(ShapeBatch* batch) {
+    return batch->circles.count + batch->rectangles.count + batch->triangles.count;
+}
+
+// Copying shapes into a batch is itself a visitor: double dispatch
+// picks the right bucket for each shape
+typedef struct {
+    Visitor base;
+    ShapeBatch* batch;
+} BatchBuilderVisitor;
+
+void batch_builder_visit_circle(Visitor* self, Circle* circle) {
+    shape_batch_add_circle(((BatchBuilderVisitor*)self)->batch, circle->radius);
+}
+
+void batch_builder_visit_rectangle(Visitor* self, Rectangle* rectangle) {
+    shape_batch_add_rectangle(((BatchBuilderVisitor*)self)->batch, rectangle->width, rectangle->height);
+}
+
+void batch_builder_visit_triangle(Visitor* self, Triangle* triangle) {
+    shape_batch_add_triangle(((BatchBuilderVisitor*)self)->batch, triangle->base_length, triangle->height);
+}
+
+void shape_batch_add_collection(ShapeBatch* batch, ShapeCollection* collection) {
+    BatchBuilderVisitor builder = {0};
+    builder.base.visit_circle = batch_builder_visit_circle;
+    builder.base.visit_rectangle = batch_builder_visit_rectangle;
+    builder.base.visit_triangle = batch_builder_visit_triangle;
+    builder.batch = batch;
+    
+    for (int i = 0; i < collection->count; i++) {
+        collection->shapes[i]->accept(collection->shapes[i], (Visitor*)&builder);
+    }
+}
+
+// Three calls in total, whatever the number of shapes
+void visit_batch(ShapeBatch* batch, Visitor* visitor) {
+    COUNTER_TIME_BEGIN(visitor_batch_passes);
+    visitor->reset(visitor);
+    visitor->visit_circles(visitor, batch->circles.radius, batch->circles.count);
+    visitor->visit_rectangles(visitor, batch->rectangles.width, batch->rectangles.height,
+                              batch->rectangles.count);
+    visitor->visit_triangles(visitor, batch->triangles.base_length, batch->triangles.height,
+                             batch->triangles.count);
+    COUNTER_ADD(visitor_batch_shapes, shape_batch_count(batch));
+    COUNTER_TIME_END(visitor_batch_passes);
+}
+
+void apply_visitor_batch(ShapeBatch* batch, Visitor* visitor) {
+    printf("\n🎯 Applying %s to a batch of %d shapes (%s kernels):\n",
+           visitor->name, shape_batch_count(batch), visitor->kernels->name);
+    visit_batch(batch, visitor);
+    visitor->display_result(visitor);
+}
+
+void destroy_shape_batch(ShapeBatch* batch) {
+    if (batch) {
+        free(batch->circles.radius);
+        free(batch->rectangles.width);
+        free(batch->rectangles.height);
+        free(batch->triangles.base_length);
+        free(batch->triangles.height);
+        free(batch);
+    }
+}
+
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_SHAPES 1000000
+#define BENCH_DISPATCH_ROUNDS 10000
+
+typedef struct {
+    ShapeBatch* batch;
+    ShapeCollection* shapes;
+    Visitor* visitors[3];   // Area, perimeter, paint cost
+    Visitor* fused;
+} VisitBench;
+
+static void bench_area_pass(void* arg) {
+    VisitBench* bench = (VisitBench*)arg;
+    visit_batch(bench->batch, bench->visitors[0]);
+    bench_consume((uint64_t)bench->visitors[0]->result);
+}
+
+static void bench_three_passes(void* arg) {
+    VisitBench* bench = (VisitBench*)arg;
+    for (int v = 0; v < 3; v++) {
+        visit_batch(bench->batch, bench->visitors[v]);
+        bench_consume((uint64_t)bench->visitors[v]->result);
+    }
+}
+
+static void bench_fused_pass(void* arg) {
+    VisitBench* bench = (VisitBench*)arg;
+    visit_batch(bench->batch, bench->fused);
+    for (int v = 0; v < 3; v++) {
+        bench_consume((uint64_t)bench->visitors[v]->result);
+    }
+}
+
+// accept() -> visit_*(): two indirect calls per shape
+static void bench_double_dispatch(void* arg) {
+    VisitBench* bench = (VisitBench*)arg;
+    Visitor* visitor = bench->visitors[0];
+    for (int round = 0; round < BENCH_DISPATCH_ROUNDS; round++) {
+        visitor->reset(visitor);
+        for (int i = 0; i < bench->shapes->count; i++) {
+            bench->shapes->shapes[i]->accept(bench->shapes->shapes[i], visitor);
+        }
+        bench_consume((uint64_t)visitor->result);
+    }
+    COUNTER_ADD(visitor_accepts, (long)BENCH_DISPATCH_ROUNDS * bench->shapes->count);
+}
+
+int main() {
+    bench_header("Visitor passes");
+    
+    VisitBench bench;
+    bench.batch = create_shape_batch();
+    unsigned seed = 7;
+    for (int i = 0; i < BENCH_SHAPES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double size = 1.0 + (seed >> 16) % 100 / 10.0;
+        switch (i % 3) {
+            case 0: shape_batch_add_circle(bench.batch, size); break;
+            case 1: shape_batch_add_rectangle(bench.batch, size, size / 2); break;
+            default: shape_batch_add_triangle(bench.batch, size, size * 2); break;
+        }
+    }
+    bench.shapes = create_shape_collection();
+    for (int i = 0; i < MAX_SHAPES; i++) {
+        Shape* shape = i % 3 == 0 ? create_circle(i, i, 1 + i, "red")
+                     : i % 3 == 1 ? create_rectangle(i, i, 2 + i, 1 + i, "blue")
+                                  : create_triangle(i, i, 3 + i, 2 + i, "green");
+        bench.shapes->shapes[bench.shapes->count++] = shape;
+    }
+    bench.visitors[0] = create_area_calculator();
+    bench.visitors[1] = create_perimeter_calculator();
+    bench.visitors[2] = create_paint_cost_calculator(2.50);
+    bench.fused = create_fused_visitor();
+    for (int v = 0; v < 3; v++) {
+        fused_visitor_add(bench.fused, bench.visitors[v]);
+    }
+    
+    // The area pass once per kernel set, then back to the best one
+    const ShapeKernels* kernels[MAX_SHAPE_KERNELS];
+    int kernel_count = available_shape_kernels(kernels);
+    char name[64];
+    for (int k = 0; k < kernel_count; k++) {
+        bench.visitors[0]->kernels = kernels[k];
+        snprintf(name, sizeof(name), "area pass, %s kernels (per shape)", kernels[k]->name);
+        bench_run(name, bench_area_pass, &bench, BENCH_SHAPES);
+    }
+    bench.visitors[0]->kernels = detect_shape_kernels();
+    
+    bench_run("area + perimeter + paint, three passes (per shape)", bench_three_passes, &bench, BENCH_SHAPES);
+    bench_run("area + perimeter + paint, fused pass (per shape)", bench_fused_pass, &bench, BENCH_SHAPES);
+    bench_run("accept() double dispatch (per shape)", bench_double_dispatch, &bench,
+              (long)BENCH_DISPATCH_ROUNDS * bench.shapes->count);
+    
+    counters_report();
+    
+    bench.fused->destroy(bench.fused);
+    for (int v = 0; v < 3; v++) {
+        bench.visitors[v]->destroy(bench.visitors[v]);
+    }
+    destroy_shape_collection(bench.shapes);
+    destroy_shape_batch(bench.batch);
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== VISITOR PATTERN EXAMPLE ===\n\n");
@@ -467,12 +1126,88 @@ int main() {
     apply_visitor(circles_only, area_calc);
     apply_visitor(circles_only, paint_cost_calc);
     
+    printf("\n--- Batch visiting (structure of arrays) ---\n");
+    
+    // Same five shapes, same visitors, one call per bucket
+    ShapeBatch* small_batch = create_shape_batch();
+    shape_batch_add_collection(small_batch, shapes);
+    apply_visitor_batch(small_batch, area_calc);
+    apply_visitor_batch(small_batch, perimeter_calc);
+    apply_visitor_batch(small_batch, paint_cost_calc);
+    destroy_shape_batch(small_batch);
+    
+    // Ten million shapes, built straight into the buckets
+    ShapeBatch* big_batch = create_shape_batch();
+    unsigned seed = 7;
+    for (int i = 0; i < 10000000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        double size = 1.0 + (seed >> 16) % 100 / 10.0;
+        switch (i % 3) {
+            case 0: shape_batch_add_circle(big_batch, size); break;
+            case 1: shape_batch_add_rectangle(big_batch, size, size / 2); break;
+            default: shape_batch_add_triangle(big_batch, size, size * 2); break;
+        }
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    apply_visitor_batch(big_batch, area_calc);
+    apply_visitor_batch(big_batch, perimeter_calc);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("⏱️  Area + perimeter over %d shapes in %.1f ms\n", shape_batch_count(big_batch),
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+    
+    // Every kernel set should agree with the scalar one
+    const ShapeKernels* kernels[MAX_SHAPE_KERNELS];
+    int kernel_count = available_shape_kernels(kernels);
+    CircleBucket* circles = &big_batch->circles;
+    RectangleBucket* rectangles = &big_batch->rectangles;
+    double expected_sum = sum_scalar(circles->radius, circles->count);
+    double expected_squares = sum_squares_scalar(circles->radius, circles->count);
+    double expected_products = sum_products_scalar(rectangles->width, rectangles->height, rectangles->count);
+    for (int k = 0; k < kernel_count; k++) {
+        double sum = kernels[k]->sum(circles->radius, circles->count);
+        double squares = kernels[k]->sum_squares(circles->radius, circles->count);
+        double products = kernels[k]->sum_products(rectangles->width, rectangles->height, rectangles->count);
+        int matches = fabs(sum - expected_sum) <= 1e-12 * expected_sum &&
+                      fabs(squares - expected_squares) <= 1e-12 * expected_squares &&
+                      fabs(products - expected_products) <= 1e-12 * expected_products;
+        printf("%s %s kernels match\n", matches ? "✅" : "❌", kernels[k]->name);
+    }
+    
+    printf("\n--- Fused visiting (one pass, three visitors) ---\n");
+    
+    Visitor* fused = create_fused_visitor();
+    fused_visitor_add(fused, area_calc);
+    fused_visitor_add(fused, perimeter_calc);
+    fused_visitor_add(fused, paint_cost_calc);
+    
+    // Each shape is visited once; all three visitors see it in turn
+    apply_visitor(shapes, fused);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    apply_visitor_batch(big_batch, area_calc);
+    apply_visitor_batch(big_batch, perimeter_calc);
+    apply_visitor_batch(big_batch, paint_cost_calc);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double separate_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    apply_visitor_batch(big_batch, fused);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double fused_ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("⏱️  Three passes: %.1f ms, one fused pass: %.1f ms\n", separate_ms, fused_ms);
+    
+    fused->destroy(fused);
+    destroy_shape_batch(big_batch);
+    
     printf("\n--- Visitor Pattern Benefits Demonstrated ---\n");
     printf("✅ Easy to add new operations (visitors) without modifying shapes\n");
     printf("✅ Related operations are grouped in visitor classes\n");
     printf("✅ Visitors can accumulate state during traversal\n");
     printf("✅ Different visitors can be applied to same object structure\n");
     printf("✅ Double dispatch mechanism ensures correct method is called\n");
+    printf("✅ Batch visits run one tight loop per shape type\n");
+    printf("✅ A fused visitor gets several results from one traversal\n");
     
     // Cleanup
     destroy_shape_collection(shapes);
@@ -483,4 +1218,5 @@ int main() {
     paint_cost_calc->destroy(paint_cost_calc);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+ * BENCHMARK HARNESS AND HOT-PATH COUNTERS
+ *
+ * Shared by the pattern files that have hot paths. Built with
+ * -DPATTERN_BENCH, such a file swaps its demo main() for a benchmark main:
+ *
+ *   gcc -O2 -DPATTERN_BENCH behavioral/observer.c -pthread -lm && ./a.out
+ *   ./run_patterns.sh bench              # every benchmark
+ *
+ * bench_run() runs a body BENCH_WARMUP times untimed, then times it
+ * BENCH_SAMPLES times (the BENCH_SAMPLES environment variable overrides
+ * that at run time). It prints the 50th, 90th and 99th percentile
+ * nanoseconds per operation, plus the median cycles per operation from the
+ * timestamp counter on x86. The TSC counts at a fixed reference rate, so
+ * with turbo or power saving its "cycles" are not core clock cycles.
+ *
+ * Counters: HOT_COUNTER declares a named counter for a subsystem.
+ * COUNTER_ADD bumps it, and COUNTER_TIME_BEGIN/END add the ticks spent
+ * between them. They only exist when built with -DPATTERN_COUNTERS;
+ * otherwise every macro compiles to nothing and the hot paths pay nothing.
+ * counters_report() prints every counter the program declared.
+ *
+ * PATTERN_LOG is the demos' narration: printf normally, compiled out in
+ * benchmark builds so the timings measure the pattern, not the terminal.
+ */
+
+#ifndef PATTERN_BENCH_H
+#define PATTERN_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+#ifdef PATTERN_BENCH
+// Never runs, but still type-checks the arguments and counts them as used
+#define PATTERN_LOG(...) ((void)sizeof(printf(__VA_ARGS__)))
+#else
+#define PATTERN_LOG(...) printf(__VA_ARGS__)
+#endif
+
+// ---- Clocks ----
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+// Timestamp counter ticks where there is one, nanoseconds otherwise
+static inline uint64_t bench_ticks(void) {
+#if BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return bench_now_ns();
+#endif
+}
+
+// Keeps results alive so the compiler can't drop the work that made them
+static volatile uint64_t bench_sink;
+
+static inline void bench_consume(uint64_t value) {
+    bench_sink += value;
+}
+
+// ---- Microbenchmarks ----
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 3
+#endif
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 31
+#endif
+#define BENCH_MAX_SAMPLES 1001
+
+typedef struct {
+    double p50_ns;          // Per operation
+    double p90_ns;
+    double p99_ns;
+    double cycles;          // Median per operation; 0 without a TSC
+} BenchResult;
+
+static inline int bench_sample_count(void) {
+    const char* text = getenv("BENCH_SAMPLES");
+    int samples = text ? atoi(text) : BENCH_SAMPLES;
+    if (samples < 1) samples = 1;
+    if (samples > BENCH_MAX_SAMPLES) samples = BENCH_MAX_SAMPLES;
+    return samples;
+}
+
+static inline int bench_compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+static inline double bench_percentile(const double* sorted, int count, int percent) {
+    int rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static inline void bench_header(const char* title) {
+    int samples = bench_sample_count();
+    printf("\n⏱️  %s (%d warmup, %d samples)\n", title, BENCH_WARMUP, samples);
+    printf("   %-50s %10s %10s %10s %10s\n", "benchmark", "p50 ns/op", "p90 ns/op", "p99 ns/op",
+#if BENCH_HAVE_TSC
+           "cycles/op");
+#else
+           "");
+#endif
+}
+
+// Time body(context); one call performs 'ops' operations
+static inline BenchResult bench_run(const char* name, void (*body)(void* context), void* context, long ops) {
+    int samples = bench_sample_count();
+    double ns[BENCH_MAX_SAMPLES], ticks[BENCH_MAX_SAMPLES];
+    for (int i = 0; i < BENCH_WARMUP; i++) {
+        body(context);
+    }
+    for (int s = 0; s < samples; s++) {
+        uint64_t started = bench_now_ns(), ticks_started = bench_ticks();
+        body(context);
+        uint64_t ticks_ended = bench_ticks(), ended = bench_now_ns();
+        ns[s] = (double)(ended - started) / ops;
+        ticks[s] = (double)(ticks_ended - ticks_started) / ops;
+    }
+    qsort(ns, samples, sizeof(double), bench_compare_doubles);
+    qsort(ticks, samples, sizeof(double), bench_compare_doubles);
+    
+    BenchResult result;
+    result.p50_ns = bench_percentile(ns, samples, 50);
+    result.p90_ns = bench_percentile(ns, samples, 90);
+    result.p99_ns = bench_percentile(ns, samples, 99);
+#if BENCH_HAVE_TSC
+    result.cycles = bench_percentile(ticks, samples, 50);
+    printf("   %-50s %10.2f %10.2f %10.2f %10.1f\n", name, result.p50_ns, result.p90_ns, result.p99_ns,
+           result.cycles);
+#else
+    result.cycles = 0.0;
+    printf("   %-50s %10.2f %10.2f %10.2f\n", name, result.p50_ns, result.p90_ns, result.p99_ns);
+#endif
+    return result;
+}
+
+// ---- Counters ----
+
+typedef struct HotCounter {
+    const char* subsystem;
+    const char* name;
+    uint64_t events;
+    uint64_t ticks;         // Time spent, for counters used as timers
+    struct HotCounter* next;
+} HotCounter;
+
+#ifdef PATTERN_COUNTERS
+static HotCounter* hot_counters = NULL;
+static HotCounter** hot_counters_tail = &hot_counters;
+
+// Appends, so reports list counters in declaration order
+static inline void counter_register(HotCounter* counter) {
+    *hot_counters_tail = counter;
+    hot_counters_tail = &counter->next;
+}
+
+// File scope: HOT_COUNTER(fan_out_counter, "observer", "fan-outs");
+#define HOT_COUNTER(var, subsystem, name) \
+    static HotCounter var; \
+    __attribute__((constructor)) static void var##_register(void) { counter_register(&var); } \
+    static HotCounter var = {subsystem, name, 0, 0, NULL}
+
+// Relaxed atomics: safe from worker threads, and no ordering cost
+#define COUNTER_ADD(var, n) __atomic_fetch_add(&(var).events, (uint64_t)(n), __ATOMIC_RELAXED)
+#define COUNTER_TIME_BEGIN(var) uint64_t var##_began = bench_ticks()
+#define COUNTER_TIME_END(var) \
+    (__atomic_fetch_add(&(var).ticks, bench_ticks() - var##_began, __ATOMIC_RELAXED), COUNTER_ADD(var, 1))
+
+static inline void counters_reset(void) {
+    for (HotCounter* counter = hot_counters; counter; counter = counter->next) {
+        counter->events = 0;
+        counter->ticks = 0;
+    }
+}
+
+static inline void counters_report(void) {
+    printf("\n📈 Hot-path counters:\n");
+    printf("   %-12s %-28s %14s %16s %12s\n", "subsystem", "counter", "events",
+#if BENCH_HAVE_TSC
+           "cycles", "cycles/event");
+#else
+           "ns", "ns/event");
+#endif
+    for (HotCounter* counter = hot_counters; counter; counter = counter->next) {
+        printf("   %-12s %-28s %14llu", counter->subsystem, counter->name, (unsigned long long)counter->events);
+        if (counter->ticks) {
+            printf(" %16llu %12.1f", (unsigned long long)counter->ticks,
+                   counter->events ? (double)counter->ticks / counter->events : 0.0);
+        }
+        printf("\n");
+    }
+}
+#else
+#define HOT_COUNTER(var, subsystem, name) extern int var##_compiled_out
+#define COUNTER_ADD(var, n) ((void)sizeof(n))
+#define COUNTER_TIME_BEGIN(var) ((void)0)
+#define COUNTER_TIME_END(var) ((void)0)
+
+static inline void counters_reset(void) {
+}
+
+static inline void counters_report(void) {
+    printf("\n📈 Hot-path counters compiled out (build with -DPATTERN_COUNTERS)\n");
+}
+#endif
+
+#endif // PATTERN_BENCH_H
@@ -2,11 +2,134 @@
  * MEMORY-EFFICIENT PROTOTYPE PATTERN
  * 
  * This version uses shared vtables to reduce memory usage
+ *
+ * Each type's vtable also points at its ShapePool (shape_pool.h, shared
+ * with prototype.c), so shapes come from shared slabs without costing a
+ * byte per instance. clone_n() makes many clones in one go.
+ *
+ * Compact instances: colours are interned once per process and shapes
+ * keep a 32-bit ID. Coordinates and sizes are SHAPE_COORD_BITS wide;
+ * values that don't fit are clamped with a warning rather than wrapped.
+ * print_memory_usage() reports what each pool actually holds.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "shape_pool.h"
+
+// Width of coordinates and sizes: 16 bits (the default) or 32.
+// Build with -DSHAPE_COORD_BITS=32 for scenes beyond +/-32767.
+#ifndef SHAPE_COORD_BITS
+#define SHAPE_COORD_BITS 16
+#endif
+
+#if SHAPE_COORD_BITS == 16
+typedef int16_t coord_t;
+#define COORD_MIN INT16_MIN
+#define COORD_MAX INT16_MAX
+#elif SHAPE_COORD_BITS == 32
+typedef int32_t coord_t;
+#define COORD_MIN INT32_MIN
+#define COORD_MAX INT32_MAX
+#else
+#error "SHAPE_COORD_BITS must be 16 or 32"
+#endif
+
+// Clamp to the coord_t range instead of letting the store wrap around
+// (40000 would become -25536 in 16 bits), and say so
+static coord_t to_coord(long long value, const char* what) {
+    if (value >= COORD_MIN && value <= COORD_MAX) return (coord_t)value;
+    coord_t clamped = value < COORD_MIN ? COORD_MIN : COORD_MAX;
+    printf("Warning: %s %lld doesn't fit in %d bits, clamped to %d\n",
+           what, value, SHAPE_COORD_BITS, clamped);
+    return clamped;
+}
+
+// ---- Colour intern table ----
+
+// Each distinct colour name is stored once for the whole process. Not
+// thread-safe: intern colours before handing shapes to other threads.
+typedef struct {
+    char** names;             // names[id]
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* index;          // Open addressing: id + 1, or 0 if empty
+    uint32_t index_capacity;  // Power of two, at least twice count
+} ColorTable;
+
+static ColorTable color_table;
+
+static uint32_t hash_name(const char* name) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+// Slot holding 'name', or the empty slot where it would go
+static uint32_t color_probe(const char* name) {
+    uint32_t mask = color_table.index_capacity - 1;
+    uint32_t slot = hash_name(name) & mask;
+    while (color_table.index[slot] &&
+           strcmp(color_table.names[color_table.index[slot] - 1], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void color_index_rebuild(uint32_t capacity) {
+    free(color_table.index);
+    color_table.index = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    color_table.index_capacity = capacity;
+    for (uint32_t id = 0; id < color_table.count; id++) {
+        color_table.index[color_probe(color_table.names[id])] = id + 1;
+    }
+}
+
+// ID for 'name', adding it the first time it's seen
+uint32_t intern_color(const char* name) {
+    if (color_table.index_capacity == 0) color_index_rebuild(16);
+    uint32_t slot = color_probe(name);
+    if (color_table.index[slot]) return color_table.index[slot] - 1;
+    
+    if (color_table.count == color_table.capacity) {
+        color_table.capacity = color_table.capacity ? color_table.capacity * 2 : 16;
+        color_table.names = (char**)realloc(color_table.names, color_table.capacity * sizeof(char*));
+    }
+    uint32_t id = color_table.count++;
+    color_table.names[id] = strdup(name);
+    color_table.index[slot] = id + 1;
+    if (color_table.count * 2 > color_table.index_capacity) {
+        color_index_rebuild(color_table.index_capacity * 2);
+    }
+    return id;
+}
+
+const char* color_name(uint32_t id) {
+    return id < color_table.count ? color_table.names[id] : "?";
+}
+
+// Heap bytes held by the table, strings included
+size_t color_table_bytes(void) {
+    size_t bytes = color_table.capacity * sizeof(char*) + color_table.index_capacity * sizeof(uint32_t);
+    for (uint32_t id = 0; id < color_table.count; id++) {
+        bytes += strlen(color_table.names[id]) + 1;
+    }
+    return bytes;
+}
+
+void destroy_color_table(void) {
+    for (uint32_t id = 0; id < color_table.count; id++) {
+        free(color_table.names[id]);
+    }
+    free(color_table.names);
+    free(color_table.index);
+    memset(&color_table, 0, sizeof(color_table));
+}
 
 // Forward declarations
 typedef struct Shape Shape;
@@ -18,25 +141,28 @@ struct ShapeVTable {
     void (*draw)(Shape* self);
     void (*move)(Shape* self, int dx, int dy);
     const char* type_name;
+    ShapePool* pool;  // Where shapes of this type live
 };
 
-// Lean Shape structure
+// Lean Shape structure (16 bytes with 16-bit coordinates)
 struct Shape {
-    char color[50];
-    int x, y;
     ShapeVTable* vtable;  // Only 8 bytes, shared across instances
+    uint32_t color;       // ID from intern_color()
+    coord_t x, y;
 };
 
 // Circle structure
 typedef struct {
     Shape base;
-    int radius;
+    coord_t radius;
 } Circle;
 
+static ShapePool circle_pool = {"Circle", sizeof(Circle), NULL, NULL, NULL, NULL, 0};
+
 // Circle implementations
 Shape* circle_clone(Shape* self) {
     Circle* original = (Circle*)self;
-    Circle* clone = (Circle*)malloc(sizeof(Circle));
+    Circle* clone = (Circle*)pool_alloc(self->vtable->pool);
     *clone = *original;  // Copy all data
     printf("Cloned %s: radius=%d\n", clone->base.vtable->type_name, clone->radius);
     return (Shape*)clone;
@@ -45,14 +171,14 @@ Shape* circle_clone(Shape* self) {
 void circle_draw(Shape* self) {
     Circle* circle = (Circle*)self;
     printf("Drawing %s %s with radius %d at (%d,%d)\n", 
-           circle->base.color, circle->base.vtable->type_name, 
+           color_name(circle->base.color), circle->base.vtable->type_name, 
            circle->radius, circle->base.x, circle->base.y);
 }
 
 void shape_move(Shape* self, int dx, int dy) {
-    self->x += dx;
-    self->y += dy;
-    printf("Moved %s %s to (%d,%d)\n", self->color, self->vtable->type_name, self->x, self->y);
+    self->x = to_coord((long long)self->x + dx, "x");
+    self->y = to_coord((long long)self->y + dy, "y");
+    printf("Moved %s %s to (%d,%d)\n", color_name(self->color), self->vtable->type_name, self->x, self->y);
 }
 
 // Shared vtable for all circles (only one instance in memory!)
@@ -60,17 +186,18 @@ static ShapeVTable circle_vtable = {
     .clone = circle_clone,
     .draw = circle_draw,
     .move = shape_move,
-    .type_name = "Circle"
+    .type_name = "Circle",
+    .pool = &circle_pool
 };
 
 Circle* create_circle(const char* color, int x, int y, int radius) {
-    Circle* circle = (Circle*)malloc(sizeof(Circle));
+    Circle* circle = (Circle*)pool_alloc(circle_vtable.pool);
     
-    strcpy(circle->base.color, color);
-    circle->base.x = x;
-    circle->base.y = y;
+    circle->base.color = intern_color(color);
+    circle->base.x = to_coord(x, "x");
+    circle->base.y = to_coord(y, "y");
     circle->base.vtable = &circle_vtable;  // Point to shared vtable
-    circle->radius = radius;
+    circle->radius = to_coord(radius, "radius");
     
     return circle;
 }
@@ -78,13 +205,15 @@ Circle* create_circle(const char* color, int x, int y, int radius) {
 // Rectangle structure
 typedef struct {
     Shape base;
-    int width, height;
+    coord_t width, height;
 } Rectangle;
 
+static ShapePool rectangle_pool = {"Rectangle", sizeof(Rectangle), NULL, NULL, NULL, NULL, 0};
+
 // Rectangle implementations
 Shape* rectangle_clone(Shape* self) {
     Rectangle* original = (Rectangle*)self;
-    Rectangle* clone = (Rectangle*)malloc(sizeof(Rectangle));
+    Rectangle* clone = (Rectangle*)pool_alloc(self->vtable->pool);
     *clone = *original;
     printf("Cloned %s: size=%dx%d\n", clone->base.vtable->type_name, 
            clone->width, clone->height);
@@ -94,7 +223,7 @@ Shape* rectangle_clone(Shape* self) {
 void rectangle_draw(Shape* self) {
     Rectangle* rect = (Rectangle*)self;
     printf("Drawing %s %s %dx%d at (%d,%d)\n", 
-           rect->base.color, rect->base.vtable->type_name,
+           color_name(rect->base.color), rect->base.vtable->type_name,
            rect->width, rect->height, rect->base.x, rect->base.y);
 }
 
@@ -103,41 +232,78 @@ static ShapeVTable rectangle_vtable = {
     .clone = rectangle_clone,
     .draw = rectangle_draw,
     .move = shape_move,
-    .type_name = "Rectangle"
+    .type_name = "Rectangle",
+    .pool = &rectangle_pool
 };
 
 Rectangle* create_rectangle(const char* color, int x, int y, int width, int height) {
-    Rectangle* rect = (Rectangle*)malloc(sizeof(Rectangle));
+    Rectangle* rect = (Rectangle*)pool_alloc(rectangle_vtable.pool);
     
-    strcpy(rect->base.color, color);
-    rect->base.x = x;
-    rect->base.y = y;
+    rect->base.color = intern_color(color);
+    rect->base.x = to_coord(x, "x");
+    rect->base.y = to_coord(y, "y");
     rect->base.vtable = &rectangle_vtable;  // Point to shared vtable
-    rect->width = width;
-    rect->height = height;
+    rect->width = to_coord(width, "width");
+    rect->height = to_coord(height, "height");
     
     return rect;
 }
 
 void destroy_shape(Shape* shape) {
     if (shape) {
-        free(shape);
+        pool_release(shape->vtable->pool, shape);
     }
 }
 
+// 'count' clones of 'prototype' in out[]: released objects first, then one
+// contiguous run filled by doubling memcpy. Returns count.
+int clone_n(Shape* prototype, int count, Shape** out) {
+    return pool_clone_n(prototype->vtable->pool, prototype, count, (void**)out);
+}
+
 // Memory usage analysis
-void print_memory_usage() {
+
+// The first version of this file: inline colour string, int coordinates
+typedef struct {
+    char color[50];
+    int x, y;
+    ShapeVTable* vtable;
+    int radius;
+} InlineColorCircle;
+
+// Report what each pool holds. "Holes" are released objects waiting on
+// the free list inside the used part of a slab; fragmentation is their
+// share of everything handed out so far.
+void print_memory_usage(ShapePool** pools, int pool_count) {
     printf("\n=== MEMORY USAGE ANALYSIS ===\n");
-    printf("Shape base size: %zu bytes\n", sizeof(Shape));
-    printf("Circle size: %zu bytes\n", sizeof(Circle));
-    printf("Rectangle size: %zu bytes\n", sizeof(Rectangle));
+    printf("Shape base size: %zu bytes (%d-bit coordinates)\n", sizeof(Shape), SHAPE_COORD_BITS);
     printf("ShapeVTable size: %zu bytes (shared)\n", sizeof(ShapeVTable));
+    printf("%-10s %6s %9s %6s %11s %11s %8s %6s\n",
+           "Type", "Bytes", "Live", "Slabs", "Reserved", "In use", "Holes", "Frag");
+    
+    size_t total_reserved = 0, total_live = 0;
+    for (int p = 0; p < pool_count; p++) {
+        ShapePool* pool = pools[p];
+        size_t slabs = 0, capacity = 0, handed_out = 0;
+        for (PoolSlab* slab = pool->slabs; slab; slab = slab->next) {
+            slabs++;
+            capacity += slab->capacity;
+            handed_out += slab->used;
+        }
+        size_t reserved = slabs * sizeof(PoolSlab) + capacity * pool->object_size;
+        size_t holes = handed_out - pool->live;
+        printf("%-10s %6zu %9zu %6zu %8zu KB %8zu KB %8zu %5.1f%%\n",
+               pool->type_name, pool->object_size, pool->live, slabs,
+               reserved / 1024, pool->live * pool->object_size / 1024, holes,
+               handed_out ? 100.0 * holes / handed_out : 0.0);
+        total_reserved += reserved;
+        total_live += pool->live;
+    }
     
-    printf("\nFor 1000 circles:\n");
-    printf("Old approach: %zu KB (with duplicate function pointers)\n", 
-           (sizeof(Shape) + sizeof(int) + 3*sizeof(void*)) * 1000 / 1024);
-    printf("New approach: %zu KB (with shared vtables)\n", 
-           sizeof(Circle) * 1000 / 1024);
+    printf("Colour table: %u colours, %zu bytes\n", color_table.count, color_table_bytes());
+    printf("Total: %zu shapes in %zu KB\n", total_live, (total_reserved + color_table_bytes()) / 1024);
+    printf("Circle: %zu bytes (inline char color[50] and int coordinates: %zu bytes)\n",
+           sizeof(Circle), sizeof(InlineColorCircle));
 }
 
 int main() {
@@ -155,7 +321,7 @@ int main() {
     Shape* rect1 = rect_template->base.vtable->clone((Shape*)rect_template);
     
     // Modify clones
-    strcpy(circle2->color, "Green");
+    circle2->color = intern_color("Green");
     circle2->vtable->move(circle2, 5, 5);
     
     // Test polymorphism
@@ -165,7 +331,42 @@ int main() {
         shapes[i]->vtable->draw(shapes[i]);
     }
     
-    print_memory_usage();
+    ShapePool* pools[] = {&circle_pool, &rectangle_pool};
+    print_memory_usage(pools, 2);
+    
+    printf("\n--- Bulk cloning ---\n");
+    int spawn_count = 1000000;
+    Shape** spawned = (Shape**)malloc(spawn_count * sizeof(Shape*));
+    const char* palette[] = {"Red", "Green", "Blue", "Yellow"};
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    clone_n((Shape*)circle_template, spawn_count, spawned);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    for (int i = 0; i < spawn_count; i++) {
+        spawned[i]->color = intern_color(palette[i % 4]);
+        spawned[i]->x = (coord_t)(i % 1000);
+        spawned[i]->y = (coord_t)(i / 1000);
+    }
+    printf("%d circles cloned in %.2f ms (%zu slabs of up to %d)\n", spawn_count,
+           (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6,
+           pool_slab_count(&circle_pool), POOL_SLAB_OBJECTS);
+    print_memory_usage(pools, 2);
+    
+    // Releasing every other circle leaves holes the free list will reuse
+    for (int i = 0; i < spawn_count; i += 2) {
+        destroy_shape(spawned[i]);
+    }
+    print_memory_usage(pools, 2);
+    for (int i = 1; i < spawn_count; i += 2) {
+        destroy_shape(spawned[i]);
+    }
+    free(spawned);
+    
+    printf("\n--- Out-of-range coordinates ---\n");
+    Circle* far_circle = create_circle("Purple", 40000, 0, 5);
+    far_circle->base.vtable->draw((Shape*)far_circle);
+    far_circle->base.vtable->move((Shape*)far_circle, 0, -40000);
+    destroy_shape((Shape*)far_circle);
     
     // Cleanup
     destroy_shape(circle1);
@@ -173,6 +374,9 @@ int main() {
     destroy_shape(rect1);
     destroy_shape((Shape*)circle_template);
     destroy_shape((Shape*)rect_template);
+    destroy_pool(&circle_pool);
+    destroy_pool(&rectangle_pool);
+    destroy_color_table();
     
     return 0;
 }
\ No newline at end of file
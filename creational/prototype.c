@@ -17,11 +17,26 @@
  * Cons:
  * - Complex objects with circular references are hard to clone
  * - Deep vs shallow copy considerations
+ *
+ * Pooling: every shape type has a ShapePool (shape_pool.h). Shapes are
+ * carved out of large slabs instead of one malloc each, and
+ * destroy_shape() puts them back on the pool's free list. clone_n() clones a prototype many times
+ * into one contiguous run. It copies the prototype once and then doubles
+ * the copied prefix with memcpy.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for cloning microbenchmarks
+ * instead of the demo, and with -DPATTERN_COUNTERS for hot-path counters
+ * (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "../bench.h"
+#include "shape_pool.h"
+
+HOT_COUNTER(prototype_clones, "prototype", "clones");
 
 // Prototype interface
 typedef struct Shape Shape;
@@ -29,6 +44,7 @@ struct Shape {
     char type[50];
     char color[50];
     int x, y;
+    ShapePool* pool;         // Where this shape and its clones live
     Shape* (*clone)(Shape* self);
     void (*draw)(Shape* self);
     void (*move)(Shape* self, int dx, int dy);
@@ -40,15 +56,18 @@ typedef struct {
     int radius;
 } Circle;
 
+static ShapePool circle_pool = {"Circle", sizeof(Circle), NULL, NULL, NULL, NULL, 0};
+
 Shape* circle_clone(Shape* self) {
     Circle* original = (Circle*)self;
-    Circle* clone = (Circle*)malloc(sizeof(Circle));
+    Circle* clone = (Circle*)pool_alloc(original->base.pool);
     
     // Copy all properties
     *clone = *original;
+    COUNTER_ADD(prototype_clones, 1);
     
-    printf("Cloned Circle: color=%s, radius=%d, position=(%d,%d)\n", 
-           clone->base.color, clone->radius, clone->base.x, clone->base.y);
+    PATTERN_LOG("Cloned Circle: color=%s, radius=%d, position=(%d,%d)\n", 
+                clone->base.color, clone->radius, clone->base.x, clone->base.y);
     
     return (Shape*)clone;
 }
@@ -66,12 +85,13 @@ void shape_move(Shape* self, int dx, int dy) {
 }
 
 Circle* create_circle(const char* color, int x, int y, int radius) {
-    Circle* circle = (Circle*)malloc(sizeof(Circle));
+    Circle* circle = (Circle*)pool_alloc(&circle_pool);
     
     strcpy(circle->base.type, "Circle");
     strcpy(circle->base.color, color);
     circle->base.x = x;
     circle->base.y = y;
+    circle->base.pool = &circle_pool;
     circle->base.clone = circle_clone;
     circle->base.draw = circle_draw;
     circle->base.move = shape_move;
@@ -86,15 +106,18 @@ typedef struct {
     int width, height;
 } Rectangle;
 
+static ShapePool rectangle_pool = {"Rectangle", sizeof(Rectangle), NULL, NULL, NULL, NULL, 0};
+
 Shape* rectangle_clone(Shape* self) {
     Rectangle* original = (Rectangle*)self;
-    Rectangle* clone = (Rectangle*)malloc(sizeof(Rectangle));
+    Rectangle* clone = (Rectangle*)pool_alloc(original->base.pool);
     
     *clone = *original;
+    COUNTER_ADD(prototype_clones, 1);
     
-    printf("Cloned Rectangle: color=%s, size=%dx%d, position=(%d,%d)\n", 
-           clone->base.color, clone->width, clone->height, 
-           clone->base.x, clone->base.y);
+    PATTERN_LOG("Cloned Rectangle: color=%s, size=%dx%d, position=(%d,%d)\n", 
+                clone->base.color, clone->width, clone->height, 
+                clone->base.x, clone->base.y);
     
     return (Shape*)clone;
 }
@@ -107,12 +130,13 @@ void rectangle_draw(Shape* self) {
 }
 
 Rectangle* create_rectangle(const char* color, int x, int y, int width, int height) {
-    Rectangle* rect = (Rectangle*)malloc(sizeof(Rectangle));
+    Rectangle* rect = (Rectangle*)pool_alloc(&rectangle_pool);
     
     strcpy(rect->base.type, "Rectangle");
     strcpy(rect->base.color, color);
     rect->base.x = x;
     rect->base.y = y;
+    rect->base.pool = &rectangle_pool;
     rect->base.clone = rectangle_clone;
     rect->base.draw = rectangle_draw;
     rect->base.move = shape_move;
@@ -123,42 +147,103 @@ Rectangle* create_rectangle(const char* color, int x, int y, int width, int heig
 }
 
 // Prototype Registry
-#define MAX_PROTOTYPES 10
-
 typedef struct {
-    Shape* prototypes[MAX_PROTOTYPES];
-    char names[MAX_PROTOTYPES][50];
+    Shape** prototypes;
+    char (*names)[50];
     int count;
+    int capacity;
+    int* name_index;     // Open addressing: prototype position, or -1 if empty
+    int index_capacity;  // Power of two, at least twice count
 } PrototypeRegistry;
 
-PrototypeRegistry* create_registry() {
-    PrototypeRegistry* registry = (PrototypeRegistry*)malloc(sizeof(PrototypeRegistry));
-    registry->count = 0;
-    return registry;
+static unsigned long hash_name(const char* name) {
+    unsigned long hash = 2166136261u;  // FNV-1a
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
 }
 
-void register_prototype(PrototypeRegistry* registry, const char* name, Shape* prototype) {
-    if (registry->count < MAX_PROTOTYPES) {
-        strcpy(registry->names[registry->count], name);
-        registry->prototypes[registry->count] = prototype;
-        registry->count++;
-        printf("Registered prototype: %s\n", name);
+// Slot holding 'name', or the empty slot where it would go
+static int index_probe(PrototypeRegistry* registry, const char* name) {
+    int mask = registry->index_capacity - 1;
+    int slot = (int)(hash_name(name) & mask);
+    while (registry->name_index[slot] >= 0 &&
+           strcmp(registry->names[registry->name_index[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
     }
+    return slot;
 }
 
-Shape* get_prototype(PrototypeRegistry* registry, const char* name) {
+static void index_rebuild(PrototypeRegistry* registry, int capacity) {
+    free(registry->name_index);
+    registry->name_index = (int*)malloc(capacity * sizeof(int));
+    registry->index_capacity = capacity;
+    for (int i = 0; i < capacity; i++) registry->name_index[i] = -1;
     for (int i = 0; i < registry->count; i++) {
-        if (strcmp(registry->names[i], name) == 0) {
-            return registry->prototypes[i]->clone(registry->prototypes[i]);
-        } //(*(*registry).prototypes[i]).clone((*registry).prototypes[i]);
+        registry->name_index[index_probe(registry, registry->names[i])] = i;
     }
-    return NULL;
+}
+
+PrototypeRegistry* create_registry() {
+    PrototypeRegistry* registry = (PrototypeRegistry*)calloc(1, sizeof(PrototypeRegistry));
+    index_rebuild(registry, 16);
+    return registry;
 }
 
 void destroy_shape(Shape* shape) {
     if (shape) {
-        free(shape);
+        pool_release(shape->pool, shape);
+    }
+}
+
+// Registering a name again replaces (and destroys) the old prototype
+void register_prototype(PrototypeRegistry* registry, const char* name, Shape* prototype) {
+    int slot = index_probe(registry, name);
+    if (registry->name_index[slot] >= 0) {
+        int position = registry->name_index[slot];
+        destroy_shape(registry->prototypes[position]);
+        registry->prototypes[position] = prototype;
+        PATTERN_LOG("Replaced prototype: %s\n", name);
+        return;
     }
+    
+    if (registry->count == registry->capacity) {
+        registry->capacity = registry->capacity ? registry->capacity * 2 : 8;
+        registry->prototypes = (Shape**)realloc(registry->prototypes, registry->capacity * sizeof(Shape*));
+        registry->names = realloc(registry->names, registry->capacity * sizeof(*registry->names));
+    }
+    snprintf(registry->names[registry->count], sizeof(registry->names[0]), "%s", name);
+    registry->prototypes[registry->count] = prototype;
+    registry->name_index[slot] = registry->count;
+    registry->count++;
+    if (registry->count * 2 > registry->index_capacity) {
+        index_rebuild(registry, registry->index_capacity * 2);
+    }
+    PATTERN_LOG("Registered prototype: %s\n", name);
+}
+
+// The registered prototype itself (not a clone), or NULL
+Shape* find_prototype(PrototypeRegistry* registry, const char* name) {
+    int position = registry->name_index[index_probe(registry, name)];
+    return position >= 0 ? registry->prototypes[position] : NULL;
+}
+
+Shape* get_prototype(PrototypeRegistry* registry, const char* name) {
+    Shape* prototype = find_prototype(registry, name);
+    return prototype ? prototype->clone(prototype) : NULL;
+}
+
+// Clone 'name' 'count' times and point out[0..count-1] at the clones.
+// Released objects in the pool are reused first; the rest come from one
+// contiguous run. Returns how many were made (0 if the name isn't
+// registered). Each clone is released with destroy_shape().
+int clone_n(PrototypeRegistry* registry, const char* name, int count, Shape** out) {
+    Shape* prototype = find_prototype(registry, name);
+    if (!prototype || count <= 0) return 0;
+    COUNTER_ADD(prototype_clones, count);
+    
+    return pool_clone_n(prototype->pool, prototype, count, (void**)out);
 }
 
 void destroy_registry(PrototypeRegistry* registry) {
@@ -166,10 +251,77 @@ void destroy_registry(PrototypeRegistry* registry) {
         for (int i = 0; i < registry->count; i++) {
             destroy_shape(registry->prototypes[i]);
         }
+        free(registry->prototypes);
+        free(registry->names);
+        free(registry->name_index);
         free(registry);
     }
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+#define BENCH_CLONES 4096
+
+typedef struct {
+    PrototypeRegistry* registry;
+    Shape* clones[BENCH_CLONES];
+} CloneBench;
+
+// A frame's spawn/destroy cycle; steady state runs off the free list
+static void bench_clone_n(void* arg) {
+    CloneBench* bench = (CloneBench*)arg;
+    int made = clone_n(bench->registry, "default_circle", BENCH_CLONES, bench->clones);
+    for (int i = 0; i < made; i++) {
+        destroy_shape(bench->clones[i]);
+    }
+    bench_consume(made);
+}
+
+static void bench_clone_one_by_one(void* arg) {
+    CloneBench* bench = (CloneBench*)arg;
+    for (int i = 0; i < BENCH_CLONES; i++) {
+        bench->clones[i] = get_prototype(bench->registry, "default_circle");
+    }
+    for (int i = 0; i < BENCH_CLONES; i++) {
+        destroy_shape(bench->clones[i]);
+    }
+}
+
+// What the pools replace: one malloc and free per clone
+static void bench_malloc_clone(void* arg) {
+    CloneBench* bench = (CloneBench*)arg;
+    Shape* prototype = find_prototype(bench->registry, "default_circle");
+    for (int i = 0; i < BENCH_CLONES; i++) {
+        bench->clones[i] = (Shape*)malloc(sizeof(Circle));
+        memcpy(bench->clones[i], prototype, sizeof(Circle));
+    }
+    for (int i = 0; i < BENCH_CLONES; i++) {
+        free(bench->clones[i]);
+    }
+}
+
+int main() {
+    bench_header("Prototype cloning");
+    
+    static CloneBench bench;
+    bench.registry = create_registry();
+    register_prototype(bench.registry, "default_circle", (Shape*)create_circle("Red", 0, 0, 10));
+    counters_reset();
+    
+    bench_run("clone_n 4096 circles + destroy (per clone)", bench_clone_n, &bench, BENCH_CLONES);
+    bench_run("get_prototype one by one + destroy (per clone)", bench_clone_one_by_one, &bench,
+              BENCH_CLONES);
+    bench_run("malloc + memcpy + free, no pool (per clone)", bench_malloc_clone, &bench, BENCH_CLONES);
+    
+    counters_report();
+    
+    destroy_registry(bench.registry);
+    destroy_pool(&circle_pool);
+    destroy_pool(&rectangle_pool);
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== PROTOTYPE PATTERN EXAMPLE ===\n\n");
@@ -208,11 +360,39 @@ int main() {
         printf("\nPrototype 'triangle' not found in registry\n");
     }
     
+    printf("\n--- Bulk cloning from pools ---\n");
+    
+    // A frame's worth of circles: spawned in one call, destroyed one by one.
+    // Hashed lookup finds the prototype without scanning the names.
+    int frame_size = 200000;
+    Shape** spawned = (Shape**)malloc(frame_size * sizeof(Shape*));
+    for (int frame = 1; frame <= 3; frame++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int made = clone_n(registry, "default_circle", frame_size, spawned);
+        for (int i = 0; i < made; i++) {
+            spawned[i]->x = i % 640;
+            spawned[i]->y = i / 640;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("Frame %d: %d circles cloned in %.2f ms (%zu live, %zu slabs)\n", frame, made,
+               (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6,
+               circle_pool.live, pool_slab_count(&circle_pool));
+        for (int i = 0; i < made; i++) {
+            destroy_shape(spawned[i]);
+        }
+    }
+    free(spawned);
+    printf("Later frames reuse the released circles, so the pool stops growing\n");
+    
     // Cleanup
     destroy_shape(circle1);
     destroy_shape(circle2);
     destroy_shape(rect1);
     destroy_registry(registry);
+    destroy_pool(&circle_pool);
+    destroy_pool(&rectangle_pool);
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+ * SHAPE POOLS
+ *
+ * Shared by prototype.c and memory_efficient_prototype.c. Every shape type
+ * has a ShapePool: shapes are carved out of large slabs instead of one
+ * malloc each, and released shapes go back on the pool's free list.
+ *
+ * pool_clone_n() is the bulk half of clone_n(): it reuses released objects
+ * first, then fills one contiguous run by copying the prototype once and
+ * doubling the copied prefix with memcpy.
+ *
+ * With -DPATTERN_COUNTERS the pool counts slabs, free-list reuses and
+ * rewinds (see ../bench.h).
+ */
+
+#ifndef SHAPE_POOL_H
+#define SHAPE_POOL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "../bench.h"
+
+HOT_COUNTER(prototype_reuses, "prototype", "free-list reuses");
+HOT_COUNTER(prototype_slabs, "prototype", "slabs allocated");
+HOT_COUNTER(prototype_rewinds, "prototype", "pool rewinds");
+
+#define POOL_SLAB_OBJECTS 4096  // Objects per slab unless a run needs more
+
+typedef struct PoolSlab PoolSlab;
+struct PoolSlab {
+    PoolSlab* next;
+    size_t capacity;         // Objects this slab holds
+    size_t used;             // Objects handed out from the front so far
+    char objects[];
+};
+
+// Fixed-size allocator for one shape type. Freed objects go on a free
+// list linked through their first bytes. When the last live object comes
+// back, the whole pool rewinds, so a per-frame spawn/destroy cycle reuses
+// the same slabs.
+typedef struct {
+    const char* type_name;
+    size_t object_size;
+    PoolSlab* slabs;         // In allocation order
+    PoolSlab* last_slab;
+    PoolSlab* current;       // Slab runs are carved from
+    void* free_list;
+    size_t live;             // Objects handed out and not yet released
+} ShapePool;
+
+// Move to a slab with room for 'count' objects in a row, adding one if
+// needed. Leftovers of slabs we skip go on the free list.
+static inline PoolSlab* pool_slab_for_run(ShapePool* pool, size_t count) {
+    PoolSlab* slab = pool->current;
+    while (slab && slab->capacity - slab->used < count) {
+        for (; slab->used < slab->capacity; slab->used++) {
+            void* object = slab->objects + slab->used * pool->object_size;
+            *(void**)object = pool->free_list;
+            pool->free_list = object;
+        }
+        slab = slab->next;
+    }
+    if (!slab) {
+        size_t capacity = count > POOL_SLAB_OBJECTS ? count : POOL_SLAB_OBJECTS;
+        slab = (PoolSlab*)malloc(sizeof(PoolSlab) + capacity * pool->object_size);
+        COUNTER_ADD(prototype_slabs, 1);
+        slab->next = NULL;
+        slab->capacity = capacity;
+        slab->used = 0;
+        if (pool->last_slab) {
+            pool->last_slab->next = slab;
+        } else {
+            pool->slabs = slab;
+        }
+        pool->last_slab = slab;
+    }
+    pool->current = slab;
+    return slab;
+}
+
+// 'count' objects next to each other
+static inline void* pool_alloc_run(ShapePool* pool, size_t count) {
+    PoolSlab* slab = pool_slab_for_run(pool, count);
+    void* run = slab->objects + slab->used * pool->object_size;
+    slab->used += count;
+    pool->live += count;
+    return run;
+}
+
+static inline void* pool_alloc(ShapePool* pool) {
+    if (pool->free_list) {
+        void* object = pool->free_list;
+        pool->free_list = *(void**)object;
+        pool->live++;
+        COUNTER_ADD(prototype_reuses, 1);
+        return object;
+    }
+    return pool_alloc_run(pool, 1);
+}
+
+static inline void pool_release(ShapePool* pool, void* object) {
+    *(void**)object = pool->free_list;
+    pool->free_list = object;
+    if (--pool->live == 0) {
+        // Nothing is live: every slab is empty again
+        COUNTER_ADD(prototype_rewinds, 1);
+        for (PoolSlab* slab = pool->slabs; slab; slab = slab->next) {
+            slab->used = 0;
+        }
+        pool->current = pool->slabs;
+        pool->free_list = NULL;
+    }
+}
+
+// 'count' copies of the object_size bytes at 'prototype', pointed to by
+// out[0..count-1]. Released objects are reused first; the rest come from
+// one contiguous run. Returns count.
+static inline int pool_clone_n(ShapePool* pool, const void* prototype, int count, void** out) {
+    size_t size = pool->object_size;
+    int made = 0;
+    for (; made < count && pool->free_list; made++) {
+        out[made] = pool_alloc(pool);
+        memcpy(out[made], prototype, size);
+    }
+    if (made >= count) return count;
+    
+    // One copy of the prototype, then keep doubling the copied prefix
+    size_t remaining = count - made;
+    char* run = (char*)pool_alloc_run(pool, remaining);
+    memcpy(run, prototype, size);
+    size_t copied = 1;
+    while (copied < remaining) {
+        size_t chunk = copied < remaining - copied ? copied : remaining - copied;
+        memcpy(run + copied * size, run, chunk * size);
+        copied += chunk;
+    }
+    
+    for (size_t i = 0; i < remaining; i++) {
+        out[made + i] = run + i * size;
+    }
+    return count;
+}
+
+static inline size_t pool_slab_count(ShapePool* pool) {
+    size_t count = 0;
+    for (PoolSlab* slab = pool->slabs; slab; slab = slab->next) count++;
+    return count;
+}
+
+static inline void destroy_pool(ShapePool* pool) {
+    PoolSlab* slab = pool->slabs;
+    while (slab) {
+        PoolSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = pool->last_slab = pool->current = NULL;
+    pool->free_list = NULL;
+    pool->live = 0;
+}
+
+#endif // SHAPE_POOL_H
@@ -18,76 +18,617 @@
  * - Difficult to test
  * - Can violate single responsibility principle
  * - Problems in multithreaded environments
+ *
+ * Async mode: logger_start_async() moves writes off the caller's thread.
+ * Producers push into a bounded lock-free ring; a flusher thread drains it
+ * and writes each batch to log_file with a single writev().
+ *
+ * Thread safety: the instance is created exactly once with pthread_once().
+ * Each thread gets a LoggerHandle (get_logger_handle()) that caches the
+ * instance in thread-local storage and carries a private "busy" flag, so
+ * destroy_logger() can wait for in-flight writers without every log call
+ * bumping a shared counter.
+ *
+ * Levels and shards: LOG_DEBUG/LOG_INFO/LOG_WARN/LOG_ERROR check the level
+ * before any formatting (compile-time via LOG_COMPILE_LEVEL, then one
+ * branch at runtime). Records that pass go into the calling thread's own
+ * shard; display/flush merges all shards in timestamp order.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <stdarg.h>
+#include <stdint.h>
 
-// Logger singleton structure
+#define LOG_RECORD_SIZE 512      // Bytes per queued record (including '\n')
+#define LOG_FLUSH_BATCH 64       // Records written per writev() call
+#define LOG_SHARD_CAPACITY 64    // Records kept per thread until flushed
+
+typedef enum {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO = 1,
+    LOG_LEVEL_WARN = 2,
+    LOG_LEVEL_ERROR = 3
+} LogLevel;
+
+// Levels below this are removed by the compiler entirely
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// What a producer does when the async ring is full
+typedef enum {
+    BACKPRESSURE_BLOCK,        // Spin/yield until the flusher frees a slot
+    BACKPRESSURE_DROP_OLDEST,  // Discard the oldest queued record to make room
+    BACKPRESSURE_DROP_NEWEST   // Discard the record being logged
+} BackpressurePolicy;
+
+// One slot of the ring. 'sequence' tells producers and the consumer
+// whose turn it is to use the slot (bounded MPMC queue, used as MPSC).
+typedef struct {
+    atomic_size_t sequence;
+    size_t length;
+    char text[LOG_RECORD_SIZE];
+} LogSlot;
+
+// Counters reported by logger_get_async_stats()
 typedef struct {
+    unsigned long enqueued;
+    unsigned long written;
+    unsigned long dropped_oldest;
+    unsigned long dropped_newest;
+    unsigned long batches;
+} AsyncLogStats;
+
+// Async backend: lock-free ring + background flusher thread
+typedef struct {
+    LogSlot* slots;
+    size_t mask;                    // capacity - 1 (capacity is a power of two)
+    atomic_size_t enqueue_pos;
+    atomic_size_t dequeue_pos;
+    BackpressurePolicy policy;
+    int fd;
+    pthread_t flusher;
+    atomic_int running;
+    atomic_ulong enqueued;
+    atomic_ulong written;
+    atomic_ulong dropped_oldest;
+    atomic_ulong dropped_newest;
+    atomic_ulong batches;
+} AsyncLogBackend;
+
+typedef struct Logger Logger;
+
+// One stored record in a thread's shard
+typedef struct {
+    uint64_t timestamp_ns;   // CLOCK_MONOTONIC, used to merge shards
+    int level;
+    char text[LOG_RECORD_SIZE];
+} ShardRecord;
+
+// Per-thread record buffer. The lock is only ever contended by a flush.
+typedef struct {
+    pthread_mutex_t lock;
+    ShardRecord records[LOG_SHARD_CAPACITY];
+    int count;
+    unsigned long dropped;   // Records lost because the shard was full
+} LogShard;
+
+// Per-thread view of the logger. Only the owning thread writes 'busy';
+// destroy_logger()/logger_stop_async() read it to know when writers are done.
+typedef struct LoggerHandle {
+    Logger* logger;
+    atomic_int busy;
+    int retired;             // Owning thread exited; freed at the next flush
+    LogShard shard;
+    struct LoggerHandle* next;
+} LoggerHandle;
+
+// Logger singleton structure
+struct Logger {
     char log_file[256];
-    int log_level;
-    char messages[10][512];  // Store up to 10 messages, 512 chars each
-    int message_count;       // Number of stored messages
-} Logger;
+    atomic_int log_level;    // Records below this level are skipped
+    _Atomic(AsyncLogBackend*) async;  // NULL while logging synchronously
+    atomic_int closed;                // Set by destroy_logger()
+    pthread_mutex_t handle_lock;      // Guards the 'handles' list
+    LoggerHandle* handles;            // Every thread that has logged
+};
 
-// Static instance
+// Static instance. The storage is never freed, so handles cached by other
+// threads stay valid even after destroy_logger() has closed the logger.
+static Logger logger_storage;
 static Logger* logger_instance = NULL;
+static pthread_once_t logger_once = PTHREAD_ONCE_INIT;
+static pthread_key_t handle_key;
+static _Thread_local LoggerHandle* thread_handle = NULL;
+
+static void release_handle(void* arg);
+
+static void init_logger_instance(void) {
+    strcpy(logger_storage.log_file, "application.log");
+    atomic_init(&logger_storage.log_level, LOG_LEVEL_INFO);
+    atomic_init(&logger_storage.async, NULL);
+    atomic_init(&logger_storage.closed, 0);
+    pthread_mutex_init(&logger_storage.handle_lock, NULL);
+    logger_storage.handles = NULL;
+    pthread_key_create(&handle_key, release_handle);
+    logger_instance = &logger_storage;
+    printf("Logger instance created!\n");
+}
 
-// Get singleton instance
+// Get singleton instance. After the first call pthread_once() is a single
+// acquire load, so concurrent callers never race to create a second logger.
 Logger* get_logger_instance() {
-    if (logger_instance == NULL) {
-        logger_instance = (Logger*)malloc(sizeof(Logger));
-        strcpy(logger_instance->log_file, "application.log");
-        logger_instance->log_level = 1; // INFO level
-        logger_instance->message_count = 0; // Initialize message count
-        printf("Logger instance created!\n");
-    }
+    pthread_once(&logger_once, init_logger_instance);
     return logger_instance;
 }
 
+// Get the calling thread's cached handle (registered on first use).
+// Hot loops can keep the returned pointer and use log_with_handle().
+LoggerHandle* get_logger_handle() {
+    LoggerHandle* handle = thread_handle;
+    if (handle != NULL) return handle;
+
+    Logger* logger = get_logger_instance();
+    handle = (LoggerHandle*)malloc(sizeof(LoggerHandle));
+    handle->logger = logger;
+    atomic_init(&handle->busy, 0);
+    handle->retired = 0;
+    pthread_mutex_init(&handle->shard.lock, NULL);
+    handle->shard.count = 0;
+    handle->shard.dropped = 0;
+    pthread_mutex_lock(&logger->handle_lock);
+    handle->next = logger->handles;
+    logger->handles = handle;
+    pthread_mutex_unlock(&logger->handle_lock);
+    pthread_setspecific(handle_key, handle);
+    thread_handle = handle;
+    return handle;
+}
+
+// Thread-exit destructor. The handle stays in the list so its shard can
+// still be merged; the next flush frees it.
+static void release_handle(void* arg) {
+    LoggerHandle* handle = (LoggerHandle*)arg;
+    pthread_mutex_lock(&handle->logger->handle_lock);
+    handle->retired = 1;
+    pthread_mutex_unlock(&handle->logger->handle_lock);
+}
+
+// Wait until no thread is inside log_with_handle()
+static void wait_for_writers(Logger* logger) {
+    pthread_mutex_lock(&logger->handle_lock);
+    for (LoggerHandle* h = logger->handles; h != NULL; h = h->next) {
+        while (atomic_load(&h->busy)) {
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&logger->handle_lock);
+}
+
+// ---- Async ring buffer ----
+
+// Try to claim the oldest queued slot. Used by the flusher, and by producers
+// running with BACKPRESSURE_DROP_OLDEST. Returns NULL when the ring is empty.
+static LogSlot* ring_claim_oldest(AsyncLogBackend* ring, size_t* out_pos) {
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    for (;;) {
+        LogSlot* slot = &ring->slots[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        long diff = (long)seq - (long)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *out_pos = pos;
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL;  // Nothing published at this position yet
+        } else {
+            pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// Hand a claimed slot back to producers
+static void ring_release(AsyncLogBackend* ring, LogSlot* slot, size_t pos) {
+    atomic_store_explicit(&slot->sequence, pos + ring->mask + 1, memory_order_release);
+}
+
+// Push one record. Returns 1 if queued, 0 if it was dropped.
+static int ring_push(AsyncLogBackend* ring, const char* message) {
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    for (;;) {
+        LogSlot* slot = &ring->slots[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        long diff = (long)seq - (long)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                size_t len = strlen(message);
+                if (len > LOG_RECORD_SIZE - 1) len = LOG_RECORD_SIZE - 1;
+                memcpy(slot->text, message, len);
+                slot->text[len] = '\n';
+                slot->length = len + 1;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                atomic_fetch_add_explicit(&ring->enqueued, 1, memory_order_relaxed);
+                return 1;
+            }
+        } else if (diff < 0) {
+            // Ring is full
+            if (ring->policy == BACKPRESSURE_DROP_NEWEST) {
+                atomic_fetch_add_explicit(&ring->dropped_newest, 1, memory_order_relaxed);
+                return 0;
+            }
+            if (ring->policy == BACKPRESSURE_DROP_OLDEST) {
+                size_t old_pos;
+                LogSlot* victim = ring_claim_oldest(ring, &old_pos);
+                if (victim != NULL) {
+                    ring_release(ring, victim, old_pos);
+                    atomic_fetch_add_explicit(&ring->dropped_oldest, 1, memory_order_relaxed);
+                }
+            } else {
+                sched_yield();  // BACKPRESSURE_BLOCK: wait for the flusher
+            }
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// Claim up to LOG_FLUSH_BATCH records and write them with a single writev().
+// Slots are only released after the write, so the iovecs point straight into
+// the ring and nothing is copied. Returns the number of records written.
+static size_t ring_flush_batch(AsyncLogBackend* ring) {
+    struct iovec iov[LOG_FLUSH_BATCH];
+    LogSlot* claimed[LOG_FLUSH_BATCH];
+    size_t positions[LOG_FLUSH_BATCH];
+    size_t count = 0;
+
+    while (count < LOG_FLUSH_BATCH) {
+        LogSlot* slot = ring_claim_oldest(ring, &positions[count]);
+        if (slot == NULL) break;
+        claimed[count] = slot;
+        iov[count].iov_base = slot->text;
+        iov[count].iov_len = slot->length;
+        count++;
+    }
+    if (count == 0) return 0;
+
+    if (writev(ring->fd, iov, (int)count) < 0) {
+        perror("writev");
+    }
+    for (size_t i = 0; i < count; i++) {
+        ring_release(ring, claimed[i], positions[i]);
+    }
+    atomic_fetch_add_explicit(&ring->written, count, memory_order_relaxed);
+    atomic_fetch_add_explicit(&ring->batches, 1, memory_order_relaxed);
+    return count;
+}
+
+// Background flusher: drain batches, nap briefly when the ring is empty
+static void* flusher_thread(void* arg) {
+    AsyncLogBackend* ring = (AsyncLogBackend*)arg;
+    struct timespec idle = {0, 1000000};  // 1 ms
+
+    while (atomic_load_explicit(&ring->running, memory_order_acquire)) {
+        if (ring_flush_batch(ring) == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    // Final drain after stop was requested
+    while (ring_flush_batch(ring) > 0) {
+    }
+    return NULL;
+}
+
+// Switch the logger to async mode. 'capacity' is rounded up to a power of two.
+int logger_start_async(Logger* logger, size_t capacity, BackpressurePolicy policy) {
+    if (atomic_load(&logger->async) != NULL) return 0;
+
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+
+    AsyncLogBackend* ring = (AsyncLogBackend*)calloc(1, sizeof(AsyncLogBackend));
+    ring->slots = (LogSlot*)malloc(size * sizeof(LogSlot));
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+    ring->mask = size - 1;
+    ring->policy = policy;
+    ring->fd = open(logger->log_file, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (ring->fd < 0) {
+        perror("open");
+        free(ring->slots);
+        free(ring);
+        return -1;
+    }
+    atomic_store(&ring->running, 1);
+    if (pthread_create(&ring->flusher, NULL, flusher_thread, ring) != 0) {
+        close(ring->fd);
+        free(ring->slots);
+        free(ring);
+        return -1;
+    }
+    atomic_store(&logger->async, ring);
+    printf("Async logging enabled (%zu slots) -> %s\n", size, logger->log_file);
+    return 0;
+}
+
+static AsyncLogStats read_async_stats(AsyncLogBackend* ring) {
+    AsyncLogStats stats = {0};
+    if (ring != NULL) {
+        stats.enqueued = atomic_load(&ring->enqueued);
+        stats.written = atomic_load(&ring->written);
+        stats.dropped_oldest = atomic_load(&ring->dropped_oldest);
+        stats.dropped_newest = atomic_load(&ring->dropped_newest);
+        stats.batches = atomic_load(&ring->batches);
+    }
+    return stats;
+}
+
+AsyncLogStats logger_get_async_stats(Logger* logger) {
+    return read_async_stats(atomic_load(&logger->async));
+}
+
+// Stop the flusher, write out everything still queued, go back to sync mode.
+// Returns the final counters of the backend that was stopped.
+AsyncLogStats logger_stop_async(Logger* logger) {
+    AsyncLogBackend* ring = atomic_exchange(&logger->async, NULL);
+    if (ring == NULL) return (AsyncLogStats){0};
+
+    // Writers that already loaded 'ring' finish their push before we drain
+    wait_for_writers(logger);
+    atomic_store_explicit(&ring->running, 0, memory_order_release);
+    pthread_join(ring->flusher, NULL);
+    AsyncLogStats stats = read_async_stats(ring);
+    close(ring->fd);
+    free(ring->slots);
+    free(ring);
+    printf("Async logging stopped\n");
+    return stats;
+}
+
 // Logger operations
-void log_message(Logger* logger, const char* message) {
-    printf("[LOG:%s] %s\n", logger->log_file, message);
-    
-    // Store the message in memory if there's space
-    if (logger->message_count < 10) {
-        strcpy(logger->messages[logger->message_count], message);
-        logger->message_count++;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Append to the calling thread's shard. Only the owner writes here, so the
+// lock is uncontended except while a flush is merging.
+static void shard_append(LogShard* shard, int level, const char* message) {
+    pthread_mutex_lock(&shard->lock);
+    if (shard->count < LOG_SHARD_CAPACITY) {
+        ShardRecord* record = &shard->records[shard->count++];
+        record->timestamp_ns = monotonic_ns();
+        record->level = level;
+        strncpy(record->text, message, LOG_RECORD_SIZE - 1);
+        record->text[LOG_RECORD_SIZE - 1] = '\0';
+    } else {
+        shard->dropped++;
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// Single-branch level check, done before any formatting or copying
+static inline int log_level_enabled(Logger* logger, int level) {
+    return level >= atomic_load_explicit(&logger->log_level, memory_order_relaxed);
+}
+
+// Emit an already formatted record that passed the level check
+static void log_record(LoggerHandle* handle, int level, const char* message) {
+    Logger* logger = handle->logger;
+
+    // Announce ourselves before checking 'closed' (both seq_cst): either
+    // destroy_logger() sees busy == 1 and waits, or we see closed == 1.
+    atomic_store(&handle->busy, 1);
+    if (atomic_load(&logger->closed)) {
+        atomic_store(&handle->busy, 0);
+        return;
+    }
+
+    AsyncLogBackend* ring = atomic_load(&logger->async);
+    if (ring != NULL) {
+        // Async mode: no printf, no shared array - just a slot in the ring
+        ring_push(ring, message);
     } else {
-        printf("Warning: Message storage full, message not stored\n");
+        printf("[LOG:%s] %s\n", logger->log_file, message);
+        shard_append(&handle->shard, level, message);
+    }
+    atomic_store(&handle->busy, 0);
+}
+
+void log_with_handle(LoggerHandle* handle, const char* message) {
+    if (log_level_enabled(handle->logger, LOG_LEVEL_INFO)) {
+        log_record(handle, LOG_LEVEL_INFO, message);
     }
 }
 
-// New function to display all stored messages
+void log_message(Logger* logger, const char* message) {
+    (void)logger;  // There is only one logger; the thread's handle points at it
+    log_with_handle(get_logger_handle(), message);
+}
+
+// printf-style entry point behind the LOG_* macros. The level has already
+// been checked by the macro, so formatting only happens for kept records.
+void log_formatted(LoggerHandle* handle, int level, const char* format, ...) {
+    char buffer[LOG_RECORD_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    log_record(handle, level, buffer);
+}
+
+#define LOG_AT(level, ...)                                               \
+    do {                                                                 \
+        if ((level) >= LOG_COMPILE_LEVEL) {                              \
+            LoggerHandle* log_handle_ = get_logger_handle();             \
+            if (log_level_enabled(log_handle_->logger, (level))) {       \
+                log_formatted(log_handle_, (level), __VA_ARGS__);        \
+            }                                                            \
+        }                                                                \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+static const char* level_name(int level) {
+    switch (level) {
+        case LOG_LEVEL_DEBUG: return "DEBUG";
+        case LOG_LEVEL_INFO:  return "INFO";
+        case LOG_LEVEL_WARN:  return "WARN";
+        default:              return "ERROR";
+    }
+}
+
+// Print every shard's records merged in timestamp order. With 'clear' set
+// the shards are emptied and handles of exited threads are freed.
+static void merge_shards(Logger* logger, int clear) {
+    pthread_mutex_lock(&logger->handle_lock);
+
+    int shard_count = 0;
+    for (LoggerHandle* h = logger->handles; h != NULL; h = h->next) shard_count++;
+    LogShard** shards = (LogShard**)malloc((shard_count + 1) * sizeof(LogShard*));
+    int* cursor = (int*)calloc(shard_count + 1, sizeof(int));
+    int total = 0;
+    unsigned long dropped = 0;
+    int n = 0;
+    for (LoggerHandle* h = logger->handles; h != NULL; h = h->next) {
+        pthread_mutex_lock(&h->shard.lock);
+        shards[n++] = &h->shard;
+        total += h->shard.count;
+        dropped += h->shard.dropped;
+    }
+
+    printf("Total messages stored: %d (dropped: %lu, threads: %d)\n", total, dropped, shard_count);
+    // K-way merge: each shard is already in timestamp order
+    for (int out = 1; out <= total; out++) {
+        int best = -1;
+        for (int i = 0; i < n; i++) {
+            if (cursor[i] >= shards[i]->count) continue;
+            if (best < 0 || shards[i]->records[cursor[i]].timestamp_ns <
+                            shards[best]->records[cursor[best]].timestamp_ns) {
+                best = i;
+            }
+        }
+        ShardRecord* record = &shards[best]->records[cursor[best]++];
+        printf("Message %d [%s]: %s\n", out, level_name(record->level), record->text);
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (clear) {
+            shards[i]->count = 0;
+            shards[i]->dropped = 0;
+        }
+        pthread_mutex_unlock(&shards[i]->lock);
+    }
+    if (clear) {
+        LoggerHandle** link = &logger->handles;
+        while (*link != NULL) {
+            LoggerHandle* h = *link;
+            if (h->retired) {
+                *link = h->next;
+                pthread_mutex_destroy(&h->shard.lock);
+                free(h);
+            } else {
+                link = &h->next;
+            }
+        }
+    }
+    pthread_mutex_unlock(&logger->handle_lock);
+    free(shards);
+    free(cursor);
+}
+
+// Display all stored messages without removing them
 void display_stored_messages(Logger* logger) {
     printf("\n=== STORED MESSAGES ===\n");
-    printf("Total messages stored: %d\n", logger->message_count);
-    for (int i = 0; i < logger->message_count; i++) {
-        printf("Message %d: %s\n", i + 1, logger->messages[i]);
-    }
+    merge_shards(logger, 0);
     printf("=======================\n");
 }
 
+// Display all stored messages and empty the shards
+void flush_stored_messages(Logger* logger) {
+    printf("\n=== FLUSHED MESSAGES ===\n");
+    merge_shards(logger, 1);
+    printf("========================\n");
+}
+
 void set_log_level(Logger* logger, int level) {
-    logger->log_level = level;
+    atomic_store(&logger->log_level, level);
     printf("Log level set to: %d\n", level);
 }
 
-// Cleanup
+// Cleanup. Safe to call at process exit while other threads still log:
+// later calls are ignored and in-flight ones are allowed to finish.
 void destroy_logger() {
-    if (logger_instance != NULL) {
-        free(logger_instance);
-        logger_instance = NULL;
-        printf("Logger instance destroyed!\n");
+    Logger* logger = logger_instance;
+    if (logger == NULL || atomic_exchange(&logger->closed, 1)) return;
+
+    wait_for_writers(logger);
+    logger_stop_async(logger);
+    printf("Logger instance destroyed!\n");
+}
+
+// Worker used by the async demo: hammers the logger from its own thread
+#define ASYNC_DEMO_THREADS 4
+#define ASYNC_DEMO_MESSAGES 1000
+
+static void* async_demo_worker(void* arg) {
+    (void)arg;
+    LoggerHandle* handle = get_logger_handle();  // Cached once per thread
+    char buffer[64];
+    for (int i = 0; i < ASYNC_DEMO_MESSAGES; i++) {
+        snprintf(buffer, sizeof(buffer), "worker %lu message %d",
+                 (unsigned long)pthread_self() % 1000, i);
+        log_with_handle(handle, buffer);
     }
+    return NULL;
+}
+
+// Worker used by the startup race demo: every thread asks for the instance
+static void* startup_race_worker(void* arg) {
+    *(Logger**)arg = get_logger_instance();
+    LOG_INFO("Worker thread %lu started", (unsigned long)pthread_self() % 1000);
+    return NULL;
 }
 
 // Example usage
 int main() {
     printf("=== SINGLETON PATTERN EXAMPLE ===\n\n");
     
+    // Many threads racing for the instance still create exactly one
+    pthread_t racers[ASYNC_DEMO_THREADS];
+    Logger* seen[ASYNC_DEMO_THREADS];
+    for (int i = 0; i < ASYNC_DEMO_THREADS; i++) {
+        pthread_create(&racers[i], NULL, startup_race_worker, &seen[i]);
+    }
+    for (int i = 0; i < ASYNC_DEMO_THREADS; i++) {
+        pthread_join(racers[i], NULL);
+    }
+    int all_same = 1;
+    for (int i = 1; i < ASYNC_DEMO_THREADS; i++) {
+        if (seen[i] != seen[0]) all_same = 0;
+    }
+    printf("%d threads got the same instance? %s\n", ASYNC_DEMO_THREADS, all_same ? "Yes" : "No");
+    flush_stored_messages(get_logger_instance());  // Merge the workers' shards
+    printf("\n");
+    
     // Get first reference
     Logger* logger1 = get_logger_instance();
     log_message(logger1, "First log message");
@@ -102,17 +643,38 @@ int main() {
     printf("Same instance? %s\n", (logger1 == logger2) ? "Yes" : "No");
     
     // Modify through one reference, visible through other
-    set_log_level(logger1, 3);
-    printf("Logger2 level: %d\n", logger2->log_level);
+    set_log_level(logger1, LOG_LEVEL_ERROR);
+    printf("Logger2 level: %d\n", atomic_load(&logger2->log_level));
+    
+    // Below the level: skipped before any formatting happens
+    log_message(logger1, "Third log message (INFO, filtered)");
+    LOG_DEBUG("Debug value %d (filtered)", 42);
+    LOG_ERROR("Fourth log message (ERROR)");
     
-    // Add more messages to demonstrate storage
-    log_message(logger1, "Third log message");
-    log_message(logger2, "Fourth log message");
-    log_message(logger1, "Final log message");
+    // Lower the level again and log from both references
+    set_log_level(logger2, LOG_LEVEL_DEBUG);
+    LOG_DEBUG("Fifth log message, x = %d", 7);
+    LOG_WARN("Final log message from %s", "logger2");
     
     // Show all stored messages
     display_stored_messages(logger2);
     
+    // Async mode: several producer threads share one flusher
+    printf("\n=== ASYNC MODE ===\n");
+    logger_start_async(logger1, 256, BACKPRESSURE_DROP_OLDEST);
+    pthread_t workers[ASYNC_DEMO_THREADS];
+    for (int i = 0; i < ASYNC_DEMO_THREADS; i++) {
+        pthread_create(&workers[i], NULL, async_demo_worker, logger1);
+    }
+    for (int i = 0; i < ASYNC_DEMO_THREADS; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    AsyncLogStats stats = logger_stop_async(logger1);
+    printf("Enqueued: %lu, dropped (oldest): %lu, dropped (newest): %lu\n",
+           stats.enqueued, stats.dropped_oldest, stats.dropped_newest);
+    printf("Written: %lu records in %lu writev() batches\n",
+           stats.written, stats.batches);
+    
     destroy_logger();
     return 0;
 }
\ No newline at end of file
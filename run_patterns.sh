@@ -18,7 +18,7 @@ compile_and_run() {
     echo "🔧 Compiling $pattern..."
     
     # Compile with math library for patterns that need it
-    if gcc -o "$executable" "$file_path" -lm 2>/dev/null; then
+    if gcc -o "$executable" "$file_path" -pthread -lm 2>/dev/null; then
         echo "✅ Compilation successful"
         echo "🚀 Running $pattern example:"
         echo "----------------------------------------"
@@ -30,7 +30,32 @@ compile_and_run() {
         rm -f "$executable"
     else
         echo "❌ Compilation failed for $pattern"
-        gcc "$file_path" -lm  # Show error details
+        gcc "$file_path" -pthread -lm  # Show error details
+    fi
+}
+
+# Patterns with a benchmark main (built with -DPATTERN_BENCH)
+BENCHMARKS="creational/prototype structural/composite behavioral/observer behavioral/command behavioral/visitor behavioral/chain_of_responsibility behavioral/strategy behavioral/template_method"
+
+# Function to compile and run a pattern's benchmarks
+# Set PATTERN_COUNTERS=1 to add the hot-path counters, BENCH_CFLAGS for extra flags
+compile_and_benchmark() {
+    local file_path="$1.c"
+    local executable="$1_bench"
+    local flags="-O2 -DPATTERN_BENCH $BENCH_CFLAGS"
+    if [ -n "$PATTERN_COUNTERS" ]; then
+        flags="$flags -DPATTERN_COUNTERS"
+    fi
+    
+    echo ""
+    echo "🔧 Compiling $1 benchmarks..."
+    
+    if gcc $flags -o "$executable" "$file_path" -pthread -lm 2>/dev/null; then
+        ./"$executable"
+        rm -f "$executable"
+    else
+        echo "❌ Compilation failed for $1"
+        gcc $flags "$file_path" -pthread -lm -o /dev/null  # Show error details
     fi
 }
 
@@ -64,7 +89,7 @@ show_patterns() {
 
 # Main execution
 if [ $# -eq 0 ]; then
-    echo "Usage: $0 [pattern_name|all|list|category]"
+    echo "Usage: $0 [pattern_name|all|list|category|bench [pattern_name...]]"
     echo ""
     echo "Examples:"
     echo "  $0 singleton          # Run singleton pattern"
@@ -73,6 +98,8 @@ if [ $# -eq 0 ]; then
     echo "  $0 creational        # Run all creational patterns"
     echo "  $0 structural        # Run all structural patterns"
     echo "  $0 behavioral        # Run all behavioral patterns"
+    echo "  $0 bench             # Run every pattern benchmark"
+    echo "  $0 bench observer    # Run the observer benchmarks"
     show_patterns
     exit 1
 fi
@@ -81,6 +108,15 @@ case $1 in
     "list")
         show_patterns
         ;;
+    "bench")
+        echo "⏱️ Running pattern BENCHMARKS..."
+        shift
+        for benchmark in $BENCHMARKS; do
+            if [ $# -eq 0 ] || [[ " $* " == *" $(basename "$benchmark") "* ]]; then
+                compile_and_benchmark "$benchmark"
+            fi
+        done
+        ;;
     "all")
         echo "🎯 Running ALL design patterns..."
         
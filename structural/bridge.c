@@ -17,11 +17,124 @@
  * Cons:
  * - Increased complexity
  * - Additional indirection
+ *
+ * Command buffers: between drawing_api_begin_frame() and
+ * drawing_api_end_frame(), shapes record compact DrawOps into a per-frame
+ * buffer instead of calling the backend. At the end of the frame the ops
+ * are grouped by colour (optionally), repeated colour changes are
+ * dropped, and the backend gets the whole frame in one submit() call.
+ * Colours are interned to small integer IDs, so no strings are copied
+ * while drawing.
+ *
+ * SoftwareAPI rasterizes into an in-memory 0xAARRGGBB framebuffer. A
+ * submitted frame is binned into 64x64 tiles, and worker threads claim
+ * tiles and fill their spans with SIMD stores. Each tile draws its ops in
+ * order, so the result matches drawing them one by one. The workers and
+ * the bin arrays belong to the SoftwareAPI and are reused every frame, so
+ * a steady stream of frames creates no threads and does no allocation.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SIMD 1
+#endif
+
+// ---- Interned colours ----
+
+#define MAX_COLORS 256
+#define COLOR_NAME_SIZE 50   // Longer names are cut to fit; Shape.color matches
+
+static char color_names[MAX_COLORS][COLOR_NAME_SIZE];
+static uint32_t color_values[MAX_COLORS];  // 0xAARRGGBB for rasterizing
+static int color_count = 0;
+
+static const struct {
+    const char* name;
+    uint32_t value;
+} known_colors[] = {
+    {"white", 0xFFFFFFFF}, {"black", 0xFF000000}, {"red", 0xFFFF0000},
+    {"green", 0xFF00FF00}, {"blue", 0xFF0000FF}, {"yellow", 0xFFFFFF00},
+    {"purple", 0xFF800080}, {"orange", 0xFFFFA500},
+};
+
+static uint32_t color_value_for(const char* name) {
+    for (size_t i = 0; i < sizeof(known_colors) / sizeof(known_colors[0]); i++) {
+        if (strcmp(known_colors[i].name, name) == 0) return known_colors[i].value;
+    }
+    uint32_t hash = 2166136261u;  // Unknown names still get a stable colour
+    while (*name) hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    return 0xFF000000u | (hash & 0xFFFFFF);
+}
+
+// ID for a colour name, adding it on first use, or -1 if the table is
+// full (DrawOp.color is a uint8_t, so it can't grow past MAX_COLORS).
+// Called when a shape is created or recoloured, never while drawing.
+// Names are compared only as far as they are stored.
+int intern_color(const char* name) {
+    for (int i = 0; i < color_count; i++) {
+        if (strncmp(color_names[i], name, COLOR_NAME_SIZE - 1) == 0) return i;
+    }
+    if (color_count == MAX_COLORS) return -1;
+    snprintf(color_names[color_count], sizeof(color_names[0]), "%s", name);
+    color_values[color_count] = color_value_for(name);
+    return color_count++;
+}
+
+const char* color_name(int color_id) {
+    return color_names[color_id];
+}
+
+static void report_color_table_full(const char* name) {
+    printf("Warning: color table is full (%d colors), can't add '%s'\n", MAX_COLORS, name);
+}
+
+// intern_color() for things that need some colour: the first one if full
+static int intern_color_or_first(const char* name) {
+    int color_id = intern_color(name);
+    if (color_id >= 0) return color_id;
+    report_color_table_full(name);
+    printf("  using %s instead\n", color_name(0));
+    return 0;
+}
+
+// ---- Draw commands ----
+
+typedef enum {
+    OP_SET_COLOR,              // Only appears in a submitted frame
+    OP_CIRCLE,
+    OP_RECTANGLE
+} DrawOpKind;
+
+// One recorded operation. Circles use (x, y, a = radius); rectangles use
+// (x, y, a = width, b = height).
+typedef struct {
+    uint8_t kind;
+    uint8_t color;
+    int32_t x, y, a, b;
+} DrawOp;
+
+// Per-frame op storage. Reset (not freed) at each frame, so after the
+// first frames recording does no allocation.
+typedef struct {
+    DrawOp* ops;
+    int count;
+    int capacity;
+    DrawOp* submitted;         // Frame as sent to the backend
+    int submitted_capacity;
+    int current_color;         // Colour state while recording
+    int sort_by_state;
+} DrawCommandBuffer;
 
 // Implementation interface (Bridge)
 typedef struct DrawingAPI DrawingAPI;
@@ -29,33 +142,64 @@ struct DrawingAPI {
     void (*draw_circle)(DrawingAPI* self, int x, int y, int radius);
     void (*draw_rectangle)(DrawingAPI* self, int x, int y, int width, int height);
     void (*set_color)(DrawingAPI* self, const char* color);
+    void (*set_color_id)(DrawingAPI* self, int color_id);
+    void (*submit)(DrawingAPI* self, const DrawOp* ops, int count);  // One whole frame
     const char* (*get_name)(DrawingAPI* self);
+    void (*release)(DrawingAPI* self);  // Backend-specific cleanup, may be NULL
+    DrawCommandBuffer* commands;   // Kept between frames, NULL until the first
+    int recording;                 // Inside begin_frame/end_frame
 };
 
+// Name-based set_color for every backend: intern, then set by ID
+void api_set_color_by_name(DrawingAPI* self, const char* color) {
+    int color_id = intern_color(color);
+    if (color_id < 0) {
+        report_color_table_full(color);  // Keep drawing in the current colour
+        return;
+    }
+    self->set_color_id(self, color_id);
+}
+
 // Concrete Implementation 1: OpenGL
 typedef struct {
     DrawingAPI base;
-    char current_color[50];
+    int current_color;
 } OpenGLAPI;
 
 void opengl_draw_circle(DrawingAPI* self, int x, int y, int radius) {
     OpenGLAPI* gl = (OpenGLAPI*)self;
     printf("OpenGL: Drawing %s circle at (%d,%d) with radius %d\n", 
-           gl->current_color, x, y, radius);
-    printf("  glColor(%s); glCircle(%d, %d, %d);\n", gl->current_color, x, y, radius);
+           color_name(gl->current_color), x, y, radius);
+    printf("  glColor(%s); glCircle(%d, %d, %d);\n", color_name(gl->current_color), x, y, radius);
 }
 
 void opengl_draw_rectangle(DrawingAPI* self, int x, int y, int width, int height) {
     OpenGLAPI* gl = (OpenGLAPI*)self;
     printf("OpenGL: Drawing %s rectangle at (%d,%d) size %dx%d\n", 
-           gl->current_color, x, y, width, height);
-    printf("  glColor(%s); glRect(%d, %d, %d, %d);\n", gl->current_color, x, y, width, height);
+           color_name(gl->current_color), x, y, width, height);
+    printf("  glColor(%s); glRect(%d, %d, %d, %d);\n", color_name(gl->current_color), x, y, width, height);
 }
 
-void opengl_set_color(DrawingAPI* self, const char* color) {
+void opengl_set_color_id(DrawingAPI* self, int color_id) {
     OpenGLAPI* gl = (OpenGLAPI*)self;
-    strcpy(gl->current_color, color);
-    printf("OpenGL: Color set to %s\n", color);
+    gl->current_color = color_id;
+    printf("OpenGL: Color set to %s\n", color_name(color_id));
+}
+
+void opengl_submit(DrawingAPI* self, const DrawOp* ops, int count) {
+    OpenGLAPI* gl = (OpenGLAPI*)self;
+    printf("OpenGL: Submitting frame (%d ops in one draw list)\n", count);
+    for (int i = 0; i < count; i++) {
+        const DrawOp* op = &ops[i];
+        if (op->kind == OP_SET_COLOR) {
+            gl->current_color = op->color;
+            printf("  glColor(%s);\n", color_name(op->color));
+        } else if (op->kind == OP_CIRCLE) {
+            printf("  glCircle(%d, %d, %d);\n", op->x, op->y, op->a);
+        } else {
+            printf("  glRect(%d, %d, %d, %d);\n", op->x, op->y, op->a, op->b);
+        }
+    }
 }
 
 const char* opengl_get_name(DrawingAPI* self) {
@@ -64,11 +208,16 @@ const char* opengl_get_name(DrawingAPI* self) {
 
 DrawingAPI* create_opengl_api() {
     OpenGLAPI* gl = (OpenGLAPI*)malloc(sizeof(OpenGLAPI));
-    strcpy(gl->current_color, "white");
+    gl->current_color = intern_color_or_first("white");
+    gl->base.commands = NULL;
+    gl->base.recording = 0;
+    gl->base.release = NULL;
     
     gl->base.draw_circle = opengl_draw_circle;
     gl->base.draw_rectangle = opengl_draw_rectangle;
-    gl->base.set_color = opengl_set_color;
+    gl->base.set_color = api_set_color_by_name;
+    gl->base.set_color_id = opengl_set_color_id;
+    gl->base.submit = opengl_submit;
     gl->base.get_name = opengl_get_name;
     
     return (DrawingAPI*)gl;
@@ -77,27 +226,43 @@ DrawingAPI* create_opengl_api() {
 // Concrete Implementation 2: DirectX
 typedef struct {
     DrawingAPI base;
-    char current_color[50];
+    int current_color;
 } DirectXAPI;
 
 void directx_draw_circle(DrawingAPI* self, int x, int y, int radius) {
     DirectXAPI* dx = (DirectXAPI*)self;
     printf("DirectX: Rendering %s circle at (%d,%d) with radius %d\n", 
-           dx->current_color, x, y, radius);
-    printf("  D3DSetColor(%s); D3DDrawCircle(%d, %d, %d);\n", dx->current_color, x, y, radius);
+           color_name(dx->current_color), x, y, radius);
+    printf("  D3DSetColor(%s); D3DDrawCircle(%d, %d, %d);\n", color_name(dx->current_color), x, y, radius);
 }
 
 void directx_draw_rectangle(DrawingAPI* self, int x, int y, int width, int height) {
     DirectXAPI* dx = (DirectXAPI*)self;
     printf("DirectX: Rendering %s rectangle at (%d,%d) size %dx%d\n", 
-           dx->current_color, x, y, width, height);
-    printf("  D3DSetColor(%s); D3DDrawRect(%d, %d, %d, %d);\n", dx->current_color, x, y, width, height);
+           color_name(dx->current_color), x, y, width, height);
+    printf("  D3DSetColor(%s); D3DDrawRect(%d, %d, %d, %d);\n", color_name(dx->current_color), x, y, width, height);
 }
 
-void directx_set_color(DrawingAPI* self, const char* color) {
+void directx_set_color_id(DrawingAPI* self, int color_id) {
     DirectXAPI* dx = (DirectXAPI*)self;
-    strcpy(dx->current_color, color);
-    printf("DirectX: Color set to %s\n", color);
+    dx->current_color = color_id;
+    printf("DirectX: Color set to %s\n", color_name(color_id));
+}
+
+void directx_submit(DrawingAPI* self, const DrawOp* ops, int count) {
+    DirectXAPI* dx = (DirectXAPI*)self;
+    printf("DirectX: Executing command list (%d ops)\n", count);
+    for (int i = 0; i < count; i++) {
+        const DrawOp* op = &ops[i];
+        if (op->kind == OP_SET_COLOR) {
+            dx->current_color = op->color;
+            printf("  D3DSetColor(%s);\n", color_name(op->color));
+        } else if (op->kind == OP_CIRCLE) {
+            printf("  D3DDrawCircle(%d, %d, %d);\n", op->x, op->y, op->a);
+        } else {
+            printf("  D3DDrawRect(%d, %d, %d, %d);\n", op->x, op->y, op->a, op->b);
+        }
+    }
 }
 
 const char* directx_get_name(DrawingAPI* self) {
@@ -106,64 +271,543 @@ const char* directx_get_name(DrawingAPI* self) {
 
 DrawingAPI* create_directx_api() {
     DirectXAPI* dx = (DirectXAPI*)malloc(sizeof(DirectXAPI));
-    strcpy(dx->current_color, "white");
+    dx->current_color = intern_color_or_first("white");
+    dx->base.commands = NULL;
+    dx->base.recording = 0;
+    dx->base.release = NULL;
     
     dx->base.draw_circle = directx_draw_circle;
     dx->base.draw_rectangle = directx_draw_rectangle;
-    dx->base.set_color = directx_set_color;
+    dx->base.set_color = api_set_color_by_name;
+    dx->base.set_color_id = directx_set_color_id;
+    dx->base.submit = directx_submit;
     dx->base.get_name = directx_get_name;
     
     return (DrawingAPI*)dx;
 }
 
 // Concrete Implementation 3: Software Renderer
+#define TILE_SIZE 64
+#define MAX_RASTER_THREADS 64
+
+// Bins: for each tile, the indices of the draw ops touching it, in frame
+// order (counting sort, two passes). Arrays only grow, and are reused for
+// every frame.
+typedef struct {
+    const DrawOp* ops;
+    uint32_t* op_colors;       // Colour in effect for each op
+    int op_capacity;
+    int* bin_start;            // tile_count + 1 offsets into bin_ops
+    int* bin_fill;             // Scratch while filling bin_ops
+    int* bin_ops;
+    int bin_capacity;
+    int tiles_x;
+    int tile_count;
+    atomic_int next_tile;      // Work distribution: threads claim tiles in turn
+} RasterFrame;
+
 typedef struct {
     DrawingAPI base;
-    char current_color[50];
+    int current_color;
+    uint32_t* pixels;          // width * height, row-major, 0xAARRGGBB
+    int width;
+    int height;
+    int thread_count;
+    void (*fill_span)(uint32_t* row, int count, uint32_t color);
+    
+    // Worker pool: thread_count - 1 helpers wait for the next frame
+    RasterFrame frame;
+    pthread_t helpers[MAX_RASTER_THREADS];
+    pthread_mutex_t pool_lock;
+    pthread_cond_t frame_ready;    // A new frame_number, or shutdown
+    pthread_cond_t frame_done;     // busy_helpers reached 0
+    unsigned frame_number;
+    int busy_helpers;              // Helpers still working on this frame
+    int shutting_down;
 } SoftwareAPI;
 
+// Pixel rectangle [x0, x1) x [y0, y1) that drawing is clipped to
+typedef struct {
+    int x0, y0, x1, y1;
+} ClipRect;
+
+// ---- Span fill kernels ----
+
+static void fill_span_scalar(uint32_t* row, int count, uint32_t color) {
+    for (int i = 0; i < count; i++) row[i] = color;
+}
+
+#if HAVE_X86_SIMD
+static void fill_span_sse2(uint32_t* row, int count, uint32_t color) {
+    __m128i value = _mm_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128((__m128i*)(row + i), value);
+    }
+    fill_span_scalar(row + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+static void fill_span_avx2(uint32_t* row, int count, uint32_t color) {
+    __m256i value = _mm256_set1_epi32((int)color);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_si256((__m256i*)(row + i), value);
+    }
+    fill_span_scalar(row + i, count - i, color);
+}
+#endif
+
+#if HAVE_NEON_SIMD
+static void fill_span_neon(uint32_t* row, int count, uint32_t color) {
+    uint32x4_t value = vdupq_n_u32(color);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u32(row + i, value);
+    }
+    fill_span_scalar(row + i, count - i, color);
+}
+#endif
+
+static void (*detect_fill_span(void))(uint32_t*, int, uint32_t) {
+#if HAVE_X86_SIMD
+    if (__builtin_cpu_supports("avx2")) return fill_span_avx2;
+    return fill_span_sse2;
+#elif HAVE_NEON_SIMD
+    return fill_span_neon;
+#else
+    return fill_span_scalar;
+#endif
+}
+
+// ---- Rasterizing ----
+
+// Largest d with d*d <= value
+static int isqrt(long value) {
+    long d = 0;
+    long bit = 1L << 30;
+    while (bit > value) bit >>= 2;
+    while (bit != 0) {
+        if (value >= d + bit) {
+            value -= d + bit;
+            d = (d >> 1) + bit;
+        } else {
+            d >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (int)d;
+}
+
+static void fill_clipped_span(SoftwareAPI* sw, int y, int x0, int x1, uint32_t color, ClipRect clip) {
+    if (x0 < clip.x0) x0 = clip.x0;
+    if (x1 > clip.x1) x1 = clip.x1;
+    if (x1 > x0) {
+        sw->fill_span(sw->pixels + (size_t)y * sw->width + x0, x1 - x0, color);
+    }
+}
+
+// Pixels covered by an op, as [x0, x1) x [y0, y1)
+static ClipRect op_bounds(const DrawOp* op) {
+    ClipRect bounds;
+    if (op->kind == OP_CIRCLE) {
+        bounds.x0 = op->x - op->a;
+        bounds.y0 = op->y - op->a;
+        bounds.x1 = op->x + op->a + 1;
+        bounds.y1 = op->y + op->a + 1;
+    } else {
+        bounds.x0 = op->x;
+        bounds.y0 = op->y;
+        bounds.x1 = op->x + op->a;
+        bounds.y1 = op->y + op->b;
+    }
+    return bounds;
+}
+
+// Draw one op inside 'clip'. Circles cover the pixels with dx^2 + dy^2 <= r^2.
+static void rasterize_op(SoftwareAPI* sw, const DrawOp* op, uint32_t color, ClipRect clip) {
+    ClipRect bounds = op_bounds(op);
+    int y0 = bounds.y0 > clip.y0 ? bounds.y0 : clip.y0;
+    int y1 = bounds.y1 < clip.y1 ? bounds.y1 : clip.y1;
+    if (y0 >= y1) return;
+    if (op->kind != OP_CIRCLE) {
+        for (int y = y0; y < y1; y++) {
+            fill_clipped_span(sw, y, bounds.x0, bounds.x1, color, clip);
+        }
+        return;
+    }
+    
+    // Half-width of each row: one square root, then small steps per row
+    long radius_squared = (long)op->a * op->a;
+    long dy = y0 - op->y;
+    long half = isqrt(radius_squared - dy * dy);
+    for (int y = y0; y < y1; y++, dy++) {
+        long limit = radius_squared - dy * dy;
+        while ((half + 1) * (half + 1) <= limit) half++;
+        while (half * half > limit) half--;
+        fill_clipped_span(sw, y, op->x - (int)half, op->x + (int)half + 1, color, clip);
+    }
+}
+
+static ClipRect whole_framebuffer(SoftwareAPI* sw) {
+    ClipRect clip = {0, 0, sw->width, sw->height};
+    return clip;
+}
+
+// Claim and draw tiles of the current frame until none are left
+static void raster_tiles(SoftwareAPI* sw) {
+    RasterFrame* frame = &sw->frame;
+    for (;;) {
+        int tile = atomic_fetch_add(&frame->next_tile, 1);
+        if (tile >= frame->tile_count) break;
+        ClipRect clip;
+        clip.x0 = (tile % frame->tiles_x) * TILE_SIZE;
+        clip.y0 = (tile / frame->tiles_x) * TILE_SIZE;
+        clip.x1 = clip.x0 + TILE_SIZE < sw->width ? clip.x0 + TILE_SIZE : sw->width;
+        clip.y1 = clip.y0 + TILE_SIZE < sw->height ? clip.y0 + TILE_SIZE : sw->height;
+        for (int i = frame->bin_start[tile]; i < frame->bin_start[tile + 1]; i++) {
+            int op = frame->bin_ops[i];
+            rasterize_op(sw, &frame->ops[op], frame->op_colors[op], clip);
+        }
+    }
+}
+
+// Helper thread: sleep until the next frame, help draw it, report back
+static void* raster_helper(void* arg) {
+    SoftwareAPI* sw = (SoftwareAPI*)arg;
+    unsigned seen = 0;  // Not frame_number: a frame may already be waiting
+    pthread_mutex_lock(&sw->pool_lock);
+    for (;;) {
+        while (sw->frame_number == seen && !sw->shutting_down) {
+            pthread_cond_wait(&sw->frame_ready, &sw->pool_lock);
+        }
+        if (sw->shutting_down) break;
+        seen = sw->frame_number;
+        pthread_mutex_unlock(&sw->pool_lock);
+        
+        raster_tiles(sw);
+        
+        pthread_mutex_lock(&sw->pool_lock);
+        if (--sw->busy_helpers == 0) pthread_cond_signal(&sw->frame_done);
+    }
+    pthread_mutex_unlock(&sw->pool_lock);
+    return NULL;
+}
+
+// Tile range an op touches, clamped to the framebuffer; 0 if it's off-screen
+static int op_tiles(SoftwareAPI* sw, const DrawOp* op, int* tx0, int* ty0, int* tx1, int* ty1) {
+    ClipRect bounds = op_bounds(op);
+    if (bounds.x0 < 0) bounds.x0 = 0;
+    if (bounds.y0 < 0) bounds.y0 = 0;
+    if (bounds.x1 > sw->width) bounds.x1 = sw->width;
+    if (bounds.y1 > sw->height) bounds.y1 = sw->height;
+    if (bounds.x1 <= bounds.x0 || bounds.y1 <= bounds.y0) return 0;
+    *tx0 = bounds.x0 / TILE_SIZE;
+    *ty0 = bounds.y0 / TILE_SIZE;
+    *tx1 = (bounds.x1 - 1) / TILE_SIZE;
+    *ty1 = (bounds.y1 - 1) / TILE_SIZE;
+    return 1;
+}
+
+// Rasterize a whole frame: bin ops by tile, then tiles in parallel
+static void software_rasterize_frame(SoftwareAPI* sw, const DrawOp* ops, int count) {
+    RasterFrame* frame = &sw->frame;
+    frame->ops = ops;
+    if (count > frame->op_capacity) {
+        frame->op_capacity = count;
+        frame->op_colors = (uint32_t*)realloc(frame->op_colors, count * sizeof(uint32_t));
+    }
+    memset(frame->bin_start, 0, (frame->tile_count + 1) * sizeof(int));
+    atomic_init(&frame->next_tile, 0);
+    
+    uint32_t color = color_values[sw->current_color];
+    int tx0, ty0, tx1, ty1;
+    for (int i = 0; i < count; i++) {
+        if (ops[i].kind == OP_SET_COLOR) {
+            sw->current_color = ops[i].color;
+            color = color_values[ops[i].color];
+            continue;
+        }
+        frame->op_colors[i] = color;
+        if (!op_tiles(sw, &ops[i], &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) frame->bin_start[ty * frame->tiles_x + tx + 1]++;
+        }
+    }
+    for (int t = 0; t < frame->tile_count; t++) frame->bin_start[t + 1] += frame->bin_start[t];
+    if (frame->bin_start[frame->tile_count] > frame->bin_capacity) {
+        frame->bin_capacity = frame->bin_start[frame->tile_count];
+        frame->bin_ops = (int*)realloc(frame->bin_ops, frame->bin_capacity * sizeof(int));
+    }
+    memcpy(frame->bin_fill, frame->bin_start, frame->tile_count * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        if (ops[i].kind == OP_SET_COLOR || !op_tiles(sw, &ops[i], &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) frame->bin_ops[frame->bin_fill[ty * frame->tiles_x + tx]++] = i;
+        }
+    }
+    
+    // Wake the helpers; the calling thread draws tiles too, then waits for them
+    int helpers = sw->thread_count - 1;
+    if (helpers > 0) {
+        pthread_mutex_lock(&sw->pool_lock);
+        sw->busy_helpers = helpers;
+        sw->frame_number++;
+        pthread_cond_broadcast(&sw->frame_ready);
+        pthread_mutex_unlock(&sw->pool_lock);
+    }
+    raster_tiles(sw);
+    if (helpers > 0) {
+        pthread_mutex_lock(&sw->pool_lock);
+        while (sw->busy_helpers > 0) {
+            pthread_cond_wait(&sw->frame_done, &sw->pool_lock);
+        }
+        pthread_mutex_unlock(&sw->pool_lock);
+    }
+}
+
 void software_draw_circle(DrawingAPI* self, int x, int y, int radius) {
     SoftwareAPI* sw = (SoftwareAPI*)self;
     printf("Software: Plotting %s circle at (%d,%d) with radius %d\n", 
-           sw->current_color, x, y, radius);
-    printf("  setPixelColor(%s); plotCirclePixels(%d, %d, %d);\n", sw->current_color, x, y, radius);
+           color_name(sw->current_color), x, y, radius);
+    printf("  setPixelColor(%s); plotCirclePixels(%d, %d, %d);\n", color_name(sw->current_color), x, y, radius);
+    DrawOp op = {OP_CIRCLE, (uint8_t)sw->current_color, x, y, radius, 0};
+    rasterize_op(sw, &op, color_values[sw->current_color], whole_framebuffer(sw));
 }
 
 void software_draw_rectangle(DrawingAPI* self, int x, int y, int width, int height) {
     SoftwareAPI* sw = (SoftwareAPI*)self;
     printf("Software: Plotting %s rectangle at (%d,%d) size %dx%d\n", 
-           sw->current_color, x, y, width, height);
-    printf("  setPixelColor(%s); plotRectPixels(%d, %d, %d, %d);\n", sw->current_color, x, y, width, height);
+           color_name(sw->current_color), x, y, width, height);
+    printf("  setPixelColor(%s); plotRectPixels(%d, %d, %d, %d);\n", color_name(sw->current_color), x, y, width, height);
+    DrawOp op = {OP_RECTANGLE, (uint8_t)sw->current_color, x, y, width, height};
+    rasterize_op(sw, &op, color_values[sw->current_color], whole_framebuffer(sw));
+}
+
+void software_set_color_id(DrawingAPI* self, int color_id) {
+    SoftwareAPI* sw = (SoftwareAPI*)self;
+    sw->current_color = color_id;
+    printf("Software: Color set to %s\n", color_name(color_id));
 }
 
-void software_set_color(DrawingAPI* self, const char* color) {
+void software_submit(DrawingAPI* self, const DrawOp* ops, int count) {
     SoftwareAPI* sw = (SoftwareAPI*)self;
-    strcpy(sw->current_color, color);
-    printf("Software: Color set to %s\n", color);
+    printf("Software: Rasterizing batch of %d ops into %dx%d framebuffer (%d threads)\n",
+           count, sw->width, sw->height, sw->thread_count);
+    software_rasterize_frame(sw, ops, count);
 }
 
 const char* software_get_name(DrawingAPI* self) {
     return "Software Renderer";
 }
 
-DrawingAPI* create_software_api() {
+void software_clear(DrawingAPI* self, const char* color) {
+    SoftwareAPI* sw = (SoftwareAPI*)self;
+    int color_id = intern_color(color);
+    if (color_id < 0) {
+        report_color_table_full(color);
+        return;
+    }
+    uint32_t value = color_values[color_id];
+    for (int y = 0; y < sw->height; y++) {
+        sw->fill_span(sw->pixels + (size_t)y * sw->width, sw->width, value);
+    }
+}
+
+uint32_t software_get_pixel(DrawingAPI* self, int x, int y) {
+    SoftwareAPI* sw = (SoftwareAPI*)self;
+    return sw->pixels[(size_t)y * sw->width + x];
+}
+
+// Headless output: write the framebuffer as a binary PPM image
+int software_save_ppm(DrawingAPI* self, const char* path) {
+    SoftwareAPI* sw = (SoftwareAPI*)self;
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+    fprintf(file, "P6\n%d %d\n255\n", sw->width, sw->height);
+    for (size_t i = 0; i < (size_t)sw->width * sw->height; i++) {
+        unsigned char rgb[3] = {sw->pixels[i] >> 16 & 0xFF, sw->pixels[i] >> 8 & 0xFF, sw->pixels[i] & 0xFF};
+        fwrite(rgb, 1, 3, file);
+    }
+    fclose(file);
+    return 1;
+}
+
+void software_release(DrawingAPI* self) {
+    SoftwareAPI* sw = (SoftwareAPI*)self;
+    pthread_mutex_lock(&sw->pool_lock);
+    sw->shutting_down = 1;
+    pthread_cond_broadcast(&sw->frame_ready);
+    pthread_mutex_unlock(&sw->pool_lock);
+    for (int i = 0; i < sw->thread_count - 1; i++) {
+        pthread_join(sw->helpers[i], NULL);
+    }
+    pthread_mutex_destroy(&sw->pool_lock);
+    pthread_cond_destroy(&sw->frame_ready);
+    pthread_cond_destroy(&sw->frame_done);
+    
+    free(sw->frame.op_colors);
+    free(sw->frame.bin_start);
+    free(sw->frame.bin_fill);
+    free(sw->frame.bin_ops);
+    free(sw->pixels);
+}
+
+DrawingAPI* create_software_api_with_framebuffer(int width, int height, int thread_count) {
     SoftwareAPI* sw = (SoftwareAPI*)malloc(sizeof(SoftwareAPI));
-    strcpy(sw->current_color, "white");
+    sw->current_color = intern_color_or_first("white");
+    sw->base.commands = NULL;
+    sw->base.recording = 0;
+    sw->width = width;
+    sw->height = height;
+    sw->thread_count = thread_count < 1 ? 1 : thread_count > MAX_RASTER_THREADS ? MAX_RASTER_THREADS : thread_count;
+    sw->pixels = (uint32_t*)malloc((size_t)width * height * sizeof(uint32_t));
+    sw->fill_span = detect_fill_span();
     
     sw->base.draw_circle = software_draw_circle;
     sw->base.draw_rectangle = software_draw_rectangle;
-    sw->base.set_color = software_set_color;
+    sw->base.set_color = api_set_color_by_name;
+    sw->base.set_color_id = software_set_color_id;
+    sw->base.submit = software_submit;
     sw->base.get_name = software_get_name;
+    sw->base.release = software_release;
     
+    // Bins are sized by the framebuffer; op arrays grow with the frames
+    RasterFrame* frame = &sw->frame;
+    frame->tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    frame->tile_count = frame->tiles_x * ((height + TILE_SIZE - 1) / TILE_SIZE);
+    frame->bin_start = (int*)calloc(frame->tile_count + 1, sizeof(int));
+    frame->bin_fill = (int*)malloc(frame->tile_count * sizeof(int));
+    frame->op_colors = NULL;
+    frame->op_capacity = 0;
+    frame->bin_ops = NULL;
+    frame->bin_capacity = 0;
+    
+    pthread_mutex_init(&sw->pool_lock, NULL);
+    pthread_cond_init(&sw->frame_ready, NULL);
+    pthread_cond_init(&sw->frame_done, NULL);
+    sw->frame_number = 0;
+    sw->busy_helpers = 0;
+    sw->shutting_down = 0;
+    for (int i = 0; i < sw->thread_count - 1; i++) {
+        pthread_create(&sw->helpers[i], NULL, raster_helper, sw);
+    }
+    
+    software_clear((DrawingAPI*)sw, "black");
     return (DrawingAPI*)sw;
 }
 
+DrawingAPI* create_software_api() {
+    return create_software_api_with_framebuffer(320, 240, 4);
+}
+
+// ---- Frame recording ----
+
+// Start recording a frame for 'api'. With sort_by_state, ops are grouped by
+// colour at the end of the frame (keeping their order within a colour),
+// like a GPU batching opaque draws; leave it off if overlapping shapes of
+// different colours must keep painter's order.
+void drawing_api_begin_frame(DrawingAPI* api, int sort_by_state) {
+    if (api->commands == NULL) {
+        api->commands = (DrawCommandBuffer*)calloc(1, sizeof(DrawCommandBuffer));
+    }
+    api->commands->count = 0;
+    api->commands->current_color = -1;
+    api->commands->sort_by_state = sort_by_state;
+    api->recording = 1;
+}
+
+static void record_op(DrawCommandBuffer* commands, DrawOpKind kind, int x, int y, int a, int b) {
+    if (commands->count == commands->capacity) {
+        commands->capacity = commands->capacity ? commands->capacity * 2 : 64;
+        commands->ops = (DrawOp*)realloc(commands->ops, commands->capacity * sizeof(DrawOp));
+    }
+    DrawOp* op = &commands->ops[commands->count++];
+    op->kind = (uint8_t)kind;
+    op->color = (uint8_t)(commands->current_color < 0 ? 0 : commands->current_color);
+    op->x = x;
+    op->y = y;
+    op->a = a;
+    op->b = b;
+}
+
+// What shapes call: record while a frame is open, otherwise draw now
+void api_set_color(DrawingAPI* api, int color_id) {
+    if (api->recording) {
+        api->commands->current_color = color_id;  // State only; no op yet
+    } else {
+        api->set_color_id(api, color_id);
+    }
+}
+
+void api_draw_circle(DrawingAPI* api, int x, int y, int radius) {
+    if (api->recording) {
+        record_op(api->commands, OP_CIRCLE, x, y, radius, 0);
+    } else {
+        api->draw_circle(api, x, y, radius);
+    }
+}
+
+void api_draw_rectangle(DrawingAPI* api, int x, int y, int width, int height) {
+    if (api->recording) {
+        record_op(api->commands, OP_RECTANGLE, x, y, width, height);
+    } else {
+        api->draw_rectangle(api, x, y, width, height);
+    }
+}
+
+// Group by colour with a stable counting sort (O(n), colours are few),
+// insert a colour change only where the colour actually changes, and hand
+// the backend the whole frame.
+void drawing_api_end_frame(DrawingAPI* api) {
+    if (!api->recording) return;
+    DrawCommandBuffer* commands = api->commands;
+    api->recording = 0;  // Anything drawn from here on is immediate again
+    
+    DrawOp* ordered = commands->ops;
+    DrawOp* sorted = NULL;
+    if (commands->sort_by_state && commands->count > 1) {
+        int starts[MAX_COLORS + 1] = {0};
+        for (int i = 0; i < commands->count; i++) starts[commands->ops[i].color + 1]++;
+        for (int c = 0; c < MAX_COLORS; c++) starts[c + 1] += starts[c];
+        sorted = (DrawOp*)malloc(commands->count * sizeof(DrawOp));
+        for (int i = 0; i < commands->count; i++) {
+            sorted[starts[commands->ops[i].color]++] = commands->ops[i];
+        }
+        ordered = sorted;
+    }
+    
+    // Worst case one colour change per draw
+    if (commands->submitted_capacity < commands->count * 2) {
+        commands->submitted_capacity = commands->count * 2;
+        commands->submitted = (DrawOp*)realloc(commands->submitted,
+                                               commands->submitted_capacity * sizeof(DrawOp));
+    }
+    int submitted = 0;
+    int color = -1;
+    for (int i = 0; i < commands->count; i++) {
+        if (ordered[i].color != color) {
+            color = ordered[i].color;
+            DrawOp change = {OP_SET_COLOR, (uint8_t)color, 0, 0, 0, 0};
+            commands->submitted[submitted++] = change;
+        }
+        commands->submitted[submitted++] = ordered[i];
+    }
+    free(sorted);
+    
+    if (submitted > 0) {
+        api->submit(api, commands->submitted, submitted);
+    }
+    commands->count = 0;
+}
+
 // Abstraction: Shape
 typedef struct Shape Shape;
 struct Shape {
     DrawingAPI* drawing_api;
     int x, y;
-    char color[50];
+    char color[COLOR_NAME_SIZE];
+    int color_id;              // Interned form of 'color', used when drawing
     
     void (*draw)(Shape* self);
     void (*move)(Shape* self, int new_x, int new_y);
@@ -179,9 +823,8 @@ typedef struct {
 
 void circle_draw(Shape* self) {
     Circle* circle = (Circle*)self;
-    circle->base.drawing_api->set_color(circle->base.drawing_api, circle->base.color);
-    circle->base.drawing_api->draw_circle(circle->base.drawing_api, 
-                                         circle->base.x, circle->base.y, circle->radius);
+    api_set_color(circle->base.drawing_api, circle->base.color_id);
+    api_draw_circle(circle->base.drawing_api, circle->base.x, circle->base.y, circle->radius);
 }
 
 void circle_resize(Shape* self, int factor) {
@@ -197,8 +840,15 @@ void shape_move(Shape* self, int new_x, int new_y) {
 }
 
 void shape_set_color(Shape* self, const char* color) {
-    strcpy(self->color, color);
-    printf("Shape color changed to %s\n", color);
+    int color_id = intern_color(color);
+    if (color_id < 0) {
+        report_color_table_full(color);
+        printf("Shape keeps its color %s\n", self->color);
+        return;
+    }
+    strcpy(self->color, color_name(color_id));
+    self->color_id = color_id;
+    printf("Shape color changed to %s\n", self->color);
 }
 
 Shape* create_circle(DrawingAPI* api, int x, int y, int radius, const char* color) {
@@ -207,7 +857,8 @@ Shape* create_circle(DrawingAPI* api, int x, int y, int radius, const char* colo
     circle->base.drawing_api = api;
     circle->base.x = x;
     circle->base.y = y;
-    strcpy(circle->base.color, color);
+    circle->base.color_id = intern_color_or_first(color);
+    strcpy(circle->base.color, color_name(circle->base.color_id));
     circle->radius = radius;
     
     circle->base.draw = circle_draw;
@@ -226,10 +877,9 @@ typedef struct {
 
 void rectangle_draw(Shape* self) {
     Rectangle* rect = (Rectangle*)self;
-    rect->base.drawing_api->set_color(rect->base.drawing_api, rect->base.color);
-    rect->base.drawing_api->draw_rectangle(rect->base.drawing_api, 
-                                          rect->base.x, rect->base.y, 
-                                          rect->width, rect->height);
+    api_set_color(rect->base.drawing_api, rect->base.color_id);
+    api_draw_rectangle(rect->base.drawing_api, rect->base.x, rect->base.y,
+                       rect->width, rect->height);
 }
 
 void rectangle_resize(Shape* self, int factor) {
@@ -245,7 +895,8 @@ Shape* create_rectangle(DrawingAPI* api, int x, int y, int width, int height, co
     rect->base.drawing_api = api;
     rect->base.x = x;
     rect->base.y = y;
-    strcpy(rect->base.color, color);
+    rect->base.color_id = intern_color_or_first(color);
+    strcpy(rect->base.color, color_name(rect->base.color_id));
     rect->width = width;
     rect->height = height;
     
@@ -265,6 +916,14 @@ void destroy_shape(Shape* shape) {
 
 void destroy_api(DrawingAPI* api) {
     if (api) {
+        if (api->commands) {
+            free(api->commands->ops);
+            free(api->commands->submitted);
+            free(api->commands);
+        }
+        if (api->release) {
+            api->release(api);
+        }
         free(api);
     }
 }
@@ -316,6 +975,68 @@ int main() {
     printf("Modified Circle 1:\n");
     circle1->draw(circle1);
     
+    printf("\n--- Batched frame (command buffer) ---\n");
+    // Same shapes, recorded and sent as one submit; the two reds and two
+    // blues share one colour change each
+    Shape* rect3 = create_rectangle(opengl, 0, 0, 10, 10, "red");
+    Shape* circle4 = create_circle(opengl, 5, 5, 3, "blue");
+    Shape* rect4 = create_rectangle(opengl, 20, 0, 10, 10, "blue");
+    drawing_api_begin_frame(opengl, 1);
+    circle1->set_color(circle1, "red");
+    circle1->draw(circle1);
+    circle4->draw(circle4);
+    rect3->draw(rect3);
+    rect1->draw(rect1);
+    rect4->draw(rect4);
+    drawing_api_end_frame(opengl);
+    
+    printf("\n--- Software rasterizer ---\n");
+    // circle3 was drawn immediately above; add a batched frame on top
+    Shape* sw_rect = create_rectangle(software, 40, 50, 100, 30, "blue");
+    drawing_api_begin_frame(software, 0);
+    sw_rect->draw(sw_rect);
+    circle3->draw(circle3);
+    drawing_api_end_frame(software);
+    printf("Pixel (50,60) is %s, (130,75) is %s, (300,200) is %s\n",
+           software_get_pixel(software, 50, 60) == color_values[intern_color("green")] ? "green" : "?",
+           software_get_pixel(software, 130, 75) == color_values[intern_color("blue")] ? "blue" : "?",
+           software_get_pixel(software, 300, 200) == color_values[intern_color("black")] ? "black" : "?");
+    
+    // Throughput: one full-screen fill plus 1000 circles at 1080p
+    DrawingAPI* headless = create_software_api_with_framebuffer(1920, 1080, 4);
+    Shape* background = create_rectangle(headless, 0, 0, 1920, 1080, "white");
+    Shape* dot = create_circle(headless, 0, 0, 40, "red");
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    drawing_api_begin_frame(headless, 0);
+    background->draw(background);
+    for (int i = 0; i < 1000; i++) {
+        dot->x = (i * 97) % 1920;
+        dot->y = (i * 53) % 1080;
+        dot->draw(dot);
+    }
+    drawing_api_end_frame(headless);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("1080p frame (background + 1000 circles) in %.2f ms\n", ms);
+    destroy_shape(background);
+    destroy_shape(dot);
+    destroy_shape(sw_rect);
+    destroy_api(headless);
+    
+    printf("\n--- Full color table ---\n");
+    const char* long_name = "a very particular shade of midnight blue, almost black";
+    printf("%s A %zu-character color name keeps one ID\n",
+           intern_color(long_name) == intern_color(long_name) ? "✅" : "❌", strlen(long_name));
+    // DrawOp.color is one byte, so at most MAX_COLORS names get an ID
+    char shade[32];
+    for (int i = 0; color_count < MAX_COLORS; i++) {
+        snprintf(shade, sizeof(shade), "shade %d", i);
+        intern_color(shade);
+    }
+    circle1->set_color(circle1, "teal");
+    circle1->draw(circle1);
+    
     printf("\n--- Bridge Pattern Benefits ---\n");
     printf("✅ Abstraction (Shape) and Implementation (DrawingAPI) vary independently\n");
     printf("✅ Same shape can use different rendering backends\n");
@@ -328,6 +1049,9 @@ int main() {
     destroy_shape(circle3);
     destroy_shape(rect1);
     destroy_shape(rect2);
+    destroy_shape(rect3);
+    destroy_shape(rect4);
+    destroy_shape(circle4);
     
     destroy_api(opengl);
     destroy_api(directx);
@@ -17,25 +17,63 @@
  * Cons:
  * - Can make design overly general
  * - Hard to restrict component types
+ *
+ * Size caching: every component knows its parent, and each directory
+ * caches its total size. add/remove and file_set_size() mark the cache
+ * stale up the parent chain (stopping at the first directory that is
+ * already stale), so repeated size queries are O(1).
+ *
+ * Large directories: children live in a growable array. Past a handful of
+ * entries a directory also keeps a hash index from name to position, so
+ * find_child(), remove() and resolve_path() don't scan. remove() fills the
+ * gap with the last child (swap-remove), so order isn't preserved.
+ *
+ * Parallel queries: evaluate_tree_parallel() computes total size, counts
+ * per file type and the largest N files on a work-stealing pool. Types
+ * past the first MAX_FILE_TYPES are counted together as "other". Each
+ * directory becomes a task, and wide directories are split into
+ * grain-sized ranges. Workers keep private tallies that are merged at
+ * the end.
+ *
+ * Benchmarks: build with -DPATTERN_BENCH for size query, path lookup and
+ * parallel evaluation microbenchmarks instead of the demo, and with
+ * -DPATTERN_COUNTERS for hot-path counters (see ../bench.h).
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "../bench.h"
+
+HOT_COUNTER(composite_size_queries, "composite", "directory size queries");
+HOT_COUNTER(composite_recomputes, "composite", "size recomputes");
+HOT_COUNTER(composite_invalidations, "composite", "directories invalidated");
+HOT_COUNTER(composite_lookups, "composite", "path segment lookups");
+HOT_COUNTER(composite_tree_tasks, "composite", "parallel tree tasks");
 
 // Component interface
 typedef struct FileSystemComponent FileSystemComponent;
 
 struct FileSystemComponent {
     char name[256];
+    FileSystemComponent* parent;  // Containing directory, NULL at the top
+    int is_directory;
     void (*display)(FileSystemComponent* self, int indent);
     int (*get_size)(FileSystemComponent* self);
     void (*add)(FileSystemComponent* self, FileSystemComponent* component);
     void (*remove)(FileSystemComponent* self, FileSystemComponent* component);
     FileSystemComponent* (*get_child)(FileSystemComponent* self, int index);
+    FileSystemComponent* (*find_child)(FileSystemComponent* self, const char* name);
     void (*destroy)(FileSystemComponent* self);
 };
 
+// Mark the cached sizes of 'directory' and its ancestors stale. A stale
+// directory's ancestors are always stale too, so the walk can stop early.
+void invalidate_size(FileSystemComponent* directory);
+
 // Leaf: File
 typedef struct {
     FileSystemComponent base;
@@ -67,6 +105,21 @@ FileSystemComponent* file_get_child(FileSystemComponent* self, int index) {
     return NULL;
 }
 
+FileSystemComponent* file_find_child(FileSystemComponent* self, const char* name) {
+    (void)self;
+    (void)name;
+    return NULL;  // Files contain nothing; resolve_path() reports the miss
+}
+
+// Change a file's size; the directories above it recompute on next query
+void file_set_size(FileSystemComponent* self, int size) {
+    File* file = (File*)self;
+    file->size_bytes = size;
+    if (self->parent != NULL) {
+        invalidate_size(self->parent);
+    }
+}
+
 void file_destroy(FileSystemComponent* self) {
     if (self) {
         free(self);
@@ -77,6 +130,8 @@ FileSystemComponent* create_file(const char* name, const char* type, int size) {
     File* file = (File*)malloc(sizeof(File));
     
     strcpy(file->base.name, name);
+    file->base.parent = NULL;
+    file->base.is_directory = 0;
     strcpy(file->type, type);
     file->size_bytes = size;
     
@@ -85,20 +140,97 @@ FileSystemComponent* create_file(const char* name, const char* type, int size) {
     file->base.add = file_add;
     file->base.remove = file_remove;
     file->base.get_child = file_get_child;
+    file->base.find_child = file_find_child;
     file->base.destroy = file_destroy;
     
     return (FileSystemComponent*)file;
 }
 
 // Composite: Directory
-#define MAX_CHILDREN 50
+#define INDEX_THRESHOLD 8   // Below this many children a scan beats hashing
 
 typedef struct {
     FileSystemComponent base;
-    FileSystemComponent* children[MAX_CHILDREN];
+    FileSystemComponent** children;
     int child_count;
+    int child_capacity;
+    int* name_index;     // Open addressing: child position, or -1 if empty
+    int index_capacity;  // Power of two, 0 while there's no index
+    int cached_size;     // Total size of the subtree, valid unless size_stale
+    int size_stale;
 } Directory;
 
+// ---- Name index ----
+
+static unsigned long hash_name(const char* name) {
+    unsigned long hash = 2166136261u;  // FNV-1a
+    while (*name) {
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+// Slot holding 'name', or the empty slot where it would go
+static int index_probe(Directory* dir, const char* name) {
+    int mask = dir->index_capacity - 1;
+    int slot = (int)(hash_name(name) & mask);
+    while (dir->name_index[slot] >= 0 &&
+           strcmp(dir->children[dir->name_index[slot]]->name, name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Rebuild the index for the current children at twice their count or more
+static void index_rebuild(Directory* dir) {
+    int capacity = 16;
+    while (capacity < dir->child_count * 2) capacity *= 2;
+    free(dir->name_index);
+    dir->name_index = (int*)malloc(capacity * sizeof(int));
+    dir->index_capacity = capacity;
+    for (int i = 0; i < capacity; i++) dir->name_index[i] = -1;
+    for (int i = 0; i < dir->child_count; i++) {
+        dir->name_index[index_probe(dir, dir->children[i]->name)] = i;
+    }
+}
+
+// Empty 'slot' and shift later entries of its probe run back, so lookups
+// never need tombstones
+static void index_erase_slot(Directory* dir, int slot) {
+    int mask = dir->index_capacity - 1;
+    int hole = slot;
+    int next = (slot + 1) & mask;
+    while (dir->name_index[next] >= 0) {
+        int home = (int)(hash_name(dir->children[dir->name_index[next]]->name) & mask);
+        // Move the entry if its home isn't in the cyclic range (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            dir->name_index[hole] = dir->name_index[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    dir->name_index[hole] = -1;
+}
+
+// Position of the child called 'name', or -1
+static int directory_position_of(Directory* dir, const char* name) {
+    if (dir->index_capacity > 0) {
+        return dir->name_index[index_probe(dir, name)];
+    }
+    for (int i = 0; i < dir->child_count; i++) {
+        if (strcmp(dir->children[i]->name, name) == 0) return i;
+    }
+    return -1;
+}
+
+void invalidate_size(FileSystemComponent* directory) {
+    while (directory != NULL && !((Directory*)directory)->size_stale) {
+        ((Directory*)directory)->size_stale = 1;
+        COUNTER_ADD(composite_invalidations, 1);
+        directory = directory->parent;
+    }
+}
+
 void directory_display(FileSystemComponent* self, int indent) {
     Directory* dir = (Directory*)self;
     
@@ -114,43 +246,83 @@ void directory_display(FileSystemComponent* self, int indent) {
 
 int directory_get_size(FileSystemComponent* self) {
     Directory* dir = (Directory*)self;
-    int total_size = 0;
+    COUNTER_ADD(composite_size_queries, 1);
+    if (!dir->size_stale) {
+        return dir->cached_size;
+    }
+    COUNTER_ADD(composite_recomputes, 1);
     
-    // Recursively calculate size of all children
+    // Recompute from the children; only stale subdirectories recurse further
+    int total_size = 0;
     for (int i = 0; i < dir->child_count; i++) {
         total_size += dir->children[i]->get_size(dir->children[i]);
     }
     
+    dir->cached_size = total_size;
+    dir->size_stale = 0;
     return total_size;
 }
 
 void directory_add(FileSystemComponent* self, FileSystemComponent* component) {
     Directory* dir = (Directory*)self;
     
-    if (dir->child_count < MAX_CHILDREN) {
-        dir->children[dir->child_count] = component;
-        dir->child_count++;
-        printf("Added '%s' to directory '%s'\n", component->name, dir->base.name);
-    } else {
-        printf("Error: Directory '%s' is full\n", dir->base.name);
+    if (component->parent != NULL) {
+        printf("Error: '%s' is already in directory '%s'\n", component->name, component->parent->name);
+        return;
+    }
+    if (directory_position_of(dir, component->name) >= 0) {
+        printf("Error: '%s' already exists in directory '%s'\n", component->name, dir->base.name);
+        return;
     }
+    
+    if (dir->child_count == dir->child_capacity) {
+        dir->child_capacity = dir->child_capacity ? dir->child_capacity * 2 : 4;
+        dir->children = (FileSystemComponent**)realloc(dir->children,
+                                                       dir->child_capacity * sizeof(FileSystemComponent*));
+    }
+    int position = dir->child_count++;
+    dir->children[position] = component;
+    
+    if (dir->index_capacity > 0 && dir->child_count * 2 <= dir->index_capacity) {
+        dir->name_index[index_probe(dir, component->name)] = position;
+    } else if (dir->child_count >= INDEX_THRESHOLD) {
+        index_rebuild(dir);
+    }
+    
+    component->parent = self;
+    invalidate_size(self);
+    PATTERN_LOG("Added '%s' to directory '%s'\n", component->name, dir->base.name);
 }
 
 void directory_remove(FileSystemComponent* self, FileSystemComponent* component) {
     Directory* dir = (Directory*)self;
     
-    for (int i = 0; i < dir->child_count; i++) {
-        if (dir->children[i] == component) {
-            // Shift remaining elements
-            for (int j = i; j < dir->child_count - 1; j++) {
-                dir->children[j] = dir->children[j + 1];
-            }
-            dir->child_count--;
-            printf("Removed '%s' from directory '%s'\n", component->name, dir->base.name);
-            return;
+    int position = component->parent == self ? directory_position_of(dir, component->name) : -1;
+    if (position < 0 || dir->children[position] != component) {
+        printf("Error: Component not found in directory\n");
+        return;
+    }
+    
+    // Move the last child into the gap
+    int last = dir->child_count - 1;
+    if (dir->index_capacity > 0) {
+        index_erase_slot(dir, index_probe(dir, component->name));
+        if (position != last) {
+            dir->name_index[index_probe(dir, dir->children[last]->name)] = position;
         }
     }
-    printf("Error: Component not found in directory\n");
+    dir->children[position] = dir->children[last];
+    dir->child_count--;
+    
+    component->parent = NULL;
+    invalidate_size(self);
+    printf("Removed '%s' from directory '%s'\n", component->name, dir->base.name);
+}
+
+FileSystemComponent* directory_find_child(FileSystemComponent* self, const char* name) {
+    Directory* dir = (Directory*)self;
+    int position = directory_position_of(dir, name);
+    return position >= 0 ? dir->children[position] : NULL;
 }
 
 FileSystemComponent* directory_get_child(FileSystemComponent* self, int index) {
@@ -170,6 +342,8 @@ void directory_destroy(FileSystemComponent* self) {
         for (int i = 0; i < dir->child_count; i++) {
             dir->children[i]->destroy(dir->children[i]);
         }
+        free(dir->children);
+        free(dir->name_index);
         free(dir);
     }
 }
@@ -178,21 +352,375 @@ FileSystemComponent* create_directory(const char* name) {
     Directory* dir = (Directory*)malloc(sizeof(Directory));
     
     strcpy(dir->base.name, name);
+    dir->base.parent = NULL;
+    dir->base.is_directory = 1;
+    dir->children = NULL;
     dir->child_count = 0;
+    dir->child_capacity = 0;
+    dir->name_index = NULL;
+    dir->index_capacity = 0;
+    dir->cached_size = 0;
+    dir->size_stale = 1;
     
     dir->base.display = directory_display;
     dir->base.get_size = directory_get_size;
     dir->base.add = directory_add;
     dir->base.remove = directory_remove;
     dir->base.get_child = directory_get_child;
+    dir->base.find_child = directory_find_child;
     dir->base.destroy = directory_destroy;
     
     return (FileSystemComponent*)dir;
 }
 
+// ---- Parallel aggregate queries ----
+
+#define MAX_FILE_TYPES 32
+#define MAX_TOP_FILES 32
+#define MAX_TREE_WORKERS 64
+
+typedef struct {
+    char type[20];
+    int count;
+    long bytes;
+} TypeTally;
+
+typedef struct {
+    long total_size;
+    int file_count;
+    int directory_count;
+    TypeTally types[MAX_FILE_TYPES];
+    int type_count;
+    TypeTally other_types;         // Every type seen after the first MAX_FILE_TYPES
+    File* largest[MAX_TOP_FILES];  // Min-heap while collecting, largest first when done
+    int largest_count;
+    int top_n;
+} TreeStats;
+
+// Children [begin, end) of one directory
+typedef struct {
+    Directory* dir;
+    int begin;
+    int end;
+} TreeTask;
+
+// Owner pushes/pops at the tail, thieves take from the head
+typedef struct {
+    pthread_mutex_t lock;
+    TreeTask* tasks;
+    int head;
+    int count;
+    int capacity;
+} TreeDeque;
+
+typedef struct {
+    int worker_count;
+    int grain_size;
+    TreeDeque* deques;
+    TreeStats* stats;      // One private tally per worker
+    atomic_int pending;    // Tasks pushed but not finished
+} TreePool;
+
+typedef struct {
+    TreePool* pool;
+    int index;
+} TreeWorkerStart;
+
+static void tree_deque_push(TreeDeque* deque, TreeTask task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count == deque->capacity) {
+        int capacity = deque->capacity ? deque->capacity * 2 : 64;
+        TreeTask* tasks = (TreeTask*)malloc(capacity * sizeof(TreeTask));
+        for (int i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->head = 0;
+        deque->capacity = capacity;
+    }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static int tree_deque_pop(TreeDeque* deque, TreeTask* out, int from_head) {
+    int found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if (deque->count > 0) {
+        if (from_head) {
+            *out = deque->tasks[deque->head];
+            deque->head = (deque->head + 1) % deque->capacity;
+        } else {
+            *out = deque->tasks[(deque->head + deque->count - 1) % deque->capacity];
+        }
+        deque->count--;
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+static void tree_pool_push(TreePool* pool, int worker, TreeTask task) {
+    atomic_fetch_add(&pool->pending, 1);
+    tree_deque_push(&pool->deques[worker], task);
+}
+
+// Ordering for the largest-N heap: by size, ties broken by name so the
+// result doesn't depend on which worker saw a file first
+static int file_smaller(File* a, File* b) {
+    if (a->size_bytes != b->size_bytes) return a->size_bytes < b->size_bytes;
+    return strcmp(a->base.name, b->base.name) > 0;
+}
+
+static void stats_offer_largest(TreeStats* stats, File* file) {
+    File** heap = stats->largest;
+    int i;
+    if (stats->largest_count < stats->top_n) {
+        i = stats->largest_count++;
+        while (i > 0 && file_smaller(file, heap[(i - 1) / 2])) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = file;
+        return;
+    }
+    if (stats->top_n == 0 || !file_smaller(heap[0], file)) return;
+    // Replace the smallest kept file and sift down
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= stats->top_n) break;
+        if (child + 1 < stats->top_n && file_smaller(heap[child + 1], heap[child])) child++;
+        if (!file_smaller(heap[child], file)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = file;
+}
+
+static void stats_add_type(TreeStats* stats, const char* type, int count, long bytes) {
+    for (int i = 0; i < stats->type_count; i++) {
+        if (strcmp(stats->types[i].type, type) == 0) {
+            stats->types[i].count += count;
+            stats->types[i].bytes += bytes;
+            return;
+        }
+    }
+    if (stats->type_count < MAX_FILE_TYPES) {
+        TypeTally* tally = &stats->types[stats->type_count++];
+        strcpy(tally->type, type);
+        tally->count = count;
+        tally->bytes = bytes;
+    } else {
+        stats->other_types.count += count;
+        stats->other_types.bytes += bytes;
+    }
+}
+
+static void stats_add_file(TreeStats* stats, File* file) {
+    stats->total_size += file->size_bytes;
+    stats->file_count++;
+    stats_add_type(stats, file->type, 1, file->size_bytes);
+    stats_offer_largest(stats, file);
+}
+
+// Split wide ranges in half (the far half becomes stealable), then tally
+// files and turn each non-empty subdirectory into a task of its own.
+// Reads fields directly: get_size() would write the size caches.
+static void tree_run_task(TreePool* pool, int worker, TreeTask task) {
+    TreeStats* stats = &pool->stats[worker];
+    COUNTER_ADD(composite_tree_tasks, 1);
+    while (task.end - task.begin > pool->grain_size) {
+        int middle = task.begin + (task.end - task.begin) / 2;
+        TreeTask far_half = {task.dir, middle, task.end};
+        tree_pool_push(pool, worker, far_half);
+        task.end = middle;
+    }
+    for (int i = task.begin; i < task.end; i++) {
+        FileSystemComponent* child = task.dir->children[i];
+        if (child->is_directory) {
+            Directory* subdirectory = (Directory*)child;
+            stats->directory_count++;
+            if (subdirectory->child_count > 0) {
+                TreeTask subtree = {subdirectory, 0, subdirectory->child_count};
+                tree_pool_push(pool, worker, subtree);
+            }
+        } else {
+            stats_add_file(stats, (File*)child);
+        }
+    }
+}
+
+// Own deque first (LIFO, cache-warm), then steal the oldest from others
+static void* tree_worker(void* arg) {
+    TreeWorkerStart* start = (TreeWorkerStart*)arg;
+    TreePool* pool = start->pool;
+    int self = start->index;
+    
+    while (atomic_load(&pool->pending) > 0) {
+        TreeTask task;
+        int found = tree_deque_pop(&pool->deques[self], &task, 0);
+        for (int i = 1; !found && i < pool->worker_count; i++) {
+            found = tree_deque_pop(&pool->deques[(self + i) % pool->worker_count], &task, 1);
+        }
+        if (found) {
+            tree_run_task(pool, self, task);
+            atomic_fetch_sub(&pool->pending, 1);
+        } else {
+            sched_yield();  // Others still hold work that may spawn more
+        }
+    }
+    return NULL;
+}
+
+static void stats_init(TreeStats* stats, int top_n) {
+    memset(stats, 0, sizeof(TreeStats));
+    stats->top_n = top_n;
+}
+
+static void stats_merge(TreeStats* into, TreeStats* from) {
+    into->total_size += from->total_size;
+    into->file_count += from->file_count;
+    into->directory_count += from->directory_count;
+    for (int i = 0; i < from->type_count; i++) {
+        stats_add_type(into, from->types[i].type, from->types[i].count, from->types[i].bytes);
+    }
+    into->other_types.count += from->other_types.count;
+    into->other_types.bytes += from->other_types.bytes;
+    for (int i = 0; i < from->largest_count; i++) {
+        stats_offer_largest(into, from->largest[i]);
+    }
+}
+
+// Aggregate the tree under 'root' with 'thread_count' workers. Ranges of up
+// to 'grain_size' children are processed without further splitting. The
+// tree must not change while this runs.
+void evaluate_tree_parallel(FileSystemComponent* root, int thread_count, int grain_size,
+                            int top_n, TreeStats* result) {
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > MAX_TREE_WORKERS) thread_count = MAX_TREE_WORKERS;
+    if (grain_size < 1) grain_size = 1;
+    if (top_n > MAX_TOP_FILES) top_n = MAX_TOP_FILES;
+    stats_init(result, top_n);
+    
+    if (!root->is_directory) {
+        stats_add_file(result, (File*)root);
+        return;
+    }
+    
+    TreePool pool;
+    pool.worker_count = thread_count;
+    pool.grain_size = grain_size;
+    pool.deques = (TreeDeque*)calloc(thread_count, sizeof(TreeDeque));
+    pool.stats = (TreeStats*)malloc(thread_count * sizeof(TreeStats));
+    atomic_init(&pool.pending, 0);
+    for (int i = 0; i < thread_count; i++) {
+        pthread_mutex_init(&pool.deques[i].lock, NULL);
+        stats_init(&pool.stats[i], top_n);
+    }
+    
+    result->directory_count = 1;  // The root itself
+    Directory* dir = (Directory*)root;
+    if (dir->child_count > 0) {
+        TreeTask whole = {dir, 0, dir->child_count};
+        tree_pool_push(&pool, 0, whole);
+    }
+    
+    pthread_t threads[MAX_TREE_WORKERS];
+    TreeWorkerStart starts[MAX_TREE_WORKERS];
+    for (int i = 0; i < thread_count; i++) {
+        starts[i].pool = &pool;
+        starts[i].index = i;
+        pthread_create(&threads[i], NULL, tree_worker, &starts[i]);
+    }
+    // Join everyone first: until the last worker exits, any deque may be stolen from
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < thread_count; i++) {
+        stats_merge(result, &pool.stats[i]);
+        free(pool.deques[i].tasks);
+        pthread_mutex_destroy(&pool.deques[i].lock);
+    }
+    free(pool.deques);
+    free(pool.stats);
+    
+    // Types by name, heap order -> largest first, so output is repeatable
+    for (int i = 1; i < result->type_count; i++) {
+        TypeTally tally = result->types[i];
+        int j = i;
+        while (j > 0 && strcmp(result->types[j - 1].type, tally.type) > 0) {
+            result->types[j] = result->types[j - 1];
+            j--;
+        }
+        result->types[j] = tally;
+    }
+    for (int i = 1; i < result->largest_count; i++) {
+        File* file = result->largest[i];
+        int j = i;
+        while (j > 0 && file_smaller(result->largest[j - 1], file)) {
+            result->largest[j] = result->largest[j - 1];
+            j--;
+        }
+        result->largest[j] = file;
+    }
+}
+
+void print_tree_stats(const TreeStats* stats) {
+    printf("Total: %ld bytes in %d files, %d directories\n",
+           stats->total_size, stats->file_count, stats->directory_count);
+    for (int i = 0; i < stats->type_count; i++) {
+        printf("  %-8s %3d files, %7ld bytes\n",
+               stats->types[i].type, stats->types[i].count, stats->types[i].bytes);
+    }
+    if (stats->other_types.count > 0) {
+        printf("  %-8s %3d files, %7ld bytes (types past the first %d)\n",
+               "other", stats->other_types.count, stats->other_types.bytes, MAX_FILE_TYPES);
+    }
+    printf("Largest %d files:\n", stats->largest_count);
+    for (int i = 0; i < stats->largest_count; i++) {
+        printf("  %d. %s (%d bytes)\n", i + 1, stats->largest[i]->base.name,
+               stats->largest[i]->size_bytes);
+    }
+}
+
+// Follow a path such as "/src/parser.c" or "tests/unit/../integration"
+// from 'start'. A leading '/' starts at the top of start's tree; "." and
+// ".." work as usual. Each step is one find_child() lookup. Returns NULL if
+// any part is missing.
+FileSystemComponent* resolve_path(FileSystemComponent* start, const char* path) {
+    FileSystemComponent* current = start;
+    if (*path == '/') {
+        while (current->parent != NULL) current = current->parent;
+    }
+    
+    char segment[256];
+    while (*path) {
+        while (*path == '/') path++;
+        size_t length = strcspn(path, "/");
+        if (length == 0) break;
+        if (length >= sizeof(segment)) return NULL;
+        memcpy(segment, path, length);
+        segment[length] = '\0';
+        path += length;
+        
+        if (strcmp(segment, "..") == 0) {
+            if (current->parent != NULL) current = current->parent;
+        } else if (strcmp(segment, ".") != 0) {
+            COUNTER_ADD(composite_lookups, 1);
+            current = current->find_child(current, segment);
+            if (current == NULL) return NULL;
+        }
+    }
+    return current;
+}
+
 // Client code that works uniformly with files and directories
 void print_separator() {
-    printf("\n" "=" * 50 "\n");
+    printf("\n");
+    for (int i = 0; i < 50; i++) printf("=");
+    printf("\n");
 }
 
 void demonstrate_composite_operations(FileSystemComponent* root) {
@@ -203,6 +731,94 @@ void demonstrate_composite_operations(FileSystemComponent* root) {
     printf("Total size of '%s': %d bytes\n", root->name, root->get_size(root));
 }
 
+#ifdef PATTERN_BENCH
+// ---- Benchmarks ----
+
+// 32 directories of 32 subdirectories of 32 files: 32768 files in all
+#define BENCH_FANOUT 32
+#define BENCH_QUERIES 10000
+#define BENCH_UPDATES 1000
+#define BENCH_LOOKUPS 1000
+
+typedef struct {
+    FileSystemComponent* root;
+    FileSystemComponent* leaves[BENCH_UPDATES];  // Spread across the tree
+    char paths[BENCH_LOOKUPS][64];
+    int file_count;
+} TreeBench;
+
+static void bench_cached_size(void* arg) {
+    TreeBench* bench = (TreeBench*)arg;
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        bench_consume(bench->root->get_size(bench->root));
+    }
+}
+
+// Each resize makes three directories stale; the query recomputes just those
+static void bench_resize_then_size(void* arg) {
+    TreeBench* bench = (TreeBench*)arg;
+    for (int i = 0; i < BENCH_UPDATES; i++) {
+        FileSystemComponent* leaf = bench->leaves[i];
+        file_set_size(leaf, ((File*)leaf)->size_bytes ^ 1);
+        bench_consume(bench->root->get_size(bench->root));
+    }
+}
+
+static void bench_resolve_path(void* arg) {
+    TreeBench* bench = (TreeBench*)arg;
+    for (int i = 0; i < BENCH_LOOKUPS; i++) {
+        bench_consume((uintptr_t)resolve_path(bench->root, bench->paths[i]));
+    }
+}
+
+static void bench_parallel_tree(void* arg) {
+    TreeBench* bench = (TreeBench*)arg;
+    TreeStats stats;
+    evaluate_tree_parallel(bench->root, 4, 64, 8, &stats);
+    bench_consume(stats.total_size);
+}
+
+int main() {
+    bench_header("Composite size queries and traversal");
+    
+    static TreeBench bench;
+    static const char* types[] = {"text", "image", "code", "data"};
+    char name[32];
+    bench.root = create_directory("root");
+    for (int d = 0; d < BENCH_FANOUT; d++) {
+        snprintf(name, sizeof(name), "d%02d", d);
+        FileSystemComponent* dir = create_directory(name);
+        bench.root->add(bench.root, dir);
+        for (int s = 0; s < BENCH_FANOUT; s++) {
+            snprintf(name, sizeof(name), "s%02d", s);
+            FileSystemComponent* subdir = create_directory(name);
+            dir->add(dir, subdir);
+            for (int f = 0; f < BENCH_FANOUT; f++) {
+                snprintf(name, sizeof(name), "f%02d.dat", f);
+                subdir->add(subdir, create_file(name, types[f % 4], 100 + (d * 7 + s * 3 + f) % 900));
+                bench.file_count++;
+            }
+        }
+    }
+    for (int i = 0; i < BENCH_UPDATES; i++) {
+        int d = (i * 7) % BENCH_FANOUT, s = (i * 13) % BENCH_FANOUT, f = (i * 29) % BENCH_FANOUT;
+        snprintf(bench.paths[i], sizeof(bench.paths[i]), "/d%02d/s%02d/f%02d.dat", d, s, f);
+        bench.leaves[i] = resolve_path(bench.root, bench.paths[i]);
+    }
+    counters_reset();
+    
+    bench_run("cached root size query (per query)", bench_cached_size, &bench, BENCH_QUERIES);
+    bench_run("leaf resize + root size query (per update)", bench_resize_then_size, &bench, BENCH_UPDATES);
+    bench_run("resolve_path, 3 levels deep (per lookup)", bench_resolve_path, &bench, BENCH_LOOKUPS);
+    bench_run("evaluate_tree_parallel, 4 workers (per file)", bench_parallel_tree, &bench,
+              bench.file_count);
+    
+    counters_report();
+    
+    bench.root->destroy(bench.root);
+    return 0;
+}
+#else
 // Example usage
 int main() {
     printf("=== COMPOSITE PATTERN EXAMPLE ===\n");
@@ -275,10 +891,70 @@ int main() {
     root->remove(root, config);
     demonstrate_composite_operations(root);
     
+    printf("\n--- Resolving Paths ---\n");
+    const char* paths[] = {"/src/parser.c", "docs/api.md", "/tests/unit/../integration", "/src/missing.c"};
+    for (int i = 0; i < 4; i++) {
+        FileSystemComponent* found = resolve_path(root, paths[i]);
+        if (found) {
+            printf("%s -> '%s' (%d bytes)\n", paths[i], found->name, found->get_size(found));
+        } else {
+            printf("%s -> not found\n", paths[i]);
+        }
+    }
+    
+    printf("\n--- A Large Directory ---\n");
+    // Past INDEX_THRESHOLD entries lookups go through the name index
+    FileSystemComponent* logs_dir = create_directory("logs");
+    root->add(root, logs_dir);
+    for (int i = 0; i < 12; i++) {
+        char log_name[32];
+        snprintf(log_name, sizeof(log_name), "day%02d.log", i + 1);
+        logs_dir->add(logs_dir, create_file(log_name, "log", 100 * (i + 1)));
+    }
+    FileSystemComponent* day05 = resolve_path(root, "/logs/day05.log");
+    logs_dir->remove(logs_dir, day05);
+    day05->destroy(day05);
+    printf("/logs/day05.log after remove -> %s\n",
+           resolve_path(root, "/logs/day05.log") ? "found" : "not found");
+    printf("/logs/day12.log -> %s\n", resolve_path(root, "/logs/day12.log") ? "found" : "not found");
+    printf("logs/ holds %d bytes\n", logs_dir->get_size(logs_dir));
+    
+    printf("\n--- Changing a File Size ---\n");
+    // Only docs/ and root/ are marked stale; src/ and tests/ keep their cache
+    file_set_size(manual_pdf, 51200);
+    printf("manual.pdf shrunk to 51200 bytes\n");
+    printf("docs/ is now %d bytes, root/ is now %d bytes\n",
+           docs_dir->get_size(docs_dir), root->get_size(root));
+    
+    printf("\n--- Parallel Aggregate Query ---\n");
+    TreeStats stats;
+    evaluate_tree_parallel(root, 4, 4, 3, &stats);
+    print_tree_stats(&stats);
+    printf("Matches get_size(): %s\n", stats.total_size == root->get_size(root) ? "yes" : "no");
+    
+    printf("\n--- More File Types Than Tallies ---\n");
+    // 36 types, one file each: the 4 past MAX_FILE_TYPES land in "other",
+    // including when two workers' tallies are merged
+    FileSystemComponent* assets_dir = create_directory("assets");
+    for (int i = 0; i < 36; i++) {
+        char asset_name[32], asset_type[20];
+        snprintf(asset_name, sizeof(asset_name), "asset%02d", i);
+        snprintf(asset_type, sizeof(asset_type), "type%02d", i);
+        assets_dir->add(assets_dir, create_file(asset_name, asset_type, 10));
+    }
+    TreeStats asset_stats;
+    evaluate_tree_parallel(assets_dir, 2, 8, 1, &asset_stats);
+    printf("%d types tallied, other: %d files, %ld bytes\n", asset_stats.type_count,
+           asset_stats.other_types.count, asset_stats.other_types.bytes);
+    printf("Every file counted: %s\n",
+           asset_stats.type_count + asset_stats.other_types.count == asset_stats.file_count ? "yes" : "no");
+    assets_dir->destroy(assets_dir);
+    
     printf("\n--- Composite Pattern Benefits ---\n");
     printf("✅ Uniform interface for files and directories\n");
     printf("✅ Easy to add new file types or directory types\n");
     printf("✅ Recursive operations work naturally\n");
+    printf("✅ Cached sizes make repeated queries O(1)\n");
     printf("✅ Client code doesn't need to distinguish leaf vs composite\n");
     
     // Cleanup
@@ -286,4 +962,5 @@ int main() {
     config->destroy(config);  // Manually destroy removed component
     
     return 0;
-}
\ No newline at end of file
+}
+#endif // PATTERN_BENCH
\ No newline at end of file
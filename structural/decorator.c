@@ -17,17 +17,58 @@
  * Cons:
  * - Can result in many small objects
  * - Harder to debug wrapped objects
+ *
+ * Compiled chains: compile_coffee() flattens a chain built with add_milk()
+ * and friends into one array of add-on kinds with a precomputed total.
+ * The description is built on first use and cached until the add-ons
+ * change.
+ *
+ * Bulk pricing: an OrderBatch stores many orders as columns (base cost,
+ * add-on bitmask) and prices them all in one pass. It uses SSE2/AVX2 or
+ * NEON when the CPU has them, with no decorator objects or virtual calls.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SIMD 1
+#endif
+
+// Add-on catalogue shared by the decorators and the compiled form
+typedef enum {
+    ADDON_NONE = -1,           // Not a decorator (a base coffee)
+    ADDON_MILK,
+    ADDON_SUGAR,
+    ADDON_WHIPPED_CREAM,
+    ADDON_VANILLA_SYRUP,
+    ADDON_COUNT
+} AddOnKind;
+
+typedef struct {
+    const char* name;
+    double price;
+} AddOnInfo;
+
+static const AddOnInfo addon_catalogue[ADDON_COUNT] = {
+    {"Milk", 0.50},
+    {"Sugar", 0.25},
+    {"Whipped Cream", 0.75},
+    {"Vanilla Syrup", 0.60},
+};
 
 // Component interface
 typedef struct Coffee Coffee;
 struct Coffee {
     char description[256];
     double cost;
+    AddOnKind addon;           // What this layer adds, ADDON_NONE for a base
     double (*get_cost)(Coffee* self);
     void (*get_description)(Coffee* self, char* result);
 };
@@ -49,6 +90,7 @@ Coffee* create_basic_coffee() {
     BasicCoffee* coffee = (BasicCoffee*)malloc(sizeof(BasicCoffee));
     strcpy(coffee->base.description, "Basic Coffee");
     coffee->base.cost = 2.00;
+    coffee->base.addon = ADDON_NONE;
     coffee->base.get_cost = basic_coffee_cost;
     coffee->base.get_description = basic_coffee_description;
     return (Coffee*)coffee;
@@ -67,19 +109,20 @@ typedef struct {
 
 double milk_cost(Coffee* self) {
     MilkDecorator* milk = (MilkDecorator*)self;
-    return milk->decorator.wrapped_coffee->get_cost(milk->decorator.wrapped_coffee) + 0.50;
+    return milk->decorator.wrapped_coffee->get_cost(milk->decorator.wrapped_coffee) + addon_catalogue[ADDON_MILK].price;
 }
 
 void milk_description(Coffee* self, char* result) {
     MilkDecorator* milk = (MilkDecorator*)self;
     char base_desc[256];
     milk->decorator.wrapped_coffee->get_description(milk->decorator.wrapped_coffee, base_desc);
-    sprintf(result, "%s + Milk", base_desc);
+    sprintf(result, "%s + %s", base_desc, addon_catalogue[ADDON_MILK].name);
 }
 
 Coffee* add_milk(Coffee* coffee) {
     MilkDecorator* milk = (MilkDecorator*)malloc(sizeof(MilkDecorator));
     milk->decorator.wrapped_coffee = coffee;
+    milk->decorator.base.addon = ADDON_MILK;
     milk->decorator.base.get_cost = milk_cost;
     milk->decorator.base.get_description = milk_description;
     return (Coffee*)milk;
@@ -92,19 +135,20 @@ typedef struct {
 
 double sugar_cost(Coffee* self) {
     SugarDecorator* sugar = (SugarDecorator*)self;
-    return sugar->decorator.wrapped_coffee->get_cost(sugar->decorator.wrapped_coffee) + 0.25;
+    return sugar->decorator.wrapped_coffee->get_cost(sugar->decorator.wrapped_coffee) + addon_catalogue[ADDON_SUGAR].price;
 }
 
 void sugar_description(Coffee* self, char* result) {
     SugarDecorator* sugar = (SugarDecorator*)self;
     char base_desc[256];
     sugar->decorator.wrapped_coffee->get_description(sugar->decorator.wrapped_coffee, base_desc);
-    sprintf(result, "%s + Sugar", base_desc);
+    sprintf(result, "%s + %s", base_desc, addon_catalogue[ADDON_SUGAR].name);
 }
 
 Coffee* add_sugar(Coffee* coffee) {
     SugarDecorator* sugar = (SugarDecorator*)malloc(sizeof(SugarDecorator));
     sugar->decorator.wrapped_coffee = coffee;
+    sugar->decorator.base.addon = ADDON_SUGAR;
     sugar->decorator.base.get_cost = sugar_cost;
     sugar->decorator.base.get_description = sugar_description;
     return (Coffee*)sugar;
@@ -117,19 +161,20 @@ typedef struct {
 
 double whipped_cream_cost(Coffee* self) {
     WhippedCreamDecorator* cream = (WhippedCreamDecorator*)self;
-    return cream->decorator.wrapped_coffee->get_cost(cream->decorator.wrapped_coffee) + 0.75;
+    return cream->decorator.wrapped_coffee->get_cost(cream->decorator.wrapped_coffee) + addon_catalogue[ADDON_WHIPPED_CREAM].price;
 }
 
 void whipped_cream_description(Coffee* self, char* result) {
     WhippedCreamDecorator* cream = (WhippedCreamDecorator*)self;
     char base_desc[256];
     cream->decorator.wrapped_coffee->get_description(cream->decorator.wrapped_coffee, base_desc);
-    sprintf(result, "%s + Whipped Cream", base_desc);
+    sprintf(result, "%s + %s", base_desc, addon_catalogue[ADDON_WHIPPED_CREAM].name);
 }
 
 Coffee* add_whipped_cream(Coffee* coffee) {
     WhippedCreamDecorator* cream = (WhippedCreamDecorator*)malloc(sizeof(WhippedCreamDecorator));
     cream->decorator.wrapped_coffee = coffee;
+    cream->decorator.base.addon = ADDON_WHIPPED_CREAM;
     cream->decorator.base.get_cost = whipped_cream_cost;
     cream->decorator.base.get_description = whipped_cream_description;
     return (Coffee*)cream;
@@ -142,24 +187,295 @@ typedef struct {
 
 double vanilla_syrup_cost(Coffee* self) {
     VanillaSyrupDecorator* syrup = (VanillaSyrupDecorator*)self;
-    return syrup->decorator.wrapped_coffee->get_cost(syrup->decorator.wrapped_coffee) + 0.60;
+    return syrup->decorator.wrapped_coffee->get_cost(syrup->decorator.wrapped_coffee) + addon_catalogue[ADDON_VANILLA_SYRUP].price;
 }
 
 void vanilla_syrup_description(Coffee* self, char* result) {
     VanillaSyrupDecorator* syrup = (VanillaSyrupDecorator*)self;
     char base_desc[256];
     syrup->decorator.wrapped_coffee->get_description(syrup->decorator.wrapped_coffee, base_desc);
-    sprintf(result, "%s + Vanilla Syrup", base_desc);
+    sprintf(result, "%s + %s", base_desc, addon_catalogue[ADDON_VANILLA_SYRUP].name);
 }
 
 Coffee* add_vanilla_syrup(Coffee* coffee) {
     VanillaSyrupDecorator* syrup = (VanillaSyrupDecorator*)malloc(sizeof(VanillaSyrupDecorator));
     syrup->decorator.wrapped_coffee = coffee;
+    syrup->decorator.base.addon = ADDON_VANILLA_SYRUP;
     syrup->decorator.base.get_cost = vanilla_syrup_cost;
     syrup->decorator.base.get_description = vanilla_syrup_description;
     return (Coffee*)syrup;
 }
 
+// Compiled form: the whole chain as one flat record
+typedef struct {
+    char base_description[256];
+    double base_cost;
+    AddOnKind* addons;         // Innermost first, the order they were added
+    int addon_count;
+    int addon_capacity;
+    double total_cost;         // Always current
+    char* description;         // Built on demand, NULL when stale
+} CompiledCoffee;
+
+// Sum in the same order the decorator chain does, so the totals match exactly
+static void compiled_coffee_recompute(CompiledCoffee* compiled) {
+    double total = compiled->base_cost;
+    for (int i = 0; i < compiled->addon_count; i++) {
+        total += addon_catalogue[compiled->addons[i]].price;
+    }
+    compiled->total_cost = total;
+    free(compiled->description);
+    compiled->description = NULL;
+}
+
+void compiled_coffee_add(CompiledCoffee* compiled, AddOnKind addon) {
+    if (compiled->addon_count == compiled->addon_capacity) {
+        compiled->addon_capacity = compiled->addon_capacity ? compiled->addon_capacity * 2 : 4;
+        compiled->addons = (AddOnKind*)realloc(compiled->addons,
+                                               compiled->addon_capacity * sizeof(AddOnKind));
+    }
+    compiled->addons[compiled->addon_count++] = addon;
+    compiled->total_cost += addon_catalogue[addon].price;  // Same as one more wrapper
+    free(compiled->description);
+    compiled->description = NULL;
+}
+
+// Remove the outermost add-on of this kind; returns 0 if there is none
+int compiled_coffee_remove(CompiledCoffee* compiled, AddOnKind addon) {
+    for (int i = compiled->addon_count - 1; i >= 0; i--) {
+        if (compiled->addons[i] == addon) {
+            memmove(&compiled->addons[i], &compiled->addons[i + 1],
+                    (compiled->addon_count - i - 1) * sizeof(AddOnKind));
+            compiled->addon_count--;
+            compiled_coffee_recompute(compiled);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Flatten a decorator chain (one walk, no per-level description buffers)
+CompiledCoffee* compile_coffee(Coffee* coffee) {
+    CompiledCoffee* compiled = (CompiledCoffee*)calloc(1, sizeof(CompiledCoffee));
+    
+    // Collect add-ons outermost first, then reverse into wrapping order
+    Coffee* layer = coffee;
+    while (layer->addon != ADDON_NONE) {
+        compiled_coffee_add(compiled, layer->addon);
+        layer = ((CoffeeDecorator*)layer)->wrapped_coffee;
+    }
+    for (int i = 0, j = compiled->addon_count - 1; i < j; i++, j--) {
+        AddOnKind swap = compiled->addons[i];
+        compiled->addons[i] = compiled->addons[j];
+        compiled->addons[j] = swap;
+    }
+    
+    strcpy(compiled->base_description, layer->description);
+    compiled->base_cost = layer->get_cost(layer);
+    compiled_coffee_recompute(compiled);
+    return compiled;
+}
+
+double compiled_coffee_cost(CompiledCoffee* compiled) {
+    return compiled->total_cost;
+}
+
+const char* compiled_coffee_description(CompiledCoffee* compiled) {
+    if (compiled->description == NULL) {
+        size_t length = strlen(compiled->base_description);
+        for (int i = 0; i < compiled->addon_count; i++) {
+            length += 3 + strlen(addon_catalogue[compiled->addons[i]].name);
+        }
+        char* text = (char*)malloc(length + 1);
+        char* end = stpcpy(text, compiled->base_description);
+        for (int i = 0; i < compiled->addon_count; i++) {
+            end = stpcpy(end, " + ");
+            end = stpcpy(end, addon_catalogue[compiled->addons[i]].name);
+        }
+        compiled->description = text;
+    }
+    return compiled->description;
+}
+
+void destroy_compiled_coffee(CompiledCoffee* compiled) {
+    if (compiled) {
+        free(compiled->addons);
+        free(compiled->description);
+        free(compiled);
+    }
+}
+
+// ---- Bulk pricing (structure of arrays) ----
+
+// One column per field; bit k of addon_masks[i] means order i has add-on k
+typedef struct {
+    double* base_costs;
+    uint8_t* addon_masks;
+    double* costs;             // Filled in by price_order_batch()
+    int count;
+    int capacity;
+    const struct PricingKernel* kernel;
+} OrderBatch;
+
+const struct PricingKernel* detect_pricing_kernel(void);
+
+OrderBatch* create_order_batch(int capacity) {
+    OrderBatch* batch = (OrderBatch*)malloc(sizeof(OrderBatch));
+    batch->base_costs = (double*)malloc(capacity * sizeof(double));
+    batch->addon_masks = (uint8_t*)malloc(capacity * sizeof(uint8_t));
+    batch->costs = (double*)malloc(capacity * sizeof(double));
+    batch->count = 0;
+    batch->capacity = capacity;
+    batch->kernel = detect_pricing_kernel();
+    return batch;
+}
+
+int order_batch_add(OrderBatch* batch, double base_cost, uint8_t addon_mask) {
+    if (batch->count == batch->capacity) {
+        batch->capacity *= 2;
+        batch->base_costs = (double*)realloc(batch->base_costs, batch->capacity * sizeof(double));
+        batch->addon_masks = (uint8_t*)realloc(batch->addon_masks, batch->capacity * sizeof(uint8_t));
+        batch->costs = (double*)realloc(batch->costs, batch->capacity * sizeof(double));
+    }
+    batch->base_costs[batch->count] = base_cost;
+    batch->addon_masks[batch->count] = addon_mask;
+    return batch->count++;
+}
+
+// Mask for a compiled order, or -1 if it has an add-on twice (a mask can't say that)
+int compiled_coffee_mask(CompiledCoffee* compiled) {
+    int mask = 0;
+    for (int i = 0; i < compiled->addon_count; i++) {
+        int bit = 1 << compiled->addons[i];
+        if (mask & bit) return -1;
+        mask |= bit;
+    }
+    return mask;
+}
+
+// Every kernel adds the prices of the set bits to the base in catalogue
+// order (adding 0.0 for clear bits), so all of them give identical results
+typedef struct PricingKernel {
+    const char* name;
+    void (*price)(const double* base_costs, const uint8_t* masks, double* costs, int count);
+} PricingKernel;
+
+static void price_orders_scalar(const double* base_costs, const uint8_t* masks,
+                                double* costs, int count) {
+    for (int i = 0; i < count; i++) {
+        double cost = base_costs[i];
+        for (int k = 0; k < ADDON_COUNT; k++) {
+            cost += (masks[i] >> k & 1) ? addon_catalogue[k].price : 0.0;
+        }
+        costs[i] = cost;
+    }
+}
+
+static const PricingKernel scalar_pricing = {"scalar", price_orders_scalar};
+
+#if HAVE_X86_SIMD
+static void price_orders_sse2(const double* base_costs, const uint8_t* masks,
+                              double* costs, int count) {
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i lanes = _mm_set_epi64x(masks[i + 1], masks[i]);
+        __m128d cost = _mm_loadu_pd(base_costs + i);
+        for (int k = 0; k < ADDON_COUNT; k++) {
+            __m128i bit = _mm_set1_epi32(1 << k);
+            // Whole lane all-ones where the bit is set (masks fit in 32 bits)
+            __m128i set = _mm_cmpeq_epi32(_mm_and_si128(lanes, bit), bit);
+            set = _mm_shuffle_epi32(set, _MM_SHUFFLE(2, 2, 0, 0));
+            cost = _mm_add_pd(cost, _mm_and_pd(_mm_castsi128_pd(set), _mm_set1_pd(addon_catalogue[k].price)));
+        }
+        _mm_storeu_pd(costs + i, cost);
+    }
+    price_orders_scalar(base_costs + i, masks + i, costs + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void price_orders_avx2(const double* base_costs, const uint8_t* masks,
+                              double* costs, int count) {
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int packed;
+        memcpy(&packed, masks + i, sizeof(packed));
+        __m256i lanes = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        __m256d cost = _mm256_loadu_pd(base_costs + i);
+        for (int k = 0; k < ADDON_COUNT; k++) {
+            __m256i bit = _mm256_set1_epi64x(1 << k);
+            __m256i set = _mm256_cmpeq_epi64(_mm256_and_si256(lanes, bit), bit);
+            cost = _mm256_add_pd(cost, _mm256_and_pd(_mm256_castsi256_pd(set),
+                                                     _mm256_set1_pd(addon_catalogue[k].price)));
+        }
+        _mm256_storeu_pd(costs + i, cost);
+    }
+    price_orders_sse2(base_costs + i, masks + i, costs + i, count - i);
+}
+
+static const PricingKernel sse2_pricing = {"SSE2", price_orders_sse2};
+static const PricingKernel avx2_pricing = {"AVX2", price_orders_avx2};
+#endif
+
+#if HAVE_NEON_SIMD
+static void price_orders_neon(const double* base_costs, const uint8_t* masks,
+                              double* costs, int count) {
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        uint64x2_t lanes = vcombine_u64(vcreate_u64(masks[i]), vcreate_u64(masks[i + 1]));
+        float64x2_t cost = vld1q_f64(base_costs + i);
+        for (int k = 0; k < ADDON_COUNT; k++) {
+            uint64x2_t set = vtstq_u64(lanes, vdupq_n_u64(1u << k));
+            uint64x2_t price = vreinterpretq_u64_f64(vdupq_n_f64(addon_catalogue[k].price));
+            cost = vaddq_f64(cost, vreinterpretq_f64_u64(vandq_u64(set, price)));
+        }
+        vst1q_f64(costs + i, cost);
+    }
+    price_orders_scalar(base_costs + i, masks + i, costs + i, count - i);
+}
+
+static const PricingKernel neon_pricing = {"NEON", price_orders_neon};
+#endif
+
+#define MAX_PRICING_KERNELS 3
+
+// Every kernel this CPU can run, best last; returns the count
+int available_pricing_kernels(const PricingKernel** kernels) {
+    int count = 0;
+    kernels[count++] = &scalar_pricing;
+#if HAVE_X86_SIMD
+    kernels[count++] = &sse2_pricing;
+    if (__builtin_cpu_supports("avx2")) kernels[count++] = &avx2_pricing;
+#elif HAVE_NEON_SIMD
+    kernels[count++] = &neon_pricing;
+#endif
+    return count;
+}
+
+const PricingKernel* detect_pricing_kernel(void) {
+    const PricingKernel* kernels[MAX_PRICING_KERNELS];
+    return kernels[available_pricing_kernels(kernels) - 1];
+}
+
+// Price every order in the batch; returns the total
+double price_order_batch(OrderBatch* batch) {
+    batch->kernel->price(batch->base_costs, batch->addon_masks, batch->costs, batch->count);
+    
+    double total = 0.0;
+    for (int i = 0; i < batch->count; i++) {
+        total += batch->costs[i];
+    }
+    return total;
+}
+
+void destroy_order_batch(OrderBatch* batch) {
+    if (batch) {
+        free(batch->base_costs);
+        free(batch->addon_masks);
+        free(batch->costs);
+        free(batch);
+    }
+}
+
 // Utility function to print coffee details
 void print_coffee_order(Coffee* coffee) {
     char description[512];
@@ -209,6 +525,46 @@ int main() {
     coffee5 = add_milk(coffee5);
     print_coffee_order(coffee5);
     
+    // Order 6: compiled once, then priced as often as needed
+    printf("Order 6 (Compiled from Order 4):\n");
+    CompiledCoffee* compiled = compile_coffee(coffee4);
+    printf("Order: %s\n", compiled_coffee_description(compiled));
+    printf("Cost: $%.2f (chain says $%.2f)\n", compiled_coffee_cost(compiled), coffee4->get_cost(coffee4));
+    compiled_coffee_remove(compiled, ADDON_WHIPPED_CREAM);
+    compiled_coffee_add(compiled, ADDON_SUGAR);
+    printf("Changed: %s\n", compiled_coffee_description(compiled));
+    printf("Cost: $%.2f\n", compiled_coffee_cost(compiled));
+    printf("------------------------\n");
+    destroy_compiled_coffee(compiled);
+    
+    // Bulk: many orders priced in one pass
+    OrderBatch* batch = create_order_batch(1024);
+    printf("Bulk pricing (%s kernel):\n", batch->kernel->name);
+    CompiledCoffee* compiled3 = compile_coffee(coffee3);
+    order_batch_add(batch, compiled3->base_cost, (uint8_t)compiled_coffee_mask(compiled3));
+    destroy_compiled_coffee(compiled3);
+    unsigned seed = 42;
+    for (int i = 1; i < 100000; i++) {
+        seed = seed * 1103515245u + 12345u;
+        order_batch_add(batch, 2.00, (uint8_t)((seed >> 16) % (1 << ADDON_COUNT)));
+    }
+    double revenue = price_order_batch(batch);
+    printf("%d orders, revenue $%.2f\n", batch->count, revenue);
+    printf("First order: $%.2f (chain says $%.2f)\n", batch->costs[0], coffee3->get_cost(coffee3));
+    
+    const PricingKernel* kernels[MAX_PRICING_KERNELS];
+    int kernel_count = available_pricing_kernels(kernels);
+    double* check = (double*)malloc(batch->count * sizeof(double));
+    for (int k = 0; k < kernel_count; k++) {
+        kernels[k]->price(batch->base_costs, batch->addon_masks, check, batch->count);
+        printf("%s %s kernel matches\n",
+               memcmp(check, batch->costs, batch->count * sizeof(double)) == 0 ? "✅" : "❌",
+               kernels[k]->name);
+    }
+    free(check);
+    destroy_order_batch(batch);
+    printf("------------------------\n");
+    
     printf("Demonstrating flexibility of decorator pattern:\n");
     printf("- Can add any combination of decorators\n");
     printf("- Can add multiple instances of same decorator\n");